@@ -37,12 +37,16 @@ public:
     return file->kind() == File::Kind::ExtendedInterfaceFile;
   }
 
+  /// \brief The file and its XPI sets share one string pool, so converting
+  ///        the file to an InterfaceFile doesn't copy the names.
   ExtendedInterfaceFile()
       : InterfaceFileBase(File::Kind::ExtendedInterfaceFile),
-        _symbols(new XPISet), _undefineds(new XPISet) {}
+        _symbols(new XPISet(_stringPool)),
+        _undefineds(new XPISet(_stringPool)) {}
   ExtendedInterfaceFile(std::unique_ptr<XPISet> &&symbols)
-      : InterfaceFileBase(File::Kind::ExtendedInterfaceFile),
-        _symbols(std::move(symbols)), _undefineds(new XPISet) {}
+      : InterfaceFileBase(File::Kind::ExtendedInterfaceFile,
+                          symbols->getStringPool()),
+        _symbols(std::move(symbols)), _undefineds(new XPISet(_stringPool)) {}
 
   void addSymbol(XPIKind kind, StringRef name, ArchitectureSet archs,
                  SymbolFlags flags = SymbolFlags::None,
@@ -84,12 +88,19 @@ public:
   llvm::Expected<std::unique_ptr<ExtendedInterfaceFile>>
   merge(const ExtendedInterfaceFile *otherInterface) const;
 
+  /// \brief Merge all files into a new file. The files are verified once and
+  ///        every symbol and list entry is inserted exactly once.
+  static llvm::Expected<std::unique_ptr<ExtendedInterfaceFile>>
+  merge(ArrayRef<const ExtendedInterfaceFile *> files);
+
   void printSymbols(ArchitectureSet archs) const;
 
 private:
   void printSymbolsForArch(Architecture arch) const;
 
 protected:
+  friend class InterfaceFile;
+
   std::unique_ptr<XPISet> _symbols;
   std::unique_ptr<XPISet> _undefineds;
 };
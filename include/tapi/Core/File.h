@@ -82,6 +82,7 @@ public:
     InterfaceFileBase,
     InterfaceFile,
     ExtendedInterfaceFile,
+    InterfaceFileView,
     SDKDBFile,
   };
 
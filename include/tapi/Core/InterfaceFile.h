@@ -24,10 +24,14 @@
 #include "tapi/Core/STLExtras.h"
 #include "tapi/Core/Symbol.h"
 #include "tapi/Defines.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Error.h"
+#include <cstdint>
+#include <vector>
 
 namespace llvm {
 namespace yaml {
@@ -38,6 +42,79 @@ template <typename T> struct MappingTraits;
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
 class ExtendedInterfaceFile;
+class InterfaceFileView;
+class TextStubParser;
+
+/// \brief Columnar storage of the symbol attributes used for filtering.
+///
+/// Entry i of every column describes the i-th symbol of the owning symbol
+/// sequence. Finding the symbols of an architecture or kind only scans the
+/// contiguous architecture masks and kinds, without dereferencing a single
+/// symbol.
+class SymbolColumns {
+public:
+  using ArchMask = uint32_t;
+
+  size_t size() const { return _archs.size(); }
+  bool empty() const { return _archs.empty(); }
+
+  SymbolKind getKind(size_t index) const {
+    return static_cast<SymbolKind>(_kinds[index]);
+  }
+  ArchitectureSet getArchitectures(size_t index) const {
+    return _archs[index];
+  }
+  SymbolFlags getFlags(size_t index) const {
+    return static_cast<SymbolFlags>(_flags[index]);
+  }
+
+  /// \brief Return the first index at or after the given one whose symbol is
+  ///        available for any of the given architectures, or size() if there
+  ///        is none.
+  size_t find(size_t index, ArchMask archs) const {
+    const auto *masks = _archs.data();
+    for (size_t e = _archs.size(); index != e; ++index)
+      if (masks[index] & archs)
+        break;
+    return index;
+  }
+
+  /// \brief Return the first index at or after the given one whose symbol has
+  ///        the given kind and is available for any of the given
+  ///        architectures, or size() if there is none.
+  size_t find(size_t index, ArchMask archs, SymbolKind kind) const {
+    const auto *masks = _archs.data();
+    const auto *kinds = _kinds.data();
+    const auto rawKind = static_cast<uint8_t>(kind);
+    for (size_t e = _archs.size(); index != e; ++index)
+      if ((masks[index] & archs) && kinds[index] == rawKind)
+        break;
+    return index;
+  }
+
+private:
+  void push_back(SymbolKind kind, ArchitectureSet archs, SymbolFlags flags) {
+    _archs.push_back(archs.rawValue());
+    _kinds.push_back(static_cast<uint8_t>(kind));
+    _flags.push_back(static_cast<uint8_t>(flags));
+  }
+
+  void reserve(size_t size) {
+    _archs.reserve(size);
+    _kinds.reserve(size);
+    _flags.reserve(size);
+  }
+
+  void addArchitectures(size_t index, ArchitectureSet archs) {
+    _archs[index] |= archs.rawValue();
+  }
+
+  std::vector<ArchMask> _archs;
+  std::vector<uint8_t> _kinds;
+  std::vector<uint8_t> _flags;
+
+  friend class InterfaceFile;
+};
 
 class InterfaceFile : public InterfaceFileBase {
 public:
@@ -64,17 +141,114 @@ public:
   const_symbol_range exports() const { return _symbols; }
   const_symbol_range undefineds() const { return _undefineds; }
 
+  /// \brief Columnar views of the exports and undefineds. The indices match
+  ///        the positions in the corresponding symbol range.
+  const SymbolColumns &exportColumns() const { return _exportColumns; }
+  const SymbolColumns &undefinedColumns() const { return _undefinedColumns; }
+
+  // Custom iterator to return only the symbols that are available for any of
+  // the given architectures and optionally have the given kind. Skipping
+  // scans the symbol columns, so only the matching symbols are dereferenced.
+  class const_filtered_symbol_iterator
+      : public llvm::iterator_facade_base<
+            const_filtered_symbol_iterator, std::forward_iterator_tag,
+            const Symbol *, ptrdiff_t, const Symbol *, const Symbol *> {
+  public:
+    const_filtered_symbol_iterator() = default;
+    const_filtered_symbol_iterator(const SymbolSeq &symbols,
+                                   const SymbolColumns &columns, size_t index,
+                                   ArchitectureSet archs,
+                                   llvm::Optional<SymbolKind> kind)
+        : _symbols(symbols.data()), _columns(&columns), _index(index),
+          _archs(archs.rawValue()), _kind(kind) {
+      skip();
+    }
+
+    const Symbol *operator*() const { return _symbols[_index]; }
+    const Symbol *operator->() const { return _symbols[_index]; }
+
+    bool operator==(const const_filtered_symbol_iterator &other) const {
+      return _index == other._index;
+    }
+
+    const_filtered_symbol_iterator &operator++() {
+      ++_index;
+      skip();
+      return *this;
+    }
+
+    /// \brief The position of the current symbol in the symbol sequence.
+    size_t getIndex() const { return _index; }
+
+    /// \brief The attributes of the current symbol, read from the columns.
+    SymbolKind getKind() const { return _columns->getKind(_index); }
+    ArchitectureSet getArchitectures() const {
+      return _columns->getArchitectures(_index);
+    }
+    SymbolFlags getFlags() const { return _columns->getFlags(_index); }
+
+  private:
+    void skip() {
+      _index = _kind ? _columns->find(_index, _archs, *_kind)
+                     : _columns->find(_index, _archs);
+    }
+
+    const Symbol *const *_symbols = nullptr;
+    const SymbolColumns *_columns = nullptr;
+    size_t _index = 0;
+    SymbolColumns::ArchMask _archs = 0;
+    llvm::Optional<SymbolKind> _kind;
+  };
+  using const_filtered_symbol_range =
+      llvm::iterator_range<const_filtered_symbol_iterator>;
+
+  /// \brief The exports that are available for any of the given
+  ///        architectures. The range is filtered lazily and doesn't allocate.
+  const_filtered_symbol_range exports(ArchitectureSet archs) const {
+    return filter(_symbols, _exportColumns, archs, llvm::None);
+  }
+
+  /// \brief The exports of the given kind that are available for any of the
+  ///        given architectures.
+  const_filtered_symbol_range exports(ArchitectureSet archs,
+                                      SymbolKind kind) const {
+    return filter(_symbols, _exportColumns, archs, kind);
+  }
+
+  /// \brief The undefineds that are available for any of the given
+  ///        architectures. The range is filtered lazily and doesn't allocate.
+  const_filtered_symbol_range undefineds(ArchitectureSet archs) const {
+    return filter(_undefineds, _undefinedColumns, archs, llvm::None);
+  }
+
+  /// \brief The architectures of the symbol. This is the same as the
+  ///        architectures of the symbol itself.
+  ArchitectureSet getSymbolArchitectures(const Symbol *symbol) const {
+    return symbol->getArchitectures();
+  }
+
   bool convertTo(FileType fileType, StringRef path = {});
   bool contains(SymbolKind kind, StringRef name,
                 Symbol const **result = nullptr) const;
 
+  /// \brief Return a read-only view of the given architecture slice. The view
+  ///        references the storage of this file and doesn't copy symbols.
+  llvm::Expected<InterfaceFileView> getView(Architecture arch) const;
+
+  /// \brief Create a new file that only contains the given architecture.
   llvm::Expected<std::unique_ptr<InterfaceFile>>
   extract(Architecture arch) const;
   llvm::Expected<std::unique_ptr<InterfaceFile>>
   merge(const InterfaceFile *otherInterface) const;
+
+  /// \brief Merge all files into a new file. The files are verified once and
+  ///        every symbol and list entry is inserted exactly once.
+  static llvm::Expected<std::unique_ptr<InterfaceFile>>
+  merge(ArrayRef<const InterfaceFile *> files);
   void printSymbols(ArchitectureSet archs) const;
 
 private:
+  void reserveSymbols(size_t numSymbols, size_t numUndefineds);
   void addSymbolImpl(SymbolKind kind, StringRef name, ArchitectureSet archs,
                      SymbolFlags flags, bool copyStrings = true);
   void addUndefinedSymbolImpl(SymbolKind kind, StringRef name,
@@ -82,21 +256,111 @@ private:
                               bool copyStrings = true);
   void printSymbolsForArch(Architecture arch) const;
 
+  static const_filtered_symbol_range
+  filter(const SymbolSeq &symbols, const SymbolColumns &columns,
+         ArchitectureSet archs, llvm::Optional<SymbolKind> kind) {
+    return {const_filtered_symbol_iterator(symbols, columns, 0, archs, kind),
+            const_filtered_symbol_iterator(symbols, columns, symbols.size(),
+                                           archs, kind)};
+  }
+
+  /// \brief Symbols are identified by their kind and name. The index maps
+  ///        to the position in the symbol sequence.
+  using SymbolKey = std::pair<unsigned, StringRef>;
+  using SymbolIndex = llvm::DenseMap<SymbolKey, uint32_t>;
+
+  static SymbolKey getSymbolKey(SymbolKind kind, StringRef name) {
+    return {static_cast<unsigned>(kind), name};
+  }
+
 protected:
   StringRef copyString(StringRef string) {
-    if (string.empty())
-      return {};
-
-    void *ptr = allocator.Allocate(string.size(), 1);
-    memcpy(ptr, string.data(), string.size());
-    return {reinterpret_cast<const char *>(ptr), string.size()};
+    return _stringPool->intern(string);
   }
 
   llvm::BumpPtrAllocator allocator;
   SymbolSeq _symbols;
   SymbolSeq _undefineds;
+  SymbolColumns _exportColumns;
+  SymbolColumns _undefinedColumns;
+
+  /// \brief Hash indices into the symbol sequences. The keys reference the
+  ///        symbol names, so the indices don't allocate per symbol.
+  SymbolIndex _symbolIndex;
+  SymbolIndex _undefinedIndex;
 
   friend struct llvm::yaml::MappingTraits<const InterfaceFile *>;
+  friend class InterfaceFileView;
+  friend class TextStubParser;
+};
+
+/// \brief A read-only single architecture slice of an interface file.
+///
+/// The view filters the symbols of the parent file by architecture on the fly
+/// through the symbol columns and otherwise references the storage of the
+/// parent file, which has to outlive the view. Views can be written by the
+/// text-based stub writers just like an interface file. Use materialize()
+/// when an owning interface file is needed.
+class InterfaceFileView : public File {
+public:
+  static bool classof(const File *file) {
+    return file->kind() == File::Kind::InterfaceFileView;
+  }
+
+  InterfaceFileView(const InterfaceFile &parent, Architecture arch);
+
+  const InterfaceFile &getParent() const { return *_parent; }
+  Architecture getArch() const { return _arch; }
+
+  Platform getPlatform() const { return _parent->getPlatform(); }
+  ArchitectureSet getArchitectures() const { return _arch; }
+  StringRef getInstallName() const { return _parent->getInstallName(); }
+  PackedVersion getCurrentVersion() const {
+    return _parent->getCurrentVersion();
+  }
+  PackedVersion getCompatibilityVersion() const {
+    return _parent->getCompatibilityVersion();
+  }
+  uint8_t getSwiftABIVersion() const { return _parent->getSwiftABIVersion(); }
+  bool isTwoLevelNamespace() const { return _parent->isTwoLevelNamespace(); }
+  bool isApplicationExtensionSafe() const {
+    return _parent->isApplicationExtensionSafe();
+  }
+  ObjCConstraint getObjCConstraint() const {
+    return _parent->getObjCConstraint();
+  }
+  bool isInstallAPI() const { return _parent->isInstallAPI(); }
+  StringRef getParentUmbrella() const { return _parent->getParentUmbrella(); }
+
+  const std::vector<InterfaceFileRef> &allowableClients() const {
+    return _allowableClients;
+  }
+  const std::vector<InterfaceFileRef> &reexportedLibraries() const {
+    return _reexportedLibraries;
+  }
+  const std::vector<std::pair<Architecture, std::string>> &uuids() const {
+    return _uuids;
+  }
+
+  using const_symbol_range = InterfaceFile::const_filtered_symbol_range;
+
+  const_symbol_range exports() const { return _parent->exports(_arch); }
+  const_symbol_range undefineds() const { return _parent->undefineds(_arch); }
+
+  /// \brief The architectures of the symbol as seen through this view.
+  ArchitectureSet getSymbolArchitectures(const Symbol *symbol) const {
+    return symbol->getArchitectures() & ArchitectureSet(_arch);
+  }
+
+  /// \brief Copy the slice into a new owning interface file.
+  std::unique_ptr<InterfaceFile> materialize() const;
+
+private:
+  const InterfaceFile *_parent;
+  Architecture _arch;
+  std::vector<InterfaceFileRef> _allowableClients;
+  std::vector<InterfaceFileRef> _reexportedLibraries;
+  std::vector<std::pair<Architecture, std::string>> _uuids;
 };
 
 TAPI_NAMESPACE_INTERNAL_END
@@ -20,9 +20,13 @@
 #include "tapi/Core/ArchitectureSupport.h"
 #include "tapi/Core/File.h"
 #include "tapi/Core/STLExtras.h"
+#include "tapi/Core/StringPool.h"
 #include "tapi/Defines.h"
 #include "tapi/LinkerInterfaceFile.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include <memory>
 
 namespace llvm {
 namespace yaml {
@@ -60,12 +64,38 @@ public:
   }
 
 private:
-  std::string _installName;
+  /// \brief The install name is not owned by the reference. It is interned
+  ///        into the string pool of the file or snapshot that holds the
+  ///        reference, or references the command line arguments.
+  StringRef _installName;
   ArchitectureSet _architectures;
 
   template <typename T> friend struct llvm::yaml::MappingTraits;
 };
 
+/// \brief The error returned when a file can't be merged with the first file
+///        of a merge. It records the position of the offending file, so the
+///        caller can report the error against that input.
+class MergeError : public llvm::ErrorInfo<MergeError> {
+public:
+  static char ID;
+
+  MergeError(size_t index, StringRef message)
+      : _index(index), _message(message) {}
+
+  size_t getIndex() const { return _index; }
+  StringRef getMessage() const { return _message; }
+
+  void log(raw_ostream &os) const override { os << _message; }
+  std::error_code convertToErrorCode() const override {
+    return llvm::inconvertibleErrorCode();
+  }
+
+private:
+  size_t _index;
+  std::string _message;
+};
+
 class InterfaceFileBase : public File {
 public:
   static bool classof(const File *file) {
@@ -82,7 +112,9 @@ public:
   ArchitectureSet getArchitectures() const { return _architectures; }
   void clearArchitectures() { _architectures = Architecture::unknown; }
 
-  void setInstallName(StringRef installName) { _installName = installName; }
+  void setInstallName(StringRef installName) {
+    _installName = _stringPool->intern(installName);
+  }
   StringRef getInstallName() const { return _installName; }
 
   void setCurrentVersion(PackedVersion version) { _currentVersion = version; }
@@ -112,7 +144,9 @@ public:
   void setInstallAPI(bool v = true) { _isInstallAPI = v; }
   bool isInstallAPI() const { return _isInstallAPI; }
 
-  void setParentUmbrella(StringRef parent) { _parentUmbrella = parent; }
+  void setParentUmbrella(StringRef parent) {
+    _parentUmbrella = _stringPool->intern(parent);
+  }
   StringRef getParentUmbrella() const { return _parentUmbrella; }
 
   void addAllowableClient(StringRef installName, ArchitectureSet archs);
@@ -134,12 +168,32 @@ public:
   void clearUUIDs() { _uuids.clear(); }
 
 protected:
-  InterfaceFileBase(File::Kind kind) : File(kind) {}
+  InterfaceFileBase(File::Kind kind)
+      : File(kind), _stringPool(std::make_shared<StringPool>()) {}
+  InterfaceFileBase(File::Kind kind, std::shared_ptr<StringPool> stringPool)
+      : File(kind), _stringPool(std::move(stringPool)) {}
   InterfaceFileBase(InterfaceFileBase &&) = default;
 
+  /// \brief Verify that the files agree on all header fields and don't share
+  ///        any architecture. Returns a MergeError with the index of the first
+  ///        file that doesn't match.
+  static llvm::Error
+  verifyMergeable(ArrayRef<const InterfaceFileBase *> files);
+
+  /// \brief Take the header of the first file and the union of the
+  ///        architectures, allowable clients, re-exported libraries, and UUIDs
+  ///        of all files.
+  ///
+  /// The lists are kept sorted, so they are combined with a single k-way
+  /// merge instead of inserting one element at a time.
+  void mergeHeaders(ArrayRef<const InterfaceFileBase *> files);
+
+  /// \brief Owns the names of this file. The pool is shared with the XPI sets
+  ///        the file was built from, so their names are stored once.
+  std::shared_ptr<StringPool> _stringPool;
   Platform _platform = Platform::Unknown;
   ArchitectureSet _architectures;
-  std::string _installName;
+  StringRef _installName;
   PackedVersion _currentVersion;
   PackedVersion _compatibilityVersion;
   uint8_t _swiftABIVersion = 0;
@@ -147,7 +201,7 @@ protected:
   bool _isAppExtensionSafe = false;
   bool _isInstallAPI = false;
   ObjCConstraint _objcConstraint = ObjCConstraint::None;
-  std::string _parentUmbrella;
+  StringRef _parentUmbrella;
   std::vector<InterfaceFileRef> _allowableClients;
   std::vector<InterfaceFileRef> _reexportedLibraries;
   std::vector<std::pair<Architecture, std::string>> _uuids;
@@ -15,6 +15,7 @@
 #ifndef TAPI_CORE_MACHO_DYLIB_READER_H
 #define TAPI_CORE_MACHO_DYLIB_READER_H
 
+#include "tapi/Core/Architecture.h"
 #include "tapi/Core/ArchitectureSet.h"
 #include "tapi/Core/File.h"
 #include "tapi/Core/LLVM.h"
@@ -23,6 +24,9 @@
 #include "llvm/BinaryFormat/Magic.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <string>
+#include <utility>
+#include <vector>
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
@@ -37,6 +41,15 @@ public:
            ArchitectureSet arches) const override;
 };
 
+/// \brief Read the UUIDs of a Mach-O dynamic library.
+///
+/// Only the fat header and the load commands of each dynamic library slice are
+/// read. The symbol tables and the other segments are never touched, which
+/// makes the cost independent of the number of symbols. The UUIDs are sorted
+/// by architecture and formatted the same way as by the dylib reader.
+Expected<std::vector<std::pair<Architecture, std::string>>>
+readMachOUUIDs(MemoryBufferRef bufferRef);
+
 TAPI_NAMESPACE_INTERNAL_END
 
 #endif // TAPI_CORE_MACHO_DYLIB_READER_H
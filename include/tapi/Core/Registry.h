@@ -83,8 +83,8 @@ public:
   }
 
   void addBinaryReaders();
-  void addYAMLReaders();
-  void addYAMLWriters();
+  void addYAMLReaders(bool useTextStubReader = true);
+  void addYAMLWriters(bool useTextStubWriter = true);
   void addReexportWriters();
 
 private:
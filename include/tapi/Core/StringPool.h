@@ -0,0 +1,53 @@
+//===- tapi/Core/StringPool.h - String Pool ---------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the string pool that owns the names of the XPI sets,
+///        interface files, and SDKDB files.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_CORE_STRING_POOL_H
+#define TAPI_CORE_STRING_POOL_H
+
+#include "tapi/Core/LLVM.h"
+#include "tapi/Defines.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief An arena of uniqued strings.
+///
+/// Every owner creates its own pool and hands it explicitly to the structures
+/// that are built from it, such as the XPI sets of an extended interface file
+/// and the interface file converted from it. The strings are released with
+/// the last of these owners. The pool is not thread-safe.
+class StringPool {
+public:
+  StringPool() = default;
+  StringPool(const StringPool &) = delete;
+  StringPool &operator=(const StringPool &) = delete;
+
+  /// \brief Return the pooled copy of the string. The copy stays valid as
+  ///        long as the pool is alive.
+  StringRef intern(StringRef string);
+
+  /// \brief The number of distinct strings in the pool.
+  size_t size() const;
+
+private:
+  llvm::BumpPtrAllocator _allocator;
+  llvm::DenseSet<StringRef> _strings;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_CORE_STRING_POOL_H
@@ -0,0 +1,62 @@
+//===- tapi/Core/TextStubReader.h - Text Stub Reader ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the fast reader for text-based stub files.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_CORE_TEXT_STUB_READER_H
+#define TAPI_CORE_TEXT_STUB_READER_H
+
+#include "tapi/Core/ArchitectureSet.h"
+#include "tapi/Core/File.h"
+#include "tapi/Core/LLVM.h"
+#include "tapi/Core/Registry.h"
+#include "tapi/Defines.h"
+#include "llvm/BinaryFormat/Magic.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief Classify a text-based stub file by its document markers only.
+///
+/// This only inspects the document start tag and the document end marker and
+/// never allocates memory. Returns FileType::Invalid if the buffer is not a
+/// text-based stub file.
+FileType getTextStubFileType(StringRef buffer);
+
+/// \brief Reads text-based stub files (TBD v1, v2, and v3) without building a
+///        YAML document tree first.
+///
+/// The reader only understands the restricted subset of YAML that is produced
+/// by the text-based stub writers. Everything else (comments in odd places,
+/// escape sequences, block sequences, unknown keys, invalid values, ...) is
+/// handed to the fallback reader, which also takes care of reporting proper
+/// diagnostics.
+class TextStubReader final : public Reader {
+public:
+  explicit TextStubReader(const Reader &fallback) : _fallback(fallback) {}
+
+  bool canRead(file_magic magic, MemoryBufferRef bufferRef,
+               FileType types) const override;
+  Expected<FileType> getFileType(file_magic magic,
+                                 MemoryBufferRef bufferRef) const override;
+  Expected<std::unique_ptr<File>>
+  readFile(std::unique_ptr<MemoryBuffer> memBuffer, ReadFlags readFlags,
+           ArchitectureSet arches) const override;
+
+private:
+  const Reader &_fallback;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_CORE_TEXT_STUB_READER_H
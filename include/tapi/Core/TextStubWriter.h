@@ -0,0 +1,47 @@
+//===- tapi/Core/TextStubWriter.h - Text Stub Writer ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the streaming writer for text-based stub and API files.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_CORE_TEXT_STUB_WRITER_H
+#define TAPI_CORE_TEXT_STUB_WRITER_H
+
+#include "tapi/Core/File.h"
+#include "tapi/Core/LLVM.h"
+#include "tapi/Core/Registry.h"
+#include "tapi/Core/YAMLReaderWriter.h"
+#include "tapi/Defines.h"
+#include "llvm/Support/Error.h"
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief Writes text-based stub files (TBD v1, v2, and v3) and API/SPI files
+///        directly to the output stream.
+///
+/// The writer uses the document handlers of the generic YAML writer to emit
+/// the documents with a streaming emitter instead of llvm::yaml::Output. The
+/// output is byte-identical. Files that no handler can emit are written by the
+/// generic YAML writer.
+class TextStubWriter final : public Writer {
+public:
+  explicit TextStubWriter(const YAMLWriter &fallback) : _fallback(fallback) {}
+
+  bool canWrite(const File *file) const override;
+  Error writeFile(raw_ostream &os, const File *file) const override;
+
+private:
+  const YAMLWriter &_fallback;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_CORE_TEXT_STUB_WRITER_H
@@ -38,6 +38,7 @@ class YAMLDocumentHandler : public DocumentHandler {
   FileType getFileType(MemoryBufferRef memBufferRef) const override;
   bool canWrite(const File *file) const override;
   bool handleDocument(llvm::yaml::IO &io, const File *&file) const override;
+  bool emitDocument(YAMLEmitter &emitter, const File *file) const override;
 };
 
 } // end namespace v2.
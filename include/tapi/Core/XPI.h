@@ -23,6 +23,7 @@
 #include "tapi/Defines.h"
 #include "tapi/Symbol.h"
 #include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
@@ -131,40 +132,19 @@ public:
 
   void addAvailabilityInfo(Architecture arch,
                            const AvailabilityInfo info = AvailabilityInfo(),
-                           bool NoOverwrite = false) {
-    auto it =
-        find_if(_availability,
-                [arch](const std::pair<Architecture, AvailabilityInfo> &avail) {
-                  return arch == avail.first;
-                });
-    if (it != _availability.end()) {
-      if (NoOverwrite && !it->second.isDefault()) {
-        it->second = info;
-        assert(info == it->second && "Availability information is not equal");
-      }
-      return;
-    }
-    _availability.emplace_back(arch, info);
-    if (!info._unavailable)
-      _archs.set(arch);
-  }
+                           bool NoOverwrite = false);
 
-  const llvm::SmallVectorImpl<std::pair<Architecture, AvailabilityInfo>> &
-  getAvailabilityInfo() const {
-    return _availability;
+  /// \brief The distinct availability records of all architectures.
+  ArrayRef<AvailabilityInfo> availabilityInfos() const {
+    return _availabilityInfos;
   }
 
   llvm::Optional<AvailabilityInfo>
   getAvailabilityInfo(Architecture arch) const {
-    auto it =
-        find_if(_availability,
-                [arch](const std::pair<Architecture, AvailabilityInfo> &avail) {
-                  return arch == avail.first;
-                });
-    if (it != _availability.end())
-      return it->second;
-
-    return llvm::None;
+    if (!_availabilityArchs.has(arch))
+      return llvm::None;
+
+    return _availabilityInfos[_availabilitySlots[static_cast<size_t>(arch)]];
   }
 
   ArchitectureSet getArchitectures() const { return _archs; }
@@ -182,8 +162,17 @@ public:
   }
 
 private:
-  llvm::SmallVector<std::pair<Architecture, AvailabilityInfo>, 4>
-      _availability{};
+  uint8_t getAvailabilityIndex(const AvailabilityInfo &info);
+
+  static constexpr size_t NumArchitectures =
+      static_cast<size_t>(Architecture::unknown);
+
+  /// \brief The availability is stored as one slot per architecture, which
+  ///        indexes the distinct availability records. Usually all
+  ///        architectures share a single record.
+  llvm::SmallVector<AvailabilityInfo, 1> _availabilityInfos{};
+  uint8_t _availabilitySlots[NumArchitectures]{};
+  ArchitectureSet _availabilityArchs{};
   StringRef _name;
   ArchitectureSet _archs{};
 
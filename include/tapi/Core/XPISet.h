@@ -19,9 +19,11 @@
 #include "tapi/Core/ArchitectureSet.h"
 #include "tapi/Core/AvailabilityInfo.h"
 #include "tapi/Core/STLExtras.h"
+#include "tapi/Core/StringPool.h"
 #include "tapi/Core/XPI.h"
 #include "tapi/Defines.h"
 #include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
@@ -29,8 +31,9 @@
 #include "llvm/ADT/iterator.h"
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Support/Allocator.h"
+#include <memory>
 #include <stddef.h>
-#include <unordered_map>
+#include <vector>
 
 namespace clang {
 class PresumedLoc;
@@ -41,14 +44,10 @@ TAPI_NAMESPACE_INTERNAL_BEGIN
 class XPISet {
 private:
   llvm::BumpPtrAllocator allocator;
+  std::shared_ptr<StringPool> _stringPool;
 
   StringRef copyString(StringRef string) {
-    if (string.empty())
-      return {};
-
-    void *ptr = allocator.Allocate(string.size(), 1);
-    memcpy(ptr, string.data(), string.size());
-    return StringRef(reinterpret_cast<const char *>(ptr), string.size());
+    return _stringPool->intern(string);
   }
 
 public:
@@ -59,15 +58,29 @@ public:
     SymbolsMapKey(XPIKind kind, StringRef name) : kind(kind), name(name) {}
   };
 
-  struct SymbolsMapKeyHash {
-    std::size_t operator()(const SymbolsMapKey &key) const {
+  /// \brief Names in the keys of the set reference the pooled copies. Keys
+  ///        that were built from the same copy are equal by pointer, so the
+  ///        string comparison is only a fallback for outside keys.
+  static bool isEqualName(StringRef lhs, StringRef rhs) {
+    if (lhs.data() == rhs.data())
+      return lhs.size() == rhs.size();
+    return llvm::DenseMapInfo<StringRef>::isEqual(lhs, rhs);
+  }
+
+  struct SymbolsMapKeyInfo {
+    static inline SymbolsMapKey getEmptyKey() {
+      return {XPIKind::GlobalSymbol,
+              llvm::DenseMapInfo<StringRef>::getEmptyKey()};
+    }
+    static inline SymbolsMapKey getTombstoneKey() {
+      return {XPIKind::GlobalSymbol,
+              llvm::DenseMapInfo<StringRef>::getTombstoneKey()};
+    }
+    static unsigned getHashValue(const SymbolsMapKey &key) {
       return llvm::hash_combine(key.kind, key.name);
     }
-  };
-
-  struct SymbolsMapKeyEqual {
-    bool operator()(const SymbolsMapKey &lhs, const SymbolsMapKey &rhs) const {
-      return std::tie(lhs.kind, lhs.name) == std::tie(rhs.kind, rhs.name);
+    static bool isEqual(const SymbolsMapKey &lhs, const SymbolsMapKey &rhs) {
+      return lhs.kind == rhs.kind && isEqualName(lhs.name, rhs.name);
     }
   };
 
@@ -90,17 +103,22 @@ public:
     }
   };
 
-  struct SelectorsMapKeyHash {
-    std::size_t operator()(const SelectorsMapKey &key) const {
+  struct SelectorsMapKeyInfo {
+    static inline SelectorsMapKey getEmptyKey() {
+      return {llvm::DenseMapInfo<StringRef>::getEmptyKey(), {}, false, false};
+    }
+    static inline SelectorsMapKey getTombstoneKey() {
+      return {llvm::DenseMapInfo<StringRef>::getTombstoneKey(), {}, false,
+              false};
+    }
+    static unsigned getHashValue(const SelectorsMapKey &key) {
       return llvm::hash_combine(key.containerName, key.selectorName, key.raw);
     }
-  };
-
-  struct SelectorsMapKeyEqual {
-    bool operator()(const SelectorsMapKey &lhs,
-                    const SelectorsMapKey &rhs) const {
-      return std::tie(lhs.containerName, lhs.selectorName, lhs.raw) ==
-             std::tie(rhs.containerName, rhs.selectorName, rhs.raw);
+    static bool isEqual(const SelectorsMapKey &lhs,
+                        const SelectorsMapKey &rhs) {
+      return lhs.raw == rhs.raw &&
+             isEqualName(lhs.containerName, rhs.containerName) &&
+             isEqualName(lhs.selectorName, rhs.selectorName);
     }
   };
 
@@ -112,50 +130,110 @@ public:
         : containerName(containerName), categoryName(categoryName) {}
   };
 
-  struct CategoriesMapKeyHash {
-    std::size_t operator()(const CategoriesMapKey &key) const {
-      return llvm::hash_combine(key.containerName, key.categoryName);
+  struct CategoriesMapKeyInfo {
+    static inline CategoriesMapKey getEmptyKey() {
+      return {llvm::DenseMapInfo<StringRef>::getEmptyKey(), {}};
     }
-  };
-
-  struct CategoriesMapKeyEqual {
-    bool operator()(const CategoriesMapKey &lhs,
-                    const CategoriesMapKey &rhs) const {
-      return std::tie(lhs.containerName, lhs.categoryName) ==
-             std::tie(rhs.containerName, rhs.categoryName);
+    static inline CategoriesMapKey getTombstoneKey() {
+      return {llvm::DenseMapInfo<StringRef>::getTombstoneKey(), {}};
     }
-  };
-
-  struct ProtocolsMapKeyHash {
-    std::size_t operator()(const StringRef &key) const {
-      return llvm::hash_value(key);
+    static unsigned getHashValue(const CategoriesMapKey &key) {
+      return llvm::hash_combine(key.containerName, key.categoryName);
+    }
+    static bool isEqual(const CategoriesMapKey &lhs,
+                        const CategoriesMapKey &rhs) {
+      return isEqualName(lhs.containerName, rhs.containerName) &&
+             isEqualName(lhs.categoryName, rhs.categoryName);
     }
   };
 
-  struct ProtocolsMapKeyEqual {
-    bool operator()(const StringRef &lhs, const StringRef &rhs) const {
-      return lhs == rhs;
+  struct ProtocolsMapKeyInfo : llvm::DenseMapInfo<StringRef> {
+    static bool isEqual(StringRef lhs, StringRef rhs) {
+      return isEqualName(lhs, rhs);
     }
   };
 
   using SymbolsMapType =
-      std::unordered_map<SymbolsMapKey, XPI *, SymbolsMapKeyHash,
-                         SymbolsMapKeyEqual>;
+      llvm::DenseMap<SymbolsMapKey, XPI *, SymbolsMapKeyInfo>;
   using SelectorsMapType =
-      std::unordered_map<SelectorsMapKey, ObjCSelector *, SelectorsMapKeyHash,
-                         SelectorsMapKeyEqual>;
+      llvm::DenseMap<SelectorsMapKey, ObjCSelector *, SelectorsMapKeyInfo>;
   using CategoriesMapType =
-      std::unordered_map<CategoriesMapKey, ObjCCategory *, CategoriesMapKeyHash,
-                         CategoriesMapKeyEqual>;
+      llvm::DenseMap<CategoriesMapKey, ObjCCategory *, CategoriesMapKeyInfo>;
   using ProtocolsMapType =
-      std::unordered_map<StringRef, ObjCProtocol *, ProtocolsMapKeyHash>;
+      llvm::DenseMap<StringRef, ObjCProtocol *, ProtocolsMapKeyInfo>;
   SymbolsMapType _symbols;
   SelectorsMapType _selectors;
   CategoriesMapType _categories;
   ProtocolsMapType _protocols;
 
+private:
+  /// \brief The symbols ordered by kind and name. New symbols are appended
+  ///        unordered and merged into the ordered prefix on the next
+  ///        iteration, so the set is never re-sorted as a whole.
+  mutable std::vector<const XPI *> _orderedSymbols;
+  mutable size_t _numOrderedSymbols = 0;
+
+  void insertSymbol(SymbolsMapKey key, XPI *xpi) {
+    _symbols.insert({key, xpi});
+    _orderedSymbols.emplace_back(xpi);
+  }
+  void orderSymbols() const;
+
+  /// \brief An insertion that was recorded by a journaled set. The XPIs are
+  ///        owned by the journaled set and the name is taken from the XPI.
+  struct Insertion {
+    XPI *xpi;
+    XPI *parent;
+    ArchitectureSet archs;
+    AvailabilityInfo info;
+    XPIAccess access;
+    SymbolFlags flags;
+    bool isDynamic;
+    bool isDeclaration;
+  };
+
+  bool _isJournaled = false;
+  std::vector<Insertion> _journal;
+
+  void journal(XPI *xpi, XPI *parent, XPIAccess access, Architecture arch,
+               const AvailabilityInfo &info,
+               SymbolFlags flags = SymbolFlags::None, bool isDynamic = false) {
+    if (_isJournaled)
+      _journal.push_back({xpi, parent, arch, info, access, flags, isDynamic,
+                          /*isDeclaration=*/true});
+  }
+  void journal(XPI *xpi, XPI *parent, XPIAccess access, ArchitectureSet archs,
+               SymbolFlags flags = SymbolFlags::None, bool isDynamic = false) {
+    if (_isJournaled)
+      _journal.push_back({xpi, parent, archs, AvailabilityInfo(), access,
+                          flags, isDynamic, /*isDeclaration=*/false});
+  }
+
 public:
-  XPISet() = default;
+  XPISet() : _stringPool(std::make_shared<StringPool>()) {}
+
+  /// \brief Create a set that interns its names into \p stringPool, so the
+  ///        names can be shared with the other users of the pool.
+  explicit XPISet(std::shared_ptr<StringPool> stringPool)
+      : _stringPool(std::move(stringPool)) {}
+
+  /// \brief Create a set that also records every insertion in order. A
+  ///        journaled set can be filled independently (e.g. on another
+  ///        thread) and merged into a shared set afterwards.
+  explicit XPISet(bool isJournaled)
+      : _stringPool(std::make_shared<StringPool>()),
+        _isJournaled(isJournaled) {}
+
+  /// \brief Replay all insertions of the journaled set \p other into this
+  ///        set. Merging the journaled sets in the same order as the
+  ///        insertions would have been performed on this set yields the
+  ///        exact same set.
+  void merge(const XPISet &other);
+
+  /// \brief The pool that owns the names of all XPIs in this set.
+  const std::shared_ptr<StringPool> &getStringPool() const {
+    return _stringPool;
+  }
 
   GlobalSymbol *addGlobalSymbol(StringRef name, clang::PresumedLoc loc,
                                 XPIAccess access, Architecture arch,
@@ -212,17 +290,17 @@ public:
 
   struct const_symbol_iterator
       : public llvm::iterator_adaptor_base<
-            const_symbol_iterator, SymbolsMapType::const_iterator,
-            std::forward_iterator_tag, const XPI *, ptrdiff_t, const XPI *,
-            const XPI *> {
+            const_symbol_iterator, std::vector<const XPI *>::const_iterator,
+            std::random_access_iterator_tag, const XPI *, ptrdiff_t,
+            const XPI *, const XPI *> {
     const_symbol_iterator() = default;
 
     template <typename U>
     const_symbol_iterator(U &&u)
         : iterator_adaptor_base(std::forward<U &&>(u)) {}
 
-    reference operator*() const { return I->second; }
-    pointer operator->() const { return I->second; }
+    reference operator*() const { return *I; }
+    pointer operator->() const { return *I; }
   };
   using const_symbol_range = llvm::iterator_range<const_symbol_iterator>;
 
@@ -259,13 +337,19 @@ public:
   };
   using const_export_range = llvm::iterator_range<const_export_iterator>;
 
+  /// \brief Iterate the symbols ordered by kind and name. The order is
+  ///        established lazily after insertions, so the first iteration
+  ///        after an insertion must not race with other readers.
   const_symbol_range symbols() const {
-    return {_symbols.begin(), _symbols.end()};
+    orderSymbols();
+    return {_orderedSymbols.cbegin(), _orderedSymbols.cend()};
   }
 
   const_export_range exports() const {
-    return {const_export_iterator(_symbols.begin(), _symbols.end()),
-            const_export_iterator(_symbols.end(), _symbols.end())};
+    orderSymbols();
+    const_symbol_iterator begin = _orderedSymbols.cbegin();
+    const_symbol_iterator end = _orderedSymbols.cend();
+    return {const_export_iterator(begin, end), const_export_iterator(end, end)};
   }
 
   using const_selector_range =
@@ -18,16 +18,55 @@
 #include "tapi/Core/Architecture.h"
 #include "tapi/Core/ArchitectureSet.h"
 #include "tapi/Core/ArchitectureSupport.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "tapi/Core/AvailabilityInfo.h"
+#include <algorithm>
 
 using UUID = std::pair<TAPI_INTERNAL::Architecture, std::string>;
 
 LLVM_YAML_STRONG_TYPEDEF(llvm::StringRef, FlowStringRef)
 LLVM_YAML_STRONG_TYPEDEF(uint8_t, SwiftVersion)
+
+/// \brief A string in a flow sequence that is written as the prefix followed
+///        by the value, without building the concatenated string first.
+///        Reading only sets the value.
+struct PrefixedFlowStringRef {
+  PrefixedFlowStringRef() = default;
+  PrefixedFlowStringRef(llvm::StringRef value) : value(value) {}
+  PrefixedFlowStringRef(llvm::StringRef prefix, llvm::StringRef value)
+      : prefix(prefix), value(value) {}
+
+  size_t size() const { return prefix.size() + value.size(); }
+  char operator[](size_t index) const {
+    return index < prefix.size() ? prefix[index]
+                                 : value[index - prefix.size()];
+  }
+
+  llvm::StringRef prefix;
+  llvm::StringRef value;
+};
+
+/// \brief Order by the concatenated string, like the StringRef comparison.
+inline bool operator<(const PrefixedFlowStringRef &lhs,
+                      const PrefixedFlowStringRef &rhs) {
+  if (lhs.prefix == rhs.prefix)
+    return lhs.value < rhs.value;
+
+  for (size_t i = 0, e = std::min(lhs.size(), rhs.size()); i != e; ++i) {
+    auto l = static_cast<unsigned char>(lhs[i]);
+    auto r = static_cast<unsigned char>(rhs[i]);
+    if (l != r)
+      return l < r;
+  }
+  return lhs.size() < rhs.size();
+}
+
 LLVM_YAML_IS_FLOW_SEQUENCE_VECTOR(UUID)
 LLVM_YAML_IS_FLOW_SEQUENCE_VECTOR(FlowStringRef)
+LLVM_YAML_IS_FLOW_SEQUENCE_VECTOR(PrefixedFlowStringRef)
 
 namespace llvm {
 namespace yaml {
@@ -43,28 +82,72 @@ template <> struct ScalarTraits<FlowStringRef> {
   static bool mustQuote(StringRef name) { return Impl::mustQuote(name); }
 };
 
+template <> struct ScalarTraits<PrefixedFlowStringRef> {
+  using Impl = ScalarTraits<StringRef>;
+  static void output(const PrefixedFlowStringRef &value, void *ctx,
+                     raw_ostream &os) {
+    os << value.prefix << value.value;
+  }
+  static StringRef input(StringRef value, void *ctx,
+                         PrefixedFlowStringRef &out) {
+    out.prefix = StringRef();
+    return Impl::input(value, ctx, out.value);
+  }
+  static bool mustQuote(StringRef name) { return Impl::mustQuote(name); }
+};
+
 using tapi::ObjCConstraint;
 template <> struct ScalarEnumerationTraits<ObjCConstraint> {
   static void enumeration(IO &io, ObjCConstraint &constraint) {
-    io.enumCase(constraint, "none", ObjCConstraint::None);
-    io.enumCase(constraint, "retain_release", ObjCConstraint::Retain_Release);
-    io.enumCase(constraint, "retain_release_for_simulator",
-                ObjCConstraint::Retain_Release_For_Simulator);
-    io.enumCase(constraint, "retain_release_or_gc",
-                ObjCConstraint::Retain_Release_Or_GC);
-    io.enumCase(constraint, "gc", ObjCConstraint::GC);
+    for (const auto &entry : names())
+      io.enumCase(constraint, entry.first, entry.second);
+  }
+
+  static StringRef name(ObjCConstraint constraint) {
+    for (const auto &entry : names())
+      if (entry.second == constraint)
+        return entry.first;
+    llvm_unreachable("unknown Objective-C constraint");
+  }
+
+private:
+  using Entry = std::pair<const char *, ObjCConstraint>;
+  static ArrayRef<Entry> names() {
+    static const Entry entries[] = {
+        {"none", ObjCConstraint::None},
+        {"retain_release", ObjCConstraint::Retain_Release},
+        {"retain_release_for_simulator",
+         ObjCConstraint::Retain_Release_For_Simulator},
+        {"retain_release_or_gc", ObjCConstraint::Retain_Release_Or_GC},
+        {"gc", ObjCConstraint::GC},
+    };
+    return entries;
   }
 };
 
 using tapi::Platform;
 template <> struct ScalarEnumerationTraits<Platform> {
   static void enumeration(IO &io, Platform &platform) {
-    io.enumCase(platform, "unknown", Platform::Unknown);
-    io.enumCase(platform, "macosx", Platform::OSX);
-    io.enumCase(platform, "ios", Platform::iOS);
-    io.enumCase(platform, "watchos", Platform::watchOS);
-    io.enumCase(platform, "tvos", Platform::tvOS);
-    io.enumCase(platform, "bridgeos", Platform::bridgeOS);
+    for (const auto &entry : names())
+      io.enumCase(platform, entry.first, entry.second);
+  }
+
+  static StringRef name(Platform platform) {
+    for (const auto &entry : names())
+      if (entry.second == platform)
+        return entry.first;
+    llvm_unreachable("unknown platform");
+  }
+
+private:
+  using Entry = std::pair<const char *, Platform>;
+  static ArrayRef<Entry> names() {
+    static const Entry entries[] = {
+        {"unknown", Platform::Unknown}, {"macosx", Platform::OSX},
+        {"ios", Platform::iOS},         {"watchos", Platform::watchOS},
+        {"tvos", Platform::tvOS},       {"bridgeos", Platform::bridgeOS},
+    };
+    return entries;
   }
 };
 
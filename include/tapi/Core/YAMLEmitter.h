@@ -0,0 +1,156 @@
+//===- tapi/Core/YAMLEmitter.h - Streaming YAML Emitter ---------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a streaming YAML emitter for the text-based file formats.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef TAPI_CORE_YAML_EMITTER_H
+#define TAPI_CORE_YAML_EMITTER_H
+
+#include "tapi/Core/LLVM.h"
+#include "tapi/Core/YAML.h"
+#include "tapi/Defines.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief Writes YAML documents directly to a stream.
+///
+/// The emitter produces exactly the same layout as llvm::yaml::Output: keys
+/// are padded to the same column, flow sequences wrap at the same column,
+/// block sequences are indented the same way and scalars are quoted by the
+/// same rules. Unlike llvm::yaml::Output it doesn't go through the generic
+/// YAML traits, so scalars that are already strings are written without
+/// being formatted into a temporary buffer first.
+///
+/// The caller is responsible for the document structure and for skipping
+/// optional keys that have their default value or an empty sequence.
+class YAMLEmitter {
+public:
+  explicit YAMLEmitter(raw_ostream &os, unsigned wrapColumn = 80)
+      : _os(os), _wrapColumn(wrapColumn) {}
+
+  /// \brief Start a document with a top-level mapping and an optional tag.
+  void beginDocument(StringRef tag = StringRef());
+  void endDocument();
+
+  void beginMapping();
+  void endMapping();
+  void key(StringRef key);
+
+  void beginSequence();
+  void endSequence();
+
+  void beginFlowSequence();
+  void endFlowSequence();
+
+  void beginBitSet();
+  void bitSetValue(StringRef value);
+  void endBitSet();
+
+  /// \brief Write an enumeration value, which is never quoted.
+  void enumScalar(StringRef value);
+
+  void scalar(StringRef value);
+  void scalar(const FlowStringRef &value) { scalar(value.value); }
+  void scalar(const PrefixedFlowStringRef &value);
+
+  /// \brief Write any other scalar through its YAML scalar traits.
+  template <typename T> void scalar(const T &value) {
+    SmallString<64> buffer;
+    llvm::raw_svector_ostream os(buffer);
+    llvm::yaml::ScalarTraits<T>::output(value, nullptr, os);
+    auto str = os.str();
+    preflightScalar();
+    scalarString(StringRef(), str,
+                 llvm::yaml::ScalarTraits<T>::mustQuote(str));
+  }
+
+  template <typename T> void flowSequence(const std::vector<T> &values) {
+    beginFlowSequence();
+    for (const auto &value : values)
+      scalar(value);
+    endFlowSequence();
+  }
+
+  template <typename T>
+  void mapFlowSequence(StringRef name, const std::vector<T> &values) {
+    key(name);
+    flowSequence(values);
+  }
+
+  template <typename T>
+  void mapOptionalFlowSequence(StringRef name, const std::vector<T> &values) {
+    if (values.empty())
+      return;
+    mapFlowSequence(name, values);
+  }
+
+  template <typename T>
+  void mapOptionalSequence(StringRef name, const std::vector<T> &values) {
+    if (values.empty())
+      return;
+    key(name);
+    beginSequence();
+    for (const auto &value : values)
+      scalar(value);
+    endSequence();
+  }
+
+  template <typename T> void mapScalar(StringRef name, const T &value) {
+    key(name);
+    scalar(value);
+  }
+
+  template <typename T>
+  void mapOptionalScalar(StringRef name, const T &value,
+                         const T &defaultValue) {
+    if (value == defaultValue)
+      return;
+    mapScalar(name, value);
+  }
+
+private:
+  enum State : uint8_t {
+    InSequence,
+    InFlowSequence,
+    InMapFirstKey,
+    InMapOtherKey,
+  };
+
+  void output(StringRef str) {
+    _column += str.size();
+    _os << str;
+  }
+  void outputUpToEndOfLine(StringRef str);
+  void newLineCheck();
+  void preflightScalar();
+  void scalarString(StringRef prefix, StringRef value, bool mustQuote);
+  void outputQuoted(StringRef str);
+
+  raw_ostream &_os;
+  unsigned _wrapColumn;
+  unsigned _column = 0;
+  unsigned _columnAtFlowStart = 0;
+  bool _needsNewLine = false;
+  bool _needFlowSequenceComma = false;
+  bool _needBitValueComma = false;
+  SmallVector<State, 8> _states;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_CORE_YAML_EMITTER_H
@@ -33,14 +33,22 @@ class IO;
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
 class YAMLBase;
+class YAMLEmitter;
 
 struct YAMLContext {
   const YAMLBase &base;
   std::string path;
   std::string errorMessage;
   ReadFlags readFlags;
+  ArchitectureSet arches = ArchitectureSet::All();
 
   YAMLContext(const YAMLBase &base) : base(base) {}
+
+  /// \brief Returns true if a section for the given architectures has to be
+  ///        read.
+  bool isRequested(ArchitectureSet archs) const {
+    return arches == ArchitectureSet::All() || !(archs & arches).empty();
+  }
 };
 
 class DocumentHandler {
@@ -50,6 +58,12 @@ public:
   virtual FileType getFileType(MemoryBufferRef bufferRef) const = 0;
   virtual bool canWrite(const File *file) const = 0;
   virtual bool handleDocument(llvm::yaml::IO &io, const File *&file) const = 0;
+
+  /// \brief Write the file with the streaming emitter. Returns false without
+  ///        writing anything if the handler doesn't support the file.
+  virtual bool emitDocument(YAMLEmitter &emitter, const File *file) const {
+    return false;
+  }
 };
 
 class YAMLBase {
@@ -58,6 +72,7 @@ public:
   FileType getFileType(MemoryBufferRef bufferRef) const;
   bool canWrite(const File *file) const;
   bool handleDocument(llvm::yaml::IO &io, const File *&file) const;
+  bool emitDocument(YAMLEmitter &emitter, const File *file) const;
 
   void add(std::unique_ptr<DocumentHandler> handler) {
     _documentHandlers.emplace_back(std::move(handler));
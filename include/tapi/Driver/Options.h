@@ -145,6 +145,9 @@ struct LinkerOptions {
   bool isDynamicLibrary = false;
 
   /// \brief List of allowable clients to use for the dynamic library.
+  ///
+  /// The install names of the references point into the command line
+  /// arguments, or into the string pool of the snapshot they were loaded from.
   std::vector<InterfaceFileRef> allowableClients;
 
   /// \brief List of reexported libraries to use for the dynamic library.
@@ -217,6 +220,9 @@ struct FrontendOptions {
   /// \brief Use Objective-C weak ARC (-fobjc-weak).
   bool useObjectiveCWeakARC = false;
 
+  /// \brief Number of concurrent header parser invocations.
+  unsigned numParseJobs = 1;
+
   bool operator==(const FrontendOptions &other) const;
 };
 
@@ -11,6 +11,7 @@
 #define TAPI_DRIVER_SNAPSHOT_H
 
 #include "tapi/Core/LLVM.h"
+#include "tapi/Core/StringPool.h"
 #include "tapi/Defines.h"
 #include "tapi/Driver/Options.h"
 #include "tapi/Driver/SnapshotFileSystem.h"
@@ -18,6 +19,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ManagedStatic.h"
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -105,10 +107,18 @@ private:
   DiagnosticsOptions diagnosticsOptions;
   TAPIOptions tapiOptions;
 
+  /// \brief Owns the install names of the linker option references. They
+  ///        have to outlive the options they were recorded from or the
+  ///        buffer they were loaded from.
+  StringPool stringPool;
+
   /// \brief The snapshot file system that is generated for loaded snapshots.
   IntrusiveRefCntPtr<SnapshotFileSystem> fs;
 
   FileMapping pathToHash;
+  /// \brief Guards the recorded files and directories, which are also
+  ///        recorded by concurrent header parsing.
+  std::mutex recordMutex;
   std::vector<std::string> files;
   std::vector<std::string> directories;
   std::vector<std::string> normalizedDirectories;
@@ -18,6 +18,8 @@
 #include <memory>
 #include <string>
 #include <tapi/Defines.h>
+#include <tapi/Symbol.h>
+#include <utility>
 #include <vector>
 
 ///
@@ -33,7 +35,6 @@ using cpu_subtype_t = int;
 TAPI_NAMESPACE_V1_BEGIN
 
 class PackedVersion32;
-class Symbol;
 
 ///
 /// \brief Defines a list of supported platforms.
@@ -154,6 +155,31 @@ inline ParsingFlags operator|=(ParsingFlags &lhs, ParsingFlags rhs) noexcept {
   return lhs;
 }
 
+///
+/// \brief Describes an input buffer for LinkerInterfaceFile::createBatch.
+/// \since 1.4
+///
+struct InputBuffer {
+  ///
+  /// \brief Path to the file (for error messages and the interface file
+  ///        cache).
+  /// \since 1.4
+  ///
+  std::string path;
+
+  ///
+  /// \brief Raw pointer to the start of the buffer.
+  /// \since 1.4
+  ///
+  const uint8_t *data;
+
+  ///
+  /// \brief Size of the buffer in bytes.
+  /// \since 1.4
+  ///
+  size_t size;
+};
+
 ///
 /// \brief TAPI File APIs
 /// \since 1.0
@@ -260,6 +286,146 @@ public:
          cpu_type_t cpuType, cpu_subtype_t cpuSubType, ParsingFlags flags,
          PackedVersion32 minOSVersion, std::string &errorMessage) noexcept;
 
+  ///
+  /// \brief Create a LinkerInterfaceFile for each of the requested
+  ///        architectures from the provided buffer.
+  ///
+  /// Parses the content of the provided buffer only once and creates one
+  /// LinkerInterfaceFile for every requested cpu type and cpu sub-type pair
+  /// with the given flags and minimum deployment version. The files share the
+  /// storage for the symbol names. Slices are selected the same way as #create
+  /// does.
+  ///
+  /// \param[in] path path to the file (for error message only).
+  /// \param[in] data raw pointer to start of buffer.
+  /// \param[in] size size of the buffer in bytes.
+  /// \param[in] cpuTypes The cpu type and cpu sub type pairs to check the file
+  ///            for.
+  /// \param[in] flags Flags that control the parsing behavior.
+  /// \param[in] minOSVersion The minimum OS version / deployment target.
+  /// \param[out] errorMessage holds an error message when the return value is
+  ///             empty.
+  /// \return One file per requested cpu type in the same order, or an empty
+  ///         list on error.
+  /// \since 1.4
+  ///
+  static std::vector<std::unique_ptr<LinkerInterfaceFile>>
+  createForArchitectures(
+      const std::string &path, const uint8_t *data, size_t size,
+      const std::vector<std::pair<cpu_type_t, cpu_subtype_t>> &cpuTypes,
+      ParsingFlags flags, PackedVersion32 minOSVersion,
+      std::string &errorMessage) noexcept;
+
+  ///
+  /// \brief Create a LinkerInterfaceFile for each of the provided buffers.
+  ///
+  /// Parses the buffers concurrently on a pool of worker threads with the
+  /// same constrains for cpu type, cpu sub-type, flags, and minimum deployment
+  /// version for every buffer. Each buffer is processed exactly like #create
+  /// would. This method can be called from multiple threads at the same time.
+  ///
+  /// \param[in] inputs The buffers to parse.
+  /// \param[in] cpuType The cpu type / architecture to check the files for.
+  /// \param[in] cpuSubType The cpu sub type / sub architecture to check the
+  ///            files for.
+  /// \param[in] flags Flags that control the parsing behavior.
+  /// \param[in] minOSVersion The minimum OS version / deployment target.
+  /// \param[out] errorMessages holds one entry per input. The entry contains
+  ///             an error message when the corresponding result is a nullptr.
+  /// \param[in] numThreads The maximum number of worker threads. Zero selects
+  ///            the number of hardware threads.
+  /// \return One file per input in the same order. Inputs that couldn't be
+  ///         parsed are represented by a nullptr.
+  /// \since 1.4
+  ///
+  static std::vector<std::unique_ptr<LinkerInterfaceFile>>
+  createBatch(const std::vector<InputBuffer> &inputs, cpu_type_t cpuType,
+              cpu_subtype_t cpuSubType, ParsingFlags flags,
+              PackedVersion32 minOSVersion,
+              std::vector<std::string> &errorMessages,
+              unsigned numThreads = 0) noexcept;
+
+  ///
+  /// \brief Query how many input buffers have been parsed in place.
+  ///
+  /// #create parses text-based stub files directly from the provided buffer,
+  /// which doesn't have to be null-terminated. A private copy is only created
+  /// for files that have to be handed to the generic YAML parser, which
+  /// requires a null-terminated buffer, and for files that are added to the
+  /// interface file cache.
+  ///
+  /// \return Returns the number of buffer copies that have been avoided so
+  ///         far by this process.
+  /// \since 1.3
+  ///
+  static uint64_t getNumAvoidedBufferCopies() noexcept;
+
+  ///
+  /// \brief Set the capacity of the process-wide interface file cache.
+  ///
+  /// When enabled, #create keeps the parsed content of every text-based stub
+  /// file in a cache that is keyed by path and a hash of the file content.
+  /// Creating a LinkerInterfaceFile for the same file again (e.g. for another
+  /// architecture) only has to extract the requested slice. The cache keeps a
+  /// private copy of the file content and never references the buffer that
+  /// was provided by the caller. The least recently used files are evicted
+  /// once the total size of the cached files exceeds the capacity.
+  ///
+  /// The cache is disabled by default.
+  ///
+  /// \param[in] capacity The maximum total size in bytes of all cached files.
+  ///            A capacity of zero disables the cache.
+  /// \since 1.3
+  ///
+  static void setCacheCapacity(uint64_t capacity) noexcept;
+
+  ///
+  /// \brief Query the capacity of the process-wide interface file cache.
+  /// \return Returns the maximum total size in bytes of all cached files.
+  /// \since 1.3
+  ///
+  static uint64_t getCacheCapacity() noexcept;
+
+  ///
+  /// \brief Remove the file with the given path from the interface file cache.
+  /// \param[in] path full path to the text-based stub file.
+  /// \since 1.3
+  ///
+  static void evictFromCache(const std::string &path) noexcept;
+
+  ///
+  /// \brief Remove all files from the interface file cache.
+  /// \since 1.3
+  ///
+  static void clearCache() noexcept;
+
+  ///
+  /// \brief Query how many times #create found the file in the cache.
+  /// \since 1.3
+  ///
+  static uint64_t getNumCacheHits() noexcept;
+
+  ///
+  /// \brief Query how many times #create had to parse the file, because it
+  ///        wasn't in the cache or the file content changed.
+  /// \since 1.3
+  ///
+  static uint64_t getNumCacheMisses() noexcept;
+
+  ///
+  /// \brief Query how many files have been evicted from the cache.
+  /// \since 1.3
+  ///
+  static uint64_t getNumCacheEvictions() noexcept;
+
+  ///
+  /// \brief Query the current size of the interface file cache.
+  /// \return Returns the total size in bytes of all cached files, which never
+  ///         exceeds the capacity.
+  /// \since 1.3
+  ///
+  static uint64_t getCacheSize() noexcept;
+
   ///
   /// \brief Query the file type.
   /// \return Returns the file type this TAPI file represents.
@@ -395,6 +561,48 @@ public:
   ///
   const std::vector<Symbol> &undefineds() const noexcept;
 
+  ///
+  /// \brief Obtain references to all exported symbols.
+  ///
+  /// All symbol names are stored in a single string pool that is owned by
+  /// this file. Unlike #exports, this doesn't allocate memory per symbol.
+  ///
+  /// \return Returns a range of references to all exported symbols.
+  /// \since 1.4
+  ///
+  SymbolRefRange exportRefs() const noexcept;
+
+  ///
+  /// \brief Obtain references to all undefined symbols.
+  ///
+  /// All symbol names are stored in a single string pool that is owned by
+  /// this file. Unlike #undefineds, this doesn't allocate memory per symbol.
+  ///
+  /// \return Returns a range of references to all undefined symbols.
+  /// \since 1.4
+  ///
+  SymbolRefRange undefinedRefs() const noexcept;
+
+  ///
+  /// \brief Invoke the callback for every exported symbol.
+  /// \param[in] callback Callable that accepts a const SymbolRef &.
+  /// \since 1.4
+  ///
+  template <typename Fn> void forEachExport(Fn &&callback) const {
+    for (const auto &symbol : exportRefs())
+      callback(symbol);
+  }
+
+  ///
+  /// \brief Invoke the callback for every undefined symbol.
+  /// \param[in] callback Callable that accepts a const SymbolRef &.
+  /// \since 1.4
+  ///
+  template <typename Fn> void forEachUndefined(Fn &&callback) const {
+    for (const auto &symbol : undefinedRefs())
+      callback(symbol);
+  }
+
   ///
   /// \brief Destructor.
   /// \since 1.0
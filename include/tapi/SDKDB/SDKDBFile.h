@@ -16,10 +16,12 @@
 
 #include "tapi/Core/File.h"
 #include "tapi/Core/InterfaceFile.h"
+#include "tapi/Core/StringPool.h"
 #include "tapi/Core/XPISet.h"
 #include "tapi/Defines.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/YAMLTraits.h"
+#include <memory>
 #include <string>
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
@@ -38,7 +40,8 @@ public:
   SDKDBFile() : File(File::Kind::SDKDBFile) {}
   SDKDBFile(SDKDBFile &&other)
       : File(File::Kind::SDKDBFile), error(std::move(other.error)) {
-    installName = std::move(other.installName);
+    stringPool = std::move(other.stringPool);
+    installName = other.installName;
     symbols = std::move(other.symbols);
     classes = std::move(other.classes);
     categories = std::move(other.categories);
@@ -50,7 +53,7 @@ public:
 
   /// \brief Set the install name for the framework/dylib.
   void setInstallName(StringRef installName) {
-    this->installName = installName;
+    this->installName = stringPool->intern(installName);
   }
   StringRef getInstallName() const { return installName; }
 
@@ -88,8 +91,10 @@ public:
 
   llvm::Error verifySDKDBFile(const SDKDBFile *baseline) const;
 
+  /// \brief The names in the entries and map keys reference the string pool
+  ///        of the file.
   struct InfoEntry {
-    std::string name;
+    StringRef name;
     bool isPublic = false;
     AvailabilityInfo availability;
 
@@ -140,7 +145,7 @@ public:
   };
 
   struct ObjCClassEntry : public ObjCContainerEntry {
-    std::string superClassName;
+    StringRef superClassName;
 
     ObjCClassEntry() = default;
     ObjCClassEntry(StringRef name, StringRef superClassName, bool isPublic,
@@ -150,7 +155,7 @@ public:
   };
 
   struct ObjCCategoryEntry : public ObjCContainerEntry {
-    std::string baseClassName;
+    StringRef baseClassName;
 
     ObjCCategoryEntry() = default;
     ObjCCategoryEntry(StringRef name, StringRef baseClassName, bool isPublic,
@@ -183,13 +188,16 @@ public:
   };
 
 private:
-  using SymbolsMapType = std::map<std::string, SymbolEntry>;
-  using ObjCClassMapType = std::map<std::string, ObjCClassEntry>;
+  using SymbolsMapType = std::map<StringRef, SymbolEntry>;
+  using ObjCClassMapType = std::map<StringRef, ObjCClassEntry>;
   using ObjCCategoryMapType =
       std::map<CategoriesMapKey, ObjCCategoryEntry, CategoriesMapKeyLess>;
-  using ObjCProtocolMapType = std::map<std::string, ObjCProtocolEntry>;
+  using ObjCProtocolMapType = std::map<StringRef, ObjCProtocolEntry>;
 
-  std::string installName;
+  /// \brief Owns the names of this file. Files don't share their pools, so
+  ///        merge interns the names of the other file into this pool.
+  std::shared_ptr<StringPool> stringPool = std::make_shared<StringPool>();
+  StringRef installName;
   SymbolsMapType symbols;
   ObjCClassMapType classes;
   ObjCCategoryMapType categories;
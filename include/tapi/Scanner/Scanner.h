@@ -37,6 +37,9 @@ struct ParsingJob {
   bool validateSystemHeaders = false;
   bool useObjectiveCARC = false;
   bool useObjectiveCWeakARC = false;
+  /// \brief The number of header parser invocations (one per header type and
+  ///        architecture) that may run concurrently.
+  unsigned numThreads = 1;
   std::string osVersion;
   std::string language_std;
   std::string visibility;
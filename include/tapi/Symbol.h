@@ -15,6 +15,8 @@
 #ifndef TAPI_SYMBOL_H
 #define TAPI_SYMBOL_H
 
+#include <cstddef>
+#include <string>
 #include <tapi/Defines.h>
 
 ///
@@ -112,6 +114,95 @@ private:
   SymbolFlags _flags;
 };
 
+///
+/// \brief A lightweight reference to a symbol name and its flags.
+///
+/// The symbol name is owned by the LinkerInterfaceFile the reference was
+/// obtained from and stays valid for the lifetime of the file.
+///
+/// \since 1.4
+///
+class TAPI_PUBLIC SymbolRef {
+public:
+  SymbolRef(const char *name, size_t length,
+            SymbolFlags flags = SymbolFlags::None) noexcept
+      : _name(name), _length(length), _flags(flags) {}
+
+  ///
+  /// \brief Get the symbol name.
+  /// \return A null-terminated string with the symbol name.
+  /// \since 1.4
+  ///
+  inline const char *getName() const noexcept { return _name; }
+
+  ///
+  /// \brief Get the length of the symbol name.
+  /// \return The length of the symbol name without the null-terminator.
+  /// \since 1.4
+  ///
+  inline size_t getNameLength() const noexcept { return _length; }
+
+  ///
+  /// \brief Obtain the symbol flags.
+  /// \return Returns the symbol flags.
+  /// \since 1.4
+  ///
+  inline SymbolFlags getFlags() const noexcept { return _flags; }
+
+  ///
+  /// \brief Query if the symbol is thread-local.
+  /// \return True if the symbol is a thread-local value, false otherwise.
+  /// \since 1.4
+  ///
+  inline bool isThreadLocalValue() const noexcept {
+    return (_flags & SymbolFlags::ThreadLocalValue) ==
+           SymbolFlags::ThreadLocalValue;
+  }
+
+  ///
+  /// \brief Query if the symbol is weak defined.
+  /// \return True if the symbol is weak defined, false otherwise.
+  /// \since 1.4
+  ///
+  inline bool isWeakDefined() const noexcept {
+    return (_flags & SymbolFlags::WeakDefined) == SymbolFlags::WeakDefined;
+  }
+
+  ///
+  /// \brief Query if the symbol is weak referenced.
+  /// \return True if the symbol is weak referenced, false otherwise.
+  /// \since 1.4
+  ///
+  inline bool isWeakReferenced() const noexcept {
+    return (_flags & SymbolFlags::WeakReferenced) ==
+           SymbolFlags::WeakReferenced;
+  }
+
+private:
+  const char *_name;
+  size_t _length;
+  SymbolFlags _flags;
+};
+
+///
+/// \brief A contiguous range of symbol references.
+/// \since 1.4
+///
+class TAPI_PUBLIC SymbolRefRange {
+public:
+  SymbolRefRange(const SymbolRef *begin, const SymbolRef *end) noexcept
+      : _begin(begin), _end(end) {}
+
+  inline const SymbolRef *begin() const noexcept { return _begin; }
+  inline const SymbolRef *end() const noexcept { return _end; }
+  inline size_t size() const noexcept { return _end - _begin; }
+  inline bool empty() const noexcept { return _begin == _end; }
+
+private:
+  const SymbolRef *_begin;
+  const SymbolRef *_end;
+};
+
 TAPI_NAMESPACE_V1_END
 
 ///
@@ -14,6 +14,7 @@
 
 #include "tapi/Core/ExtendedInterfaceFile.h"
 #include "tapi/Core/Path.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/ErrorHandling.h"
 
 using namespace llvm;
@@ -153,126 +154,31 @@ bool ExtendedInterfaceFile::contains(XPIKind kind, StringRef name,
 
 Expected<std::unique_ptr<ExtendedInterfaceFile>> ExtendedInterfaceFile::merge(
     const ExtendedInterfaceFile *otherInterface) const {
-  // Verify files can be merged.
-  if (getFileType() != otherInterface->getFileType()) {
-    return make_error<StringError>("file types do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if ((getArchitectures() & otherInterface->getArchitectures()) !=
-      Architecture::unknown) {
-    return make_error<StringError>("architectures overlap",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getPlatform() != otherInterface->getPlatform()) {
-    return make_error<StringError>("platforms do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getInstallName() != otherInterface->getInstallName()) {
-    return make_error<StringError>("install names do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getCurrentVersion() != otherInterface->getCurrentVersion()) {
-    return make_error<StringError>("current versions do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getCompatibilityVersion() != otherInterface->getCompatibilityVersion()) {
-    return make_error<StringError>("compatibility versions do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getSwiftABIVersion() != otherInterface->getSwiftABIVersion()) {
-    return make_error<StringError>("swift ABI versions do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (isTwoLevelNamespace() != otherInterface->isTwoLevelNamespace()) {
-    return make_error<StringError>("two level namespace flags do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (isApplicationExtensionSafe() !=
-      otherInterface->isApplicationExtensionSafe()) {
-    return make_error<StringError>(
-        "application extension safe flags do not match",
-        inconvertibleErrorCode());
-  }
+  const ExtendedInterfaceFile *files[] = {this, otherInterface};
+  return merge(files);
+}
 
-  if (isInstallAPI() != otherInterface->isInstallAPI()) {
-    return make_error<StringError>("installapi flags do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getObjCConstraint() != otherInterface->getObjCConstraint()) {
-    return make_error<StringError>("installapi flags do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getParentUmbrella() != otherInterface->getParentUmbrella()) {
-    return make_error<StringError>("parent umbrellas do not match",
-                                   inconvertibleErrorCode());
-  }
+Expected<std::unique_ptr<ExtendedInterfaceFile>>
+ExtendedInterfaceFile::merge(ArrayRef<const ExtendedInterfaceFile *> files) {
+  assert(!files.empty() && "expecting at least one file");
+  SmallVector<const InterfaceFileBase *, 8> bases(files.begin(), files.end());
+  if (auto error = verifyMergeable(bases))
+    return std::move(error);
 
   std::unique_ptr<ExtendedInterfaceFile> interface(new ExtendedInterfaceFile());
-  interface->setFileType(getFileType());
-  interface->setPath(getPath());
-  interface->setPlatform(getPlatform());
-  interface->setInstallName(getInstallName());
-  interface->setCurrentVersion(getCurrentVersion());
-  interface->setCompatibilityVersion(getCompatibilityVersion());
-  interface->setSwiftABIVersion(getSwiftABIVersion());
-  interface->setTwoLevelNamespace(isTwoLevelNamespace());
-  interface->setApplicationExtensionSafe(isApplicationExtensionSafe());
-  interface->setInstallAPI(isInstallAPI());
-  interface->setObjCConstraint(getObjCConstraint());
-  interface->setParentUmbrella(getParentUmbrella());
-
-  interface->setArchitectures(getArchitectures() |
-                              otherInterface->getArchitectures());
-
-  for (const auto &lib : allowableClients())
-    interface->addAllowableClient(lib.getInstallName(), lib.getArchitectures());
-
-  for (const auto &lib : otherInterface->allowableClients())
-    interface->addAllowableClient(lib.getInstallName(), lib.getArchitectures());
-
-  for (const auto &lib : reexportedLibraries())
-    interface->addReexportedLibrary(lib.getInstallName(),
-                                    lib.getArchitectures());
-
-  for (const auto &lib : otherInterface->reexportedLibraries())
-    interface->addReexportedLibrary(lib.getInstallName(),
-                                    lib.getArchitectures());
-
-  for (const auto &uuid : uuids())
-    interface->addUUID(uuid.first, uuid.second);
-
-  for (const auto &uuid : otherInterface->uuids())
-    interface->addUUID(uuid.first, uuid.second);
-
-  for (const auto *symbol : symbols())
-    interface->addSymbol(symbol->getKind(), symbol->getName(),
-                         symbol->getArchitectures(), symbol->getSymbolFlags(),
-                         symbol->getAccess());
-
-  for (const auto *symbol : otherInterface->symbols())
-    interface->addSymbol(symbol->getKind(), symbol->getName(),
-                         symbol->getArchitectures(), symbol->getSymbolFlags(),
-                         symbol->getAccess());
-
-  for (const auto *symbol : undefineds())
-    interface->addUndefinedSymbol(symbol->getKind(), symbol->getName(),
-                                  symbol->getArchitectures(),
-                                  symbol->getSymbolFlags());
-
-  for (const auto *symbol : otherInterface->undefineds())
-    interface->addUndefinedSymbol(symbol->getKind(), symbol->getName(),
-                                  symbol->getArchitectures(),
-                                  symbol->getSymbolFlags());
+  interface->mergeHeaders(bases);
+
+  for (const auto *file : files)
+    for (const auto *symbol : file->symbols())
+      interface->addSymbol(symbol->getKind(), symbol->getName(),
+                           symbol->getArchitectures(),
+                           symbol->getSymbolFlags(), symbol->getAccess());
+
+  for (const auto *file : files)
+    for (const auto *symbol : file->undefineds())
+      interface->addUndefinedSymbol(symbol->getKind(), symbol->getName(),
+                                    symbol->getArchitectures(),
+                                    symbol->getSymbolFlags());
 
   return std::move(interface);
 }
@@ -41,15 +41,10 @@ bool Framework::verify(bool warnAll) const {
     framework.verify(warnAll);
 
   std::set<const XPI *> visitedSymbols;
-  std::vector<const XPI *> symbols;
   for (auto &dylib : _interfaceFiles) {
     // Check if each symbol that is exported from the dylib is also in a header
     // file.
-    symbols.clear();
-    for (const auto *symbol : dylib->symbols())
-      symbols.emplace_back(symbol);
-    sort(symbols, [](const XPI *lhs, const XPI *rhs) { return *lhs < *rhs; });
-    for (const auto *dsym : symbols) {
+    for (const auto *dsym : dylib->symbols()) {
       const auto &hsym =
           _headerSymbols->findSymbol(dsym->getKind(), dsym->getName());
       if (hsym == nullptr && dsym->isExportedSymbol()) {
@@ -157,11 +152,7 @@ bool Framework::verify(bool warnAll) const {
   }
 
   // Check if the headers are exporting more symbols than the dylib.
-  symbols.clear();
-  for (const auto *symbol : _headerSymbols->exports())
-    symbols.emplace_back(symbol);
-  sort(symbols, [](const XPI *lhs, const XPI *rhs) { return *lhs < *rhs; });
-  for (const auto *sym : symbols) {
+  for (const auto *sym : _headerSymbols->exports()) {
     if (!visitedSymbols.count(sym) && !sym->isUnavailable()) {
       outs() << "warning: headers exports symbol " << sym->getAnnotatedName()
              << " without an export in a dylib.\n";
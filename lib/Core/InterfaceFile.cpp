@@ -16,7 +16,9 @@
 #include "tapi/Core/ExtendedInterfaceFile.h"
 #include "tapi/Core/Path.h"
 #include "tapi/Core/XPI.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/ErrorHandling.h"
+#include <iterator>
 
 using namespace llvm;
 
@@ -40,15 +42,44 @@ static SymbolKind convertXPIKindToSymbolKind(XPIKind kind) {
 InterfaceFile::InterfaceFile(ExtendedInterfaceFile &&other)
     : InterfaceFileBase(std::forward<InterfaceFileBase>(other)) {
   setKind(File::Kind::InterfaceFile);
-  for (const auto *symbol : other.exports())
+
+  // Take the XPI sets from the source, so their memory is released as soon as
+  // the conversion is done and not only when the source is destroyed.
+  std::unique_ptr<XPISet> symbols(new XPISet);
+  std::unique_ptr<XPISet> undefineds(new XPISet);
+  symbols.swap(other._symbols);
+  undefineds.swap(other._undefineds);
+
+  // The XPI names are owned by the string pool of the sets. If that is the
+  // pool this file took over from the source, the symbols can refer to the
+  // names without copying.
+  bool copyExports = symbols->getStringPool() != _stringPool;
+  bool copyUndefineds = undefineds->getStringPool() != _stringPool;
+
+  auto exports = symbols->exports();
+  auto undefinedSymbols = undefineds->symbols();
+  reserveSymbols(std::distance(exports.begin(), exports.end()),
+                 std::distance(undefinedSymbols.begin(),
+                               undefinedSymbols.end()));
+
+  for (const auto *symbol : exports)
     addSymbolImpl(convertXPIKindToSymbolKind(symbol->getKind()),
                   symbol->getName(), symbol->getArchitectures(),
-                  symbol->getSymbolFlags());
+                  symbol->getSymbolFlags(), copyExports);
 
-  for (const auto *symbol : other.undefineds())
+  for (const auto *symbol : undefinedSymbols)
     addUndefinedSymbolImpl(convertXPIKindToSymbolKind(symbol->getKind()),
                            symbol->getName(), symbol->getArchitectures(),
-                           symbol->getSymbolFlags());
+                           symbol->getSymbolFlags(), copyUndefineds);
+}
+
+void InterfaceFile::reserveSymbols(size_t numSymbols, size_t numUndefineds) {
+  _symbols.reserve(numSymbols);
+  _exportColumns.reserve(numSymbols);
+  _symbolIndex.reserve(numSymbols);
+  _undefineds.reserve(numUndefineds);
+  _undefinedColumns.reserve(numUndefineds);
+  _undefinedIndex.reserve(numUndefineds);
 }
 
 void InterfaceFile::addSymbolImpl(SymbolKind kind, StringRef name,
@@ -56,18 +87,21 @@ void InterfaceFile::addSymbolImpl(SymbolKind kind, StringRef name,
                                   bool copyStrings) {
   if (copyStrings)
     name = copyString(name);
+  // Readers don't check for duplicates. Keep the first symbol, which is the
+  // one a linear search would have found.
+  _symbolIndex.insert(
+      std::make_pair(getSymbolKey(kind, name), uint32_t(_symbols.size())));
   _symbols.emplace_back(new (allocator) Symbol{kind, name, archs, flags});
+  _exportColumns.push_back(kind, archs, flags);
 }
 
 void InterfaceFile::addSymbol(SymbolKind kind, StringRef name,
                               ArchitectureSet archs, SymbolFlags flags,
                               bool copyStrings) {
-  auto it = find_if(_symbols, [kind, name](const Symbol *symbol) {
-    return (symbol->getKind() == kind) && (symbol->getName() == name);
-  });
-
-  if (it != _symbols.end()) {
-    (*it)->setArchitectures(archs);
+  auto it = _symbolIndex.find(getSymbolKey(kind, name));
+  if (it != _symbolIndex.end()) {
+    _symbols[it->second]->setArchitectures(archs);
+    _exportColumns.addArchitectures(it->second, archs);
     return;
   }
 
@@ -80,18 +114,19 @@ void InterfaceFile::addUndefinedSymbolImpl(SymbolKind kind, StringRef name,
                                            bool copyStrings) {
   if (copyStrings)
     name = copyString(name);
+  _undefinedIndex.insert(
+      std::make_pair(getSymbolKey(kind, name), uint32_t(_undefineds.size())));
   _undefineds.emplace_back(new (allocator) Symbol{kind, name, archs, flags});
+  _undefinedColumns.push_back(kind, archs, flags);
 }
 
 void InterfaceFile::addUndefinedSymbol(SymbolKind kind, StringRef name,
                                        ArchitectureSet archs, SymbolFlags flags,
                                        bool copyStrings) {
-  auto it = find_if(_undefineds, [kind, name](const Symbol *symbol) {
-    return (symbol->getKind() == kind) && (symbol->getName() == name);
-  });
-
-  if (it != _undefineds.end()) {
-    (*it)->setArchitectures(archs);
+  auto it = _undefinedIndex.find(getSymbolKey(kind, name));
+  if (it != _undefinedIndex.end()) {
+    _undefineds[it->second]->setArchitectures(archs);
+    _undefinedColumns.addArchitectures(it->second, archs);
     return;
   }
 
@@ -151,137 +186,59 @@ bool InterfaceFile::convertTo(FileType fileType, StringRef path) {
 
 bool InterfaceFile::contains(SymbolKind kind, StringRef name,
                              Symbol const **result) const {
-  auto it = find_if(_symbols, [kind, name](const Symbol *symbol) {
-    return (symbol->getKind() == kind) && (symbol->getName() == name);
-  });
-
-  if (it != _symbols.end()) {
-    if (result)
-      *result = *it;
-    return true;
-  }
+  auto it = _symbolIndex.find(getSymbolKey(kind, name));
+  if (it == _symbolIndex.end())
+    return false;
 
-  return false;
+  if (result)
+    *result = _symbols[it->second];
+  return true;
 }
 
-Expected<std::unique_ptr<InterfaceFile>>
-InterfaceFile::extract(Architecture arch) const {
+Expected<InterfaceFileView> InterfaceFile::getView(Architecture arch) const {
   if (!_architectures.has(arch)) {
     return make_error<StringError>("file doesn't have architecture '" +
                                        getArchName(arch) + "'",
                                    inconvertibleErrorCode());
   }
 
-  std::unique_ptr<InterfaceFile> interface(new InterfaceFile());
-  interface->setFileType(getFileType());
-  interface->setPath(getPath());
-  interface->setPlatform(getPlatform());
-  interface->setArch(arch);
-  interface->setInstallName(getInstallName());
-  interface->setCurrentVersion(getCurrentVersion());
-  interface->setCompatibilityVersion(getCompatibilityVersion());
-  interface->setSwiftABIVersion(getSwiftABIVersion());
-  interface->setTwoLevelNamespace(isTwoLevelNamespace());
-  interface->setApplicationExtensionSafe(isApplicationExtensionSafe());
-  interface->setInstallAPI(isInstallAPI());
-  interface->setObjCConstraint(getObjCConstraint());
-  interface->setParentUmbrella(getParentUmbrella());
-
-  for (const auto &lib : allowableClients())
-    if (lib.hasArchitecture(arch))
-      interface->addAllowableClient(lib.getInstallName(), arch);
-
-  for (const auto &lib : reexportedLibraries())
-    if (lib.hasArchitecture(arch))
-      interface->addReexportedLibrary(lib.getInstallName(), arch);
-
-  for (const auto &uuid : uuids())
-    if (uuid.first == arch)
-      interface->addUUID(arch, uuid.second);
-
-  for (const auto *symbol : symbols())
-    if (symbol->getArchitectures().has(arch))
-      interface->addSymbol(symbol->getKind(), symbol->getName(), arch,
-                           symbol->getFlags());
-
-  for (const auto *symbol : undefineds())
-    if (symbol->getArchitectures().has(arch))
-      interface->addUndefinedSymbol(symbol->getKind(), symbol->getName(), arch,
-                                    symbol->getFlags());
-
-  return std::move(interface);
+  return InterfaceFileView(*this, arch);
 }
 
 Expected<std::unique_ptr<InterfaceFile>>
-InterfaceFile::merge(const InterfaceFile *otherInterface) const {
-  // Verify files can be merged.
-  if (getFileType() != otherInterface->getFileType()) {
-    return make_error<StringError>("file types do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if ((getArchitectures() & otherInterface->getArchitectures()) !=
-      Architecture::unknown) {
-    return make_error<StringError>("architectures overlap",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getPlatform() != otherInterface->getPlatform()) {
-    return make_error<StringError>("platforms do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getInstallName() != otherInterface->getInstallName()) {
-    return make_error<StringError>("install names do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getCurrentVersion() != otherInterface->getCurrentVersion()) {
-    return make_error<StringError>("current versions do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getCompatibilityVersion() != otherInterface->getCompatibilityVersion()) {
-    return make_error<StringError>("compatibility versions do not match",
-                                   inconvertibleErrorCode());
-  }
-
-  if (getSwiftABIVersion() != otherInterface->getSwiftABIVersion()) {
-    return make_error<StringError>("swift ABI versions do not match",
-                                   inconvertibleErrorCode());
-  }
+InterfaceFile::extract(Architecture arch) const {
+  auto view = getView(arch);
+  if (!view)
+    return view.takeError();
 
-  if (isTwoLevelNamespace() != otherInterface->isTwoLevelNamespace()) {
-    return make_error<StringError>("two level namespace flags do not match",
-                                   inconvertibleErrorCode());
-  }
+  return view->materialize();
+}
 
-  if (isApplicationExtensionSafe() !=
-      otherInterface->isApplicationExtensionSafe()) {
-    return make_error<StringError>(
-        "application extension safe flags do not match",
-        inconvertibleErrorCode());
-  }
+InterfaceFileView::InterfaceFileView(const InterfaceFile &parent,
+                                     Architecture arch)
+    : File(File::Kind::InterfaceFileView), _parent(&parent), _arch(arch) {
+  setFileType(parent.getFileType());
+  setPath(parent.getPath());
 
-  if (isInstallAPI() != otherInterface->isInstallAPI()) {
-    return make_error<StringError>("installapi flags do not match",
-                                   inconvertibleErrorCode());
-  }
+  for (const auto &lib : parent.allowableClients())
+    if (lib.hasArchitecture(arch))
+      _allowableClients.emplace_back(lib.getInstallName(), arch);
 
-  if (getObjCConstraint() != otherInterface->getObjCConstraint()) {
-    return make_error<StringError>("installapi flags do not match",
-                                   inconvertibleErrorCode());
-  }
+  for (const auto &lib : parent.reexportedLibraries())
+    if (lib.hasArchitecture(arch))
+      _reexportedLibraries.emplace_back(lib.getInstallName(), arch);
 
-  if (getParentUmbrella() != otherInterface->getParentUmbrella()) {
-    return make_error<StringError>("parent umbrellas do not match",
-                                   inconvertibleErrorCode());
-  }
+  for (const auto &uuid : parent.uuids())
+    if (uuid.first == arch)
+      _uuids.emplace_back(uuid);
+}
 
+std::unique_ptr<InterfaceFile> InterfaceFileView::materialize() const {
   std::unique_ptr<InterfaceFile> interface(new InterfaceFile());
   interface->setFileType(getFileType());
   interface->setPath(getPath());
   interface->setPlatform(getPlatform());
+  interface->setArch(_arch);
   interface->setInstallName(getInstallName());
   interface->setCurrentVersion(getCurrentVersion());
   interface->setCompatibilityVersion(getCompatibilityVersion());
@@ -292,73 +249,91 @@ InterfaceFile::merge(const InterfaceFile *otherInterface) const {
   interface->setObjCConstraint(getObjCConstraint());
   interface->setParentUmbrella(getParentUmbrella());
 
-  interface->setArchitectures(getArchitectures() |
-                              otherInterface->getArchitectures());
+  for (const auto &lib : _allowableClients)
+    interface->addAllowableClient(lib.getInstallName(), _arch);
 
-  for (const auto &lib : allowableClients())
-    interface->addAllowableClient(lib.getInstallName(), lib.getArchitectures());
+  for (const auto &lib : _reexportedLibraries)
+    interface->addReexportedLibrary(lib.getInstallName(), _arch);
 
-  for (const auto &lib : otherInterface->allowableClients())
-    interface->addAllowableClient(lib.getInstallName(), lib.getArchitectures());
+  for (const auto &uuid : _uuids)
+    interface->addUUID(_arch, uuid.second);
 
-  for (const auto &lib : reexportedLibraries())
-    interface->addReexportedLibrary(lib.getInstallName(),
-                                    lib.getArchitectures());
+  auto exports = this->exports();
+  auto undefineds = this->undefineds();
+  interface->reserveSymbols(
+      std::distance(exports.begin(), exports.end()),
+      std::distance(undefineds.begin(), undefineds.end()));
+  for (auto it = exports.begin(), e = exports.end(); it != e; ++it)
+    interface->addSymbol(it.getKind(), it->getName(), _arch, it.getFlags());
 
-  for (const auto &lib : otherInterface->reexportedLibraries())
-    interface->addReexportedLibrary(lib.getInstallName(),
-                                    lib.getArchitectures());
+  for (auto it = undefineds.begin(), e = undefineds.end(); it != e; ++it)
+    interface->addUndefinedSymbol(it.getKind(), it->getName(), _arch,
+                                  it.getFlags());
 
-  for (const auto &uuid : uuids())
-    interface->addUUID(uuid.first, uuid.second);
+  return interface;
+}
 
-  for (const auto &uuid : otherInterface->uuids())
-    interface->addUUID(uuid.first, uuid.second);
+Expected<std::unique_ptr<InterfaceFile>>
+InterfaceFile::merge(const InterfaceFile *otherInterface) const {
+  const InterfaceFile *files[] = {this, otherInterface};
+  return merge(files);
+}
 
-  for (const auto *symbol : symbols())
-    interface->addSymbol(symbol->getKind(), symbol->getName(),
-                         symbol->getArchitectures(), symbol->getFlags());
+Expected<std::unique_ptr<InterfaceFile>>
+InterfaceFile::merge(ArrayRef<const InterfaceFile *> files) {
+  assert(!files.empty() && "expecting at least one file");
+  SmallVector<const InterfaceFileBase *, 8> bases(files.begin(), files.end());
+  if (auto error = verifyMergeable(bases))
+    return std::move(error);
 
-  for (const auto *symbol : otherInterface->symbols())
-    interface->addSymbol(symbol->getKind(), symbol->getName(),
-                         symbol->getArchitectures(), symbol->getFlags());
+  std::unique_ptr<InterfaceFile> interface(new InterfaceFile());
+  interface->mergeHeaders(bases);
+
+  // Every symbol is inserted exactly once. Symbols that appear in several
+  // files are found through the index and only gain architectures.
+  size_t numSymbols = 0, numUndefineds = 0;
+  for (const auto *file : files) {
+    numSymbols += file->_symbols.size();
+    numUndefineds += file->_undefineds.size();
+  }
+  interface->reserveSymbols(numSymbols, numUndefineds);
 
-  for (const auto *symbol : undefineds())
-    interface->addUndefinedSymbol(symbol->getKind(), symbol->getName(),
-                                  symbol->getArchitectures(),
-                                  symbol->getFlags());
+  for (const auto *file : files)
+    for (const auto *symbol : file->symbols())
+      interface->addSymbol(symbol->getKind(), symbol->getName(),
+                           symbol->getArchitectures(), symbol->getFlags());
 
-  for (const auto *symbol : otherInterface->undefineds())
-    interface->addUndefinedSymbol(symbol->getKind(), symbol->getName(),
-                                  symbol->getArchitectures(),
-                                  symbol->getFlags());
+  for (const auto *file : files)
+    for (const auto *symbol : file->undefineds())
+      interface->addUndefinedSymbol(symbol->getKind(), symbol->getName(),
+                                    symbol->getArchitectures(),
+                                    symbol->getFlags());
 
   return std::move(interface);
 }
 
 void InterfaceFile::printSymbolsForArch(Architecture arch) const {
   std::vector<std::string> exports;
-  for (const auto *symbol : this->symbols()) {
-    if (!symbol->getArchitectures().has(arch))
-      continue;
-
-    switch (symbol->getKind()) {
+  auto symbols = this->exports(arch);
+  for (auto it = symbols.begin(), e = symbols.end(); it != e; ++it) {
+    auto name = it->getName();
+    switch (it.getKind()) {
     case SymbolKind::GlobalSymbol:
-      exports.emplace_back(symbol->getName());
+      exports.emplace_back(name);
       break;
     case SymbolKind::ObjectiveCClass:
       if (getPlatform() == Platform::OSX && arch == Architecture::i386) {
-        exports.emplace_back(".objc_class_name_" + symbol->getName().str());
+        exports.emplace_back(".objc_class_name_" + name.str());
       } else {
-        exports.emplace_back("_OBJC_CLASS_$_" + symbol->getName().str());
-        exports.emplace_back("_OBJC_METACLASS_$_" + symbol->getName().str());
+        exports.emplace_back("_OBJC_CLASS_$_" + name.str());
+        exports.emplace_back("_OBJC_METACLASS_$_" + name.str());
       }
       break;
     case SymbolKind::ObjectiveCClassEHType:
-      exports.emplace_back("_OBJC_EHTYPE_$_" + symbol->getName().str());
+      exports.emplace_back("_OBJC_EHTYPE_$_" + name.str());
       break;
     case SymbolKind::ObjectiveCInstanceVariable:
-      exports.emplace_back("_OBJC_IVAR_$_" + symbol->getName().str());
+      exports.emplace_back("_OBJC_IVAR_$_" + name.str());
       break;
     }
   }
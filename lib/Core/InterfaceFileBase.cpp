@@ -14,6 +14,7 @@
 
 #include "tapi/Core/InterfaceFileBase.h"
 #include "tapi/Core/STLExtras.h"
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 
@@ -21,9 +22,12 @@ using namespace llvm;
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
+char MergeError::ID = 0;
+
 namespace {
 template <typename C>
-typename C::iterator addEntry(C &container, StringRef installName) {
+typename C::iterator addEntry(C &container, StringPool &stringPool,
+                              StringRef installName) {
   auto it = lower_bound(container, installName,
                         [](const InterfaceFileRef &lhs, const StringRef &rhs) {
                           return lhs.getInstallName() < rhs;
@@ -31,19 +35,86 @@ typename C::iterator addEntry(C &container, StringRef installName) {
   if ((it != std::end(container)) && !(installName < it->getInstallName()))
     return it;
 
-  return container.emplace(it, installName);
+  return container.emplace(it, stringPool.intern(installName));
+}
+
+/// \brief Merge sorted, duplicate-free lists into one sorted list. Equal
+///        elements are folded into one with \p combine, in input order.
+template <typename T, typename Compare, typename Combine>
+std::vector<T> mergeSorted(ArrayRef<const std::vector<T> *> lists,
+                           Compare less, Combine combine) {
+  struct Cursor {
+    typename std::vector<T>::const_iterator current, end;
+    size_t list;
+  };
+
+  // std::*_heap functions build a max-heap, so order the cursors in reverse.
+  auto greater = [&](const Cursor &lhs, const Cursor &rhs) {
+    if (less(*rhs.current, *lhs.current))
+      return true;
+    if (less(*lhs.current, *rhs.current))
+      return false;
+    return lhs.list > rhs.list;
+  };
+
+  std::vector<Cursor> heap;
+  size_t size = 0;
+  for (size_t i = 0, e = lists.size(); i != e; ++i) {
+    size += lists[i]->size();
+    if (!lists[i]->empty())
+      heap.push_back({lists[i]->begin(), lists[i]->end(), i});
+  }
+  std::make_heap(heap.begin(), heap.end(), greater);
+
+  std::vector<T> result;
+  result.reserve(size);
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), greater);
+    auto &cursor = heap.back();
+    if (!result.empty() && !less(result.back(), *cursor.current))
+      combine(result.back(), *cursor.current);
+    else
+      result.push_back(*cursor.current);
+
+    if (++cursor.current == cursor.end)
+      heap.pop_back();
+    else
+      std::push_heap(heap.begin(), heap.end(), greater);
+  }
+
+  return result;
+}
+
+/// \brief The install names of the merged references are interned into
+///        \p stringPool, because the input files may use other pools.
+std::vector<InterfaceFileRef>
+mergeFileRefs(ArrayRef<const std::vector<InterfaceFileRef> *> lists,
+              StringPool &stringPool) {
+  auto refs = mergeSorted(
+      lists,
+      [](const InterfaceFileRef &lhs, const InterfaceFileRef &rhs) {
+        return lhs.getInstallName() < rhs.getInstallName();
+      },
+      [](InterfaceFileRef &lhs, const InterfaceFileRef &rhs) {
+        lhs.setArchitectures(rhs.getArchitectures());
+      });
+
+  for (auto &ref : refs)
+    ref = InterfaceFileRef(stringPool.intern(ref.getInstallName()),
+                           ref.getArchitectures());
+  return refs;
 }
 } // end anonymous namespace.
 
 void InterfaceFileBase::addAllowableClient(StringRef installName,
                                            ArchitectureSet archs) {
-  auto client = addEntry(_allowableClients, installName);
+  auto client = addEntry(_allowableClients, *_stringPool, installName);
   client->setArchitectures(archs);
 }
 
 void InterfaceFileBase::addReexportedLibrary(StringRef installName,
                                              ArchitectureSet archs) {
-  auto lib = addEntry(_reexportedLibraries, installName);
+  auto lib = addEntry(_reexportedLibraries, *_stringPool, installName);
   lib->setArchitectures(archs);
 }
 
@@ -86,4 +157,109 @@ void InterfaceFileBase::addUUID(uint8_t uuid[16], Architecture arch) {
   addUUID(arch, stream.str());
 }
 
+Error InterfaceFileBase::verifyMergeable(
+    ArrayRef<const InterfaceFileBase *> files) {
+  assert(!files.empty() && "expecting at least one file");
+  const auto *first = files.front();
+  auto archs = first->getArchitectures();
+  for (size_t i = 1, e = files.size(); i != e; ++i) {
+    const auto *file = files[i];
+    if (first->getFileType() != file->getFileType()) {
+      return make_error<MergeError>(i, "file types do not match");
+    }
+
+    if ((archs & file->getArchitectures()) != Architecture::unknown) {
+      return make_error<MergeError>(i, "architectures overlap");
+    }
+    archs |= file->getArchitectures();
+
+    if (first->getPlatform() != file->getPlatform()) {
+      return make_error<MergeError>(i, "platforms do not match");
+    }
+
+    if (first->getInstallName() != file->getInstallName()) {
+      return make_error<MergeError>(i, "install names do not match");
+    }
+
+    if (first->getCurrentVersion() != file->getCurrentVersion()) {
+      return make_error<MergeError>(i, "current versions do not match");
+    }
+
+    if (first->getCompatibilityVersion() != file->getCompatibilityVersion()) {
+      return make_error<MergeError>(i, "compatibility versions do not match");
+    }
+
+    if (first->getSwiftABIVersion() != file->getSwiftABIVersion()) {
+      return make_error<MergeError>(i, "swift ABI versions do not match");
+    }
+
+    if (first->isTwoLevelNamespace() != file->isTwoLevelNamespace()) {
+      return make_error<MergeError>(i,
+                                    "two level namespace flags do not match");
+    }
+
+    if (first->isApplicationExtensionSafe() !=
+        file->isApplicationExtensionSafe()) {
+      return make_error<MergeError>(
+          i, "application extension safe flags do not match");
+    }
+
+    if (first->isInstallAPI() != file->isInstallAPI()) {
+      return make_error<MergeError>(i, "installapi flags do not match");
+    }
+
+    if (first->getObjCConstraint() != file->getObjCConstraint()) {
+      return make_error<MergeError>(i, "installapi flags do not match");
+    }
+
+    if (first->getParentUmbrella() != file->getParentUmbrella()) {
+      return make_error<MergeError>(i, "parent umbrellas do not match");
+    }
+  }
+
+  return Error::success();
+}
+
+void InterfaceFileBase::mergeHeaders(
+    ArrayRef<const InterfaceFileBase *> files) {
+  assert(!files.empty() && "expecting at least one file");
+  const auto *first = files.front();
+  setFileType(first->getFileType());
+  setPath(first->getPath());
+  setPlatform(first->getPlatform());
+  setInstallName(first->getInstallName());
+  setCurrentVersion(first->getCurrentVersion());
+  setCompatibilityVersion(first->getCompatibilityVersion());
+  setSwiftABIVersion(first->getSwiftABIVersion());
+  setTwoLevelNamespace(first->isTwoLevelNamespace());
+  setApplicationExtensionSafe(first->isApplicationExtensionSafe());
+  setInstallAPI(first->isInstallAPI());
+  setObjCConstraint(first->getObjCConstraint());
+  setParentUmbrella(first->getParentUmbrella());
+
+  std::vector<const std::vector<InterfaceFileRef> *> clients, reexports;
+  std::vector<const std::vector<std::pair<Architecture, std::string>> *> uuids;
+  for (const auto *file : files) {
+    setArchitectures(file->getArchitectures());
+    clients.push_back(&file->allowableClients());
+    reexports.push_back(&file->reexportedLibraries());
+    uuids.push_back(&file->uuids());
+  }
+
+  _allowableClients = mergeFileRefs(clients, *_stringPool);
+  _reexportedLibraries = mergeFileRefs(reexports, *_stringPool);
+  // Like addUUID, a later UUID for the same architecture replaces the earlier
+  // one.
+  _uuids = mergeSorted(
+      makeArrayRef(uuids),
+      [](const std::pair<Architecture, std::string> &lhs,
+         const std::pair<Architecture, std::string> &rhs) {
+        return lhs.first < rhs.first;
+      },
+      [](std::pair<Architecture, std::string> &lhs,
+         const std::pair<Architecture, std::string> &rhs) {
+        lhs.second = rhs.second;
+      });
+}
+
 TAPI_NAMESPACE_INTERNAL_END
@@ -16,11 +16,24 @@
 #include "tapi/Core/ExtendedInterfaceFile.h"
 #include "tapi/Core/LLVM.h"
 #include "tapi/Core/XPI.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/BinaryFormat/Magic.h"
 #include "llvm/ObjCMetadata/ObjCMachOBinary.h"
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/MachOUniversal.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <thread>
 #include <tuple>
 
 using namespace llvm;
@@ -28,6 +41,174 @@ using namespace llvm::object;
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
+static Error malformedError(const Twine &message) {
+  return make_error<StringError>(
+      "malformed mach-o file: " + message,
+      std::make_error_code(std::errc::invalid_argument));
+}
+
+/// \brief Copy a structure out of the buffer. Returns false if the buffer is
+///        too small.
+template <typename T>
+static bool readStruct(StringRef buffer, uint64_t offset, T &result) {
+  if (offset > buffer.size() || buffer.size() - offset < sizeof(T))
+    return false;
+  memcpy(&result, buffer.data() + offset, sizeof(T));
+  return true;
+}
+
+namespace {
+
+/// \brief The mach header of a single Mach-O slice.
+///
+/// This is all that is needed to walk the load commands of a slice. Unlike
+/// MachOObjectFile it doesn't validate or index the symbol table and the
+/// sections up front.
+struct MachOSlice {
+  StringRef buffer;
+  MachO::mach_header header;
+  bool is64Bit;
+  bool swap;
+
+  bool isLittleEndian() const { return sys::IsLittleEndianHost != swap; }
+  Architecture getArch() const {
+    return getArchType(header.cputype, header.cpusubtype);
+  }
+};
+
+} // end anonymous namespace.
+
+/// \brief Read the mach header of a slice. Returns false if the slice is not a
+///        Mach-O file, for example because it is an archive.
+static Expected<bool> readSliceHeader(StringRef buffer, MachOSlice &slice) {
+  uint32_t magic;
+  if (!readStruct(buffer, 0, magic))
+    return false;
+
+  slice.buffer = buffer;
+  slice.is64Bit = magic == MachO::MH_MAGIC_64 || magic == MachO::MH_CIGAM_64;
+  slice.swap = magic == MachO::MH_CIGAM || magic == MachO::MH_CIGAM_64;
+  if (!slice.is64Bit && magic != MachO::MH_MAGIC && magic != MachO::MH_CIGAM)
+    return false;
+
+  // The 64-bit header only adds a reserved field at the end.
+  if (!readStruct(buffer, 0, slice.header))
+    return malformedError("truncated mach header");
+  if (slice.swap)
+    MachO::swapStruct(slice.header);
+  return true;
+}
+
+static MachOSlice getSlice(MachOObjectFile *object) {
+  return {object->getData(), object->getHeader(), object->is64Bit(),
+          object->isLittleEndian() != sys::IsLittleEndianHost};
+}
+
+/// \brief Call the handler with the command and the contents of every load
+///        command of the slice.
+static Error
+forEachLoadCommand(const MachOSlice &slice,
+                   function_ref<Error(uint32_t, StringRef)> handler) {
+  uint64_t offset = slice.is64Bit ? sizeof(MachO::mach_header_64)
+                                  : sizeof(MachO::mach_header);
+  uint64_t end = offset + slice.header.sizeofcmds;
+  if (end > slice.buffer.size())
+    return malformedError("load commands extend past the end of the file");
+
+  for (uint32_t i = 0; i < slice.header.ncmds; ++i) {
+    MachO::load_command loadCommand;
+    if (end - offset < sizeof(loadCommand) ||
+        !readStruct(slice.buffer, offset, loadCommand))
+      return malformedError("truncated load command");
+    if (slice.swap)
+      MachO::swapStruct(loadCommand);
+    if (loadCommand.cmdsize < sizeof(loadCommand) ||
+        loadCommand.cmdsize > end - offset)
+      return malformedError("invalid load command size");
+
+    auto error = handler(loadCommand.cmd,
+                         slice.buffer.substr(offset, loadCommand.cmdsize));
+    if (error)
+      return error;
+
+    offset += loadCommand.cmdsize;
+  }
+
+  return Error::success();
+}
+
+static bool isFatBinary(StringRef buffer) {
+  if (buffer.size() < sizeof(uint32_t))
+    return false;
+  // The fat header and the fat architectures are always big endian.
+  uint32_t magic = support::endian::read32be(buffer.data());
+  return magic == MachO::FAT_MAGIC || magic == MachO::FAT_MAGIC_64;
+}
+
+/// \brief Call the handler with the CPU type, the CPU subtype, and the contents
+///        of every slice of a universal binary.
+static Error
+forEachFatSlice(StringRef buffer,
+                function_ref<Error(uint32_t, uint32_t, StringRef)> handler) {
+  assert(isFatBinary(buffer) && "expected a universal binary");
+  MachO::fat_header header;
+  if (!readStruct(buffer, 0, header))
+    return malformedError("truncated fat header");
+  if (sys::IsLittleEndianHost)
+    MachO::swapStruct(header);
+
+  uint64_t offset = sizeof(header);
+  for (uint32_t i = 0; i < header.nfat_arch; ++i) {
+    uint32_t cpuType, cpuSubType;
+    uint64_t sliceOffset, sliceSize;
+    if (header.magic == MachO::FAT_MAGIC_64) {
+      MachO::fat_arch_64 arch;
+      if (!readStruct(buffer, offset, arch))
+        return malformedError("truncated fat architecture");
+      if (sys::IsLittleEndianHost)
+        MachO::swapStruct(arch);
+      cpuType = arch.cputype;
+      cpuSubType = arch.cpusubtype;
+      sliceOffset = arch.offset;
+      sliceSize = arch.size;
+      offset += sizeof(arch);
+    } else {
+      MachO::fat_arch arch;
+      if (!readStruct(buffer, offset, arch))
+        return malformedError("truncated fat architecture");
+      if (sys::IsLittleEndianHost)
+        MachO::swapStruct(arch);
+      cpuType = arch.cputype;
+      cpuSubType = arch.cpusubtype;
+      sliceOffset = arch.offset;
+      sliceSize = arch.size;
+      offset += sizeof(arch);
+    }
+
+    if (sliceOffset > buffer.size() || sliceSize > buffer.size() - sliceOffset)
+      return malformedError("slice extends past the end of the file");
+
+    auto error =
+        handler(cpuType, cpuSubType, buffer.substr(sliceOffset, sliceSize));
+    if (error)
+      return error;
+  }
+
+  return Error::success();
+}
+
+/// \brief Read a string that is stored in a load command.
+static Expected<StringRef> readLoadCommandString(StringRef command,
+                                                 uint32_t offset) {
+  if (offset >= command.size())
+    return malformedError("string offset past the end of the load command");
+  auto str = command.drop_front(offset);
+  auto size = str.find('\0');
+  if (size == StringRef::npos)
+    return malformedError("string extends past the end of the load command");
+  return str.take_front(size);
+}
+
 Expected<FileType>
 MachODylibReader::getFileType(file_magic magic,
                               MemoryBufferRef bufferRef) const {
@@ -43,44 +224,49 @@ MachODylibReader::getFileType(file_magic magic,
     break;
   }
 
-  auto binaryOrErr = createBinary(bufferRef);
-  if (!binaryOrErr)
-    return binaryOrErr.takeError();
-
-  Binary &bin = *binaryOrErr.get();
-  assert(isa<MachOUniversalBinary>(&bin) && "Unexpected MachO binary");
-  auto *UB = cast<MachOUniversalBinary>(&bin);
-
   FileType fileType = FileType::Invalid;
-  // Check if any of the architecture slices are a MachO dylib.
-  for (auto OI = UB->begin_objects(), OE = UB->end_objects(); OI != OE; ++OI) {
-    // This can fail if the object is an archive.
-    auto objOrErr = OI->getAsObjectFile();
-    // Skip the archive and comsume the error.
-    if (!objOrErr) {
-      consumeError(objOrErr.takeError());
-      continue;
-    }
+  bool mixedFileTypes = false;
+  // Check if any of the architecture slices are a MachO dylib. Only the mach
+  // header of each slice is needed for that.
+  auto error = forEachFatSlice(
+      bufferRef.getBuffer(),
+      [&](uint32_t, uint32_t, StringRef buffer) -> Error {
+        if (mixedFileTypes)
+          return Error::success();
+
+        MachOSlice slice;
+        auto isMachO = readSliceHeader(buffer, slice);
+        if (!isMachO)
+          return isMachO.takeError();
+        // Skip archives.
+        if (!*isMachO)
+          return Error::success();
+
+        switch (slice.header.filetype) {
+        default:
+          break;
+        case MachO::MH_BUNDLE: // Assume dylib for now.
+        case MachO::MH_DYLIB:
+          if (fileType == FileType::Invalid)
+            fileType = FileType::MachO_DynamicLibrary;
+          else if (fileType != FileType::MachO_DynamicLibrary)
+            mixedFileTypes = true;
+          break;
+        case MachO::MH_DYLIB_STUB:
+          if (fileType == FileType::Invalid)
+            fileType = FileType::MachO_DynamicLibrary_Stub;
+          else if (fileType != FileType::MachO_DynamicLibrary_Stub)
+            mixedFileTypes = true;
+          break;
+        }
+        return Error::success();
+      });
+  if (error)
+    return std::move(error);
 
-    auto &obj = *objOrErr.get();
-    switch (obj.getHeader().filetype) {
-    default:
-      continue;
-    case MachO::MH_BUNDLE: // Assume dylib for now.
-    case MachO::MH_DYLIB:
-      if (fileType == FileType::Invalid)
-        fileType = FileType::MachO_DynamicLibrary;
-      else if (fileType != FileType::MachO_DynamicLibrary)
-        return FileType::Invalid;
-      break;
-    case MachO::MH_DYLIB_STUB:
-      if (fileType == FileType::Invalid)
-        fileType = FileType::MachO_DynamicLibrary_Stub;
-      else if (fileType != FileType::MachO_DynamicLibrary_Stub)
-        return FileType::Invalid;
-      break;
-    }
-  }
+  // Mixing dylib and stub slices is not supported.
+  if (mixedFileTypes)
+    return FileType::Invalid;
 
   return fileType;
 }
@@ -123,10 +309,66 @@ static std::tuple<StringRef, XPIKind> parseSymbol(StringRef symbolName) {
   return std::make_tuple(name, kind);
 }
 
-static Error readMachOHeaderData(MachOObjectFile *object,
+static void readObjCImageInfo(StringRef content, bool isLittleEndian,
+                              ExtendedInterfaceFile *file) {
+  if ((content.size() < 8) || (content[0] != 0))
+    return;
+
+  uint32_t flags = isLittleEndian
+                       ? support::endian::read32le(content.data() + 4)
+                       : support::endian::read32be(content.data() + 4);
+  if ((flags & 4) == 4)
+    file->setObjCConstraint(ObjCConstraint::GC);
+  else if ((flags & 2) == 2)
+    file->setObjCConstraint(ObjCConstraint::Retain_Release_Or_GC);
+  else if ((flags & 32) == 32)
+    file->setObjCConstraint(ObjCConstraint::Retain_Release_For_Simulator);
+  else
+    file->setObjCConstraint(ObjCConstraint::Retain_Release);
+
+  file->setSwiftABIVersion(((flags >> 8) & 0xFF));
+}
+
+/// \brief Read the Objective-C image info from the section headers of a
+///        segment load command.
+template <typename SegmentCommand, typename Section>
+static Error readSegmentObjCImageInfo(const MachOSlice &slice,
+                                      StringRef command,
+                                      ExtendedInterfaceFile *file) {
+  SegmentCommand segment;
+  if (!readStruct(command, 0, segment))
+    return malformedError("truncated segment load command");
+  if (slice.swap)
+    MachO::swapStruct(segment);
+
+  uint64_t offset = sizeof(segment);
+  for (uint32_t i = 0; i < segment.nsects; ++i, offset += sizeof(Section)) {
+    Section section;
+    if (!readStruct(command, offset, section))
+      return malformedError("truncated section header");
+    if (slice.swap)
+      MachO::swapStruct(section);
+
+    StringRef sectionName(section.sectname,
+                          strnlen(section.sectname, sizeof(section.sectname)));
+    if (sectionName != "__objc_imageinfo" && sectionName != "__image_info")
+      continue;
+
+    // The contents are clamped to the slice, like by
+    // MachOObjectFile::getSectionContents.
+    readObjCImageInfo(slice.buffer.substr(section.offset, section.size),
+                      slice.isLittleEndian(), file);
+  }
+
+  return Error::success();
+}
+
+/// \brief Read the header data of a slice. Only the mach header, the load
+///        commands, and the Objective-C image info are read.
+static Error readMachOHeaderData(const MachOSlice &slice,
                                  ExtendedInterfaceFile *file) {
-  auto H = object->getHeader();
-  auto arch = getArchType(H.cputype, H.cpusubtype);
+  const auto &H = slice.header;
+  auto arch = slice.getArch();
   if (arch == Architecture::unknown)
     return make_error<StringError>(
         "unknown/unsupported architecture",
@@ -143,32 +385,56 @@ static Error readMachOHeaderData(MachOObjectFile *object,
   if (H.flags & MachO::MH_APP_EXTENSION_SAFE)
     file->setApplicationExtensionSafe();
 
-  for (const auto &LCI : object->load_commands()) {
-    switch (LCI.C.cmd) {
-    case MachO::LC_ID_DYLIB: {
-      auto DLLC = object->getDylibIDLoadCommand(LCI);
-      file->setInstallName(LCI.Ptr + DLLC.dylib.name);
-      file->setCurrentVersion(DLLC.dylib.current_version);
-      file->setCompatibilityVersion(DLLC.dylib.compatibility_version);
-      break;
-    }
+  return forEachLoadCommand(slice, [&](uint32_t cmd,
+                                       StringRef command) -> Error {
+    switch (cmd) {
+    case MachO::LC_ID_DYLIB:
     case MachO::LC_REEXPORT_DYLIB: {
-      auto DLLC = object->getDylibIDLoadCommand(LCI);
-      file->addReexportedLibrary(LCI.Ptr + DLLC.dylib.name, arch);
+      MachO::dylib_command DLLC;
+      if (!readStruct(command, 0, DLLC))
+        return malformedError("truncated dylib load command");
+      if (slice.swap)
+        MachO::swapStruct(DLLC);
+      auto name = readLoadCommandString(command, DLLC.dylib.name);
+      if (!name)
+        return name.takeError();
+      if (cmd == MachO::LC_REEXPORT_DYLIB) {
+        file->addReexportedLibrary(*name, arch);
+      } else {
+        file->setInstallName(*name);
+        file->setCurrentVersion(DLLC.dylib.current_version);
+        file->setCompatibilityVersion(DLLC.dylib.compatibility_version);
+      }
       break;
     }
     case MachO::LC_SUB_FRAMEWORK: {
-      auto SFC = object->getSubFrameworkCommand(LCI);
-      file->setParentUmbrella(LCI.Ptr + SFC.umbrella);
+      MachO::sub_framework_command SFC;
+      if (!readStruct(command, 0, SFC))
+        return malformedError("truncated sub framework load command");
+      if (slice.swap)
+        MachO::swapStruct(SFC);
+      auto umbrella = readLoadCommandString(command, SFC.umbrella);
+      if (!umbrella)
+        return umbrella.takeError();
+      file->setParentUmbrella(*umbrella);
       break;
     }
     case MachO::LC_SUB_CLIENT: {
-      auto SCLC = object->getSubClientCommand(LCI);
-      file->addAllowableClient(LCI.Ptr + SCLC.client, arch);
+      MachO::sub_client_command SCLC;
+      if (!readStruct(command, 0, SCLC))
+        return malformedError("truncated sub client load command");
+      if (slice.swap)
+        MachO::swapStruct(SCLC);
+      auto client = readLoadCommandString(command, SCLC.client);
+      if (!client)
+        return client.takeError();
+      file->addAllowableClient(*client, arch);
       break;
     }
     case MachO::LC_UUID: {
-      auto UUIDLC = object->getUuidCommand(LCI);
+      MachO::uuid_command UUIDLC;
+      if (!readStruct(command, 0, UUIDLC))
+        return malformedError("invalid LC_UUID load command");
       file->addUUID(UUIDLC.uuid, arch);
       break;
     }
@@ -185,7 +451,11 @@ static Error readMachOHeaderData(MachOObjectFile *object,
       file->setPlatform(Platform::tvOS);
       break;
     case MachO::LC_BUILD_VERSION: {
-      auto BVC = object->getBuildVersionLoadCommand(LCI);
+      MachO::build_version_command BVC;
+      if (!readStruct(command, 0, BVC))
+        return malformedError("truncated build version load command");
+      if (slice.swap)
+        MachO::swapStruct(BVC);
       switch (BVC.platform) {
       default:
         return make_error<StringError>(
@@ -209,78 +479,142 @@ static Error readMachOHeaderData(MachOObjectFile *object,
       }
       break;
     }
+    case MachO::LC_SEGMENT:
+      return readSegmentObjCImageInfo<MachO::segment_command, MachO::section>(
+          slice, command, file);
+    case MachO::LC_SEGMENT_64:
+      return readSegmentObjCImageInfo<MachO::segment_command_64,
+                                      MachO::section_64>(slice, command, file);
     default:
       break;
     }
-  }
+    return Error::success();
+  });
+}
 
-  for (auto &section : object->sections()) {
-    StringRef sectionName;
-    section.getName(sectionName);
-    if (sectionName != "__objc_imageinfo" && sectionName != "__image_info")
-      continue;
-    StringRef content;
-    section.getContents(content);
-    if ((content.size() >= 8) && (content[0] == 0)) {
-      uint32_t flags;
-      if (object->isLittleEndian()) {
-        auto *p =
-            reinterpret_cast<const support::ulittle32_t *>(content.data() + 4);
-        flags = *p;
-      } else {
-        auto *p =
-            reinterpret_cast<const support::ubig32_t *>(content.data() + 4);
-        flags = *p;
+/// \brief Receives the kind, name, and flags of every symbol that is read.
+using SymbolCallback = function_ref<void(XPIKind, StringRef, SymbolFlags)>;
+
+/// \brief Walk the export trie of a slice.
+///
+/// The trie is walked depth first with an explicit stack. A terminal node is
+/// reported when it is pushed, before its children (pre-order). This differs
+/// from llvm::object::ExportEntry, which reports a terminal node with children
+/// after them, so "_foo" is reported before "_foobar" here. The XPI set sorts
+/// the symbols, so the order doesn't matter to the reader. The name of the
+/// current node is built in a single buffer that is reused for every symbol,
+/// so the callback has to copy the name if it wants to keep it. Only the flags
+/// of a terminal node are decoded; the remaining terminal information is
+/// skipped with the terminal size.
+static Error readExportedSymbols(MachOObjectFile *object,
+                                 SymbolCallback addSymbol) {
+  auto trie = object->getDyldInfoExportsTrie();
+  if (trie.empty())
+    return Error::success();
+
+  const uint8_t *start = trie.begin();
+  const uint8_t *end = trie.end();
+
+  auto readULEB128 = [end](const uint8_t *&p, uint64_t &value) -> bool {
+    unsigned count;
+    const char *error = nullptr;
+    value = decodeULEB128(p, &count, end, &error);
+    if (error)
+      return false;
+    p += count;
+    return true;
+  };
+
+  struct Node {
+    uint64_t offset;
+    size_t nameSize;
+    const uint8_t *nextChild;
+    unsigned remainingChildren;
+  };
+  SmallVector<Node, 16> stack;
+  SmallString<256> name;
+
+  // Decode the terminal information of the node and push it onto the stack.
+  auto pushNode = [&](uint64_t offset) -> Error {
+    for (const auto &node : stack)
+      if (node.offset == offset)
+        return malformedError("loop in export trie at offset " +
+                              Twine(offset));
+
+    const uint8_t *p = start + offset;
+    uint64_t terminalSize;
+    if (!readULEB128(p, terminalSize))
+      return malformedError("invalid export trie terminal size at offset " +
+                            Twine(offset));
+    if (terminalSize >= uint64_t(end - p))
+      return malformedError("export trie terminal at offset " +
+                            Twine(offset) + " extends past the end");
+    const uint8_t *children = p + terminalSize;
+
+    if (terminalSize != 0) {
+      uint64_t exportFlags;
+      if (!readULEB128(p, exportFlags) || p > children)
+        return malformedError("invalid export trie flags at offset " +
+                              Twine(offset));
+
+      SymbolFlags flags = SymbolFlags::None;
+      switch (exportFlags & MachO::EXPORT_SYMBOL_FLAGS_KIND_MASK) {
+      case MachO::EXPORT_SYMBOL_FLAGS_KIND_REGULAR:
+        if (exportFlags & MachO::EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION)
+          flags = SymbolFlags::WeakDefined;
+        break;
+      case MachO::EXPORT_SYMBOL_FLAGS_KIND_THREAD_LOCAL:
+        flags = SymbolFlags::ThreadLocalValue;
+        break;
       }
-      if ((flags & 4) == 4)
-        file->setObjCConstraint(ObjCConstraint::GC);
-      else if ((flags & 2) == 2)
-        file->setObjCConstraint(ObjCConstraint::Retain_Release_Or_GC);
-      else if ((flags & 32) == 32)
-        file->setObjCConstraint(ObjCConstraint::Retain_Release_For_Simulator);
-      else
-        file->setObjCConstraint(ObjCConstraint::Retain_Release);
-
-      file->setSwiftABIVersion(((flags >> 8) & 0xFF));
+
+      StringRef symbolName;
+      XPIKind kind;
+      std::tie(symbolName, kind) = parseSymbol(name);
+      addSymbol(kind, symbolName, flags);
     }
-  }
 
-  return Error::success();
-}
+    stack.push_back({offset, name.size(), children + 1, *children});
+    return Error::success();
+  };
 
-static Error readExportedSymbols(MachOObjectFile *object,
-                                 ExtendedInterfaceFile *file) {
-  auto H = object->getHeader();
-  auto arch = getArchType(H.cputype, H.cpusubtype);
-  assert(arch != Architecture::unknown && "unknown architecture slice");
+  if (auto error = pushNode(0))
+    return error;
 
-  Error error = Error::success();
-  for (const auto &symbol : object->exports(error)) {
-    StringRef name;
-    XPIKind kind;
-    std::tie(name, kind) = parseSymbol(symbol.name());
-    SymbolFlags flags = SymbolFlags::None;
-    switch (symbol.flags() & MachO::EXPORT_SYMBOL_FLAGS_KIND_MASK) {
-    case MachO::EXPORT_SYMBOL_FLAGS_KIND_REGULAR:
-      if (symbol.flags() & MachO::EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION)
-        flags = SymbolFlags::WeakDefined;
-      break;
-    case MachO::EXPORT_SYMBOL_FLAGS_KIND_THREAD_LOCAL:
-      flags = SymbolFlags::ThreadLocalValue;
-      break;
+  while (!stack.empty()) {
+    auto &node = stack.back();
+    if (node.remainingChildren == 0) {
+      stack.pop_back();
+      continue;
     }
-    file->addSymbol(kind, name, arch, flags);
+    --node.remainingChildren;
+
+    const uint8_t *p = node.nextChild;
+    auto *edgeEnd =
+        static_cast<const uint8_t *>(memchr(p, '\0', end - p));
+    if (!edgeEnd)
+      return malformedError("unterminated export trie edge at offset " +
+                            Twine(node.offset));
+    name.resize(node.nameSize);
+    name.append(p, edgeEnd);
+
+    p = edgeEnd + 1;
+    uint64_t childOffset;
+    if (!readULEB128(p, childOffset) || childOffset >= trie.size())
+      return malformedError("invalid export trie child offset at offset " +
+                            Twine(node.offset));
+    node.nextChild = p;
+
+    // Pushing the child may reallocate the stack.
+    if (auto error = pushNode(childOffset))
+      return error;
   }
 
-  return error;
+  return Error::success();
 }
 
 static Error readUndefinedSymbols(MachOObjectFile *object,
-                                  ExtendedInterfaceFile *file) {
-  auto H = object->getHeader();
-  auto arch = getArchType(H.cputype, H.cpusubtype);
-  assert(arch != Architecture::unknown && "unknown architecture slice");
-
+                                  SymbolCallback addSymbol) {
   for (const auto &symbol : object->symbols()) {
     auto symbolFlags = symbol.getFlags();
     if ((symbolFlags & BasicSymbolRef::SF_Global) == 0)
@@ -298,7 +632,7 @@ static Error readUndefinedSymbols(MachOObjectFile *object,
     StringRef name;
     XPIKind kind;
     std::tie(name, kind) = parseSymbol(symbolName.get());
-    file->addUndefinedSymbol(kind, name, arch, flags);
+    addSymbol(kind, name, flags);
   }
 
   return Error::success();
@@ -580,16 +914,26 @@ static Error readObjectiveCMetadata(MachOObjectFile *object,
   return Error::success();
 }
 
+static Architecture getArch(MachOObjectFile *object) {
+  auto H = object->getHeader();
+  return getArchType(H.cputype, H.cpusubtype);
+}
+
 static Error load(MachOObjectFile *object, ExtendedInterfaceFile *file,
                   ReadFlags readFlags) {
   if (readFlags >= ReadFlags::Header) {
-    auto error = readMachOHeaderData(object, file);
+    auto error = readMachOHeaderData(getSlice(object), file);
     if (error)
       return error;
   }
 
+  auto arch = getArch(object);
   if (readFlags >= ReadFlags::Symbols) {
-    auto error = readExportedSymbols(object, file);
+    assert(arch != Architecture::unknown && "unknown architecture slice");
+    auto error = readExportedSymbols(
+        object, [&](XPIKind kind, StringRef name, SymbolFlags flags) {
+          file->addSymbol(kind, name, arch, flags);
+        });
     if (error)
       return error;
   }
@@ -605,7 +949,182 @@ static Error load(MachOObjectFile *object, ExtendedInterfaceFile *file,
     return Error::success();
 
   if (readFlags >= ReadFlags::Symbols)
-    return readUndefinedSymbols(object, file);
+    return readUndefinedSymbols(
+        object, [&](XPIKind kind, StringRef name, SymbolFlags flags) {
+          file->addUndefinedSymbol(kind, name, arch, flags);
+        });
+
+  return Error::success();
+}
+
+namespace {
+
+/// \brief A symbol that was decoded from an architecture slice.
+struct DecodedSymbol {
+  XPIKind kind;
+  StringRef name;
+  SymbolFlags flags;
+};
+
+/// \brief The symbols of one architecture slice of a universal binary.
+///
+/// The slices of a large binary are decoded concurrently into their own
+/// buffers and added to the interface file in slice order afterwards.
+struct SliceSymbols {
+  std::unique_ptr<MachOObjectFile> object;
+  BumpPtrAllocator allocator;
+  std::vector<DecodedSymbol> exports;
+  std::vector<DecodedSymbol> undefineds;
+  Error exportsError = Error::success();
+  Error undefinedsError = Error::success();
+
+  SliceSymbols() = default;
+  ~SliceSymbols() {
+    // The errors of slices after a failing slice are never looked at.
+    consumeError(std::move(exportsError));
+    consumeError(std::move(undefinedsError));
+  }
+};
+
+} // end anonymous namespace.
+
+/// \brief Universal binaries whose slices are smaller than this in total are
+///        decoded on the calling thread. Below that, handing the slices to
+///        other threads costs more than decoding them.
+static const uint64_t MinParallelDecodeSize = 1024 * 1024;
+
+/// \brief The threads that decode the slices of large universal binaries.
+///
+/// The pool is shared by all reads, so reading many files at once (e.g. with
+/// LinkerInterfaceFile::createBatch) doesn't start a set of threads per file.
+/// The tasks never wait on other tasks, so a read that runs on a thread of
+/// another pool can safely wait for its slices.
+static ManagedStatic<ThreadPool> sliceDecodingPool;
+
+/// \brief Decode the exported and undefined symbols of a slice. This doesn't
+///        touch the interface file, so the slices can be decoded concurrently.
+static void decodeSlice(SliceSymbols &slice, ReadFlags readFlags) {
+  auto *object = slice.object.get();
+  // Unknown architectures are reported when the header data is read.
+  if (readFlags < ReadFlags::Symbols ||
+      getArch(object) == Architecture::unknown)
+    return;
+
+  auto record = [&slice](std::vector<DecodedSymbol> &symbols) {
+    return [&slice, &symbols](XPIKind kind, StringRef name,
+                              SymbolFlags flags) {
+      // The export trie walker reuses the buffer of the name.
+      symbols.push_back({kind, name.copy(slice.allocator), flags});
+    };
+  };
+
+  ErrorAsOutParameter exportsError(&slice.exportsError);
+  slice.exportsError = readExportedSymbols(object, record(slice.exports));
+  if (slice.exportsError)
+    return;
+
+  // A two-level namespace slice makes the whole file two-level namespace
+  // before its undefined symbols would be read.
+  if (object->getHeader().flags & MachO::MH_TWOLEVEL)
+    return;
+
+  ErrorAsOutParameter undefinedsError(&slice.undefinedsError);
+  slice.undefinedsError =
+      readUndefinedSymbols(object, record(slice.undefineds));
+}
+
+/// \brief Add a decoded slice to the interface file. This makes the same
+///        changes to the file in the same order as load().
+static Error addSlice(SliceSymbols &slice, ExtendedInterfaceFile *file,
+                      ReadFlags readFlags) {
+  auto *object = slice.object.get();
+  if (readFlags >= ReadFlags::Header) {
+    auto error = readMachOHeaderData(getSlice(object), file);
+    if (error)
+      return error;
+  }
+
+  auto arch = getArch(object);
+  if (readFlags >= ReadFlags::Symbols) {
+    if (slice.exportsError)
+      return std::move(slice.exportsError);
+    for (const auto &symbol : slice.exports)
+      file->addSymbol(symbol.kind, symbol.name, arch, symbol.flags);
+  }
+
+  if (readFlags >= ReadFlags::ObjCMetadata) {
+    auto error = readObjectiveCMetadata(object, file);
+    if (error)
+      return error;
+  }
+
+  // Only record undef symbols for flat namespace dylibs.
+  if (file->isTwoLevelNamespace())
+    return Error::success();
+
+  if (readFlags >= ReadFlags::Symbols) {
+    if (slice.undefinedsError)
+      return std::move(slice.undefinedsError);
+    for (const auto &symbol : slice.undefineds)
+      file->addUndefinedSymbol(symbol.kind, symbol.name, arch, symbol.flags);
+  }
+
+  return Error::success();
+}
+
+/// \brief Read only the header data of a file. This walks the load commands of
+///        each slice directly and never creates a MachOObjectFile, which would
+///        validate and index the symbol table and the sections first.
+static Error loadHeader(StringRef buffer, ExtendedInterfaceFile *file,
+                        ArchitectureSet arches) {
+  if (!isFatBinary(buffer)) {
+    MachOSlice slice;
+    auto isMachO = readSliceHeader(buffer, slice);
+    if (!isMachO)
+      return isMachO.takeError();
+    if (!*isMachO)
+      return malformedError("not a mach-o file");
+
+    if (!arches.has(slice.getArch()))
+      return make_error<StringError>(
+          "Requested architectures don't exist",
+          std::make_error_code(std::errc::not_supported));
+
+    return readMachOHeaderData(slice, file);
+  }
+
+  bool foundArch = false;
+  auto error = forEachFatSlice(
+      buffer,
+      [&](uint32_t cpuType, uint32_t cpuSubType, StringRef buffer) -> Error {
+        // Skip the architecture that is not requested.
+        if (!arches.has(getArchType(cpuType, cpuSubType)))
+          return Error::success();
+
+        foundArch = true;
+        MachOSlice slice;
+        auto isMachO = readSliceHeader(buffer, slice);
+        if (!isMachO)
+          return isMachO.takeError();
+        // Skip archives.
+        if (!*isMachO)
+          return Error::success();
+
+        switch (slice.header.filetype) {
+        default:
+          return Error::success();
+        case MachO::MH_DYLIB:
+        case MachO::MH_DYLIB_STUB:
+          return readMachOHeaderData(slice, file);
+        }
+      });
+  if (error)
+    return error;
+
+  if (!foundArch)
+    return make_error<StringError>(
+        "Requested architectures don't exist",
+        std::make_error_code(std::errc::not_supported));
 
   return Error::success();
 }
@@ -617,6 +1136,14 @@ MachODylibReader::readFile(std::unique_ptr<MemoryBuffer> memBuffer,
   file->setPath(memBuffer->getBufferIdentifier());
   file->setMemoryBuffer(std::move(memBuffer));
 
+  if (readFlags == ReadFlags::Header) {
+    auto error =
+        loadHeader(file->getMemBufferRef().getBuffer(), file.get(), arches);
+    if (error)
+      return std::move(error);
+    return std::move(file);
+  }
+
   auto binaryOrErr = createBinary(file->getMemBufferRef());
   if (!binaryOrErr)
     return binaryOrErr.takeError();
@@ -642,6 +1169,7 @@ MachODylibReader::readFile(std::unique_ptr<MemoryBuffer> memBuffer,
   auto *UB = cast<MachOUniversalBinary>(&binary);
 
   bool foundArch = false;
+  std::vector<std::unique_ptr<MachOObjectFile>> objects;
   for (auto OI = UB->begin_objects(), OE = UB->end_objects(); OI != OE; ++OI) {
     // Skip the architecture that is not requested.
     auto arch = getArchType(OI->getCPUType(), OI->getCPUSubType());
@@ -658,15 +1186,12 @@ MachODylibReader::readFile(std::unique_ptr<MemoryBuffer> memBuffer,
       continue;
     }
 
-    auto &object = *objOrErr.get();
-    switch (object.getHeader().filetype) {
+    switch (objOrErr.get()->getHeader().filetype) {
     default:
       break;
     case MachO::MH_DYLIB:
     case MachO::MH_DYLIB_STUB:
-      auto error = load(&object, file.get(), readFlags);
-      if (error)
-        return std::move(error);
+      objects.emplace_back(std::move(objOrErr.get()));
       break;
     }
   }
@@ -676,7 +1201,136 @@ MachODylibReader::readFile(std::unique_ptr<MemoryBuffer> memBuffer,
         "Requested architectures don't exist",
         std::make_error_code(std::errc::not_supported));
 
+  uint64_t size = 0;
+  for (const auto &object : objects)
+    size += object->getData().size();
+
+  if (readFlags < ReadFlags::Symbols || objects.size() <= 1 ||
+      size < MinParallelDecodeSize ||
+      std::thread::hardware_concurrency() <= 1) {
+    for (auto &object : objects) {
+      auto error = load(object.get(), file.get(), readFlags);
+      if (error)
+        return std::move(error);
+    }
+    return std::move(file);
+  }
+
+  // Decoding the export trie and the symbol table of a slice doesn't depend
+  // on the other slices, so decode them concurrently. Adding the slices to
+  // the file in slice order afterwards yields the exact same file as loading
+  // them one after the other. Only wait for the slices of this file, the
+  // shared pool may also be decoding other files.
+  std::vector<SliceSymbols> slices(objects.size());
+  std::vector<std::shared_future<void>> decoded;
+  decoded.reserve(objects.size());
+  for (size_t i = 0; i < objects.size(); ++i) {
+    slices[i].object = std::move(objects[i]);
+    decoded.emplace_back(sliceDecodingPool->async(
+        [&slices, i, readFlags]() { decodeSlice(slices[i], readFlags); }));
+  }
+  for (auto &future : decoded)
+    future.wait();
+
+  for (auto &slice : slices) {
+    auto error = addSlice(slice, file.get(), readFlags);
+    if (error)
+      return std::move(error);
+  }
+
   return std::move(file);
 }
 
+using UUIDList = std::vector<std::pair<Architecture, std::string>>;
+
+/// \brief Walk the load commands of a single Mach-O slice and record its UUID.
+///        Returns false if the slice is not a dynamic library.
+static Expected<bool> readSliceUUID(StringRef buffer, bool allowBundle,
+                                    UUIDList &uuids) {
+  MachOSlice slice;
+  auto isMachO = readSliceHeader(buffer, slice);
+  if (!isMachO || !*isMachO)
+    return isMachO;
+
+  switch (slice.header.filetype) {
+  default:
+    return false;
+  case MachO::MH_BUNDLE:
+    if (!allowBundle)
+      return false;
+    break;
+  case MachO::MH_DYLIB:
+  case MachO::MH_DYLIB_STUB:
+    break;
+  }
+
+  // Only the first LC_UUID load command is recorded.
+  bool foundUUID = false;
+  auto error = forEachLoadCommand(slice, [&](uint32_t cmd,
+                                             StringRef command) -> Error {
+    if (cmd != MachO::LC_UUID || foundUUID)
+      return Error::success();
+
+    MachO::uuid_command uuidCommand;
+    if (!readStruct(command, 0, uuidCommand))
+      return malformedError("invalid LC_UUID load command");
+
+    std::string uuid;
+    raw_string_ostream stream(uuid);
+    for (unsigned j = 0; j < 16; ++j) {
+      if (j == 4 || j == 6 || j == 8 || j == 10)
+        stream << '-';
+      stream << format_hex_no_prefix(uuidCommand.uuid[j], 2,
+                                     /*Upper=*/true);
+    }
+    uuids.emplace_back(slice.getArch(), stream.str());
+    foundUUID = true;
+    return Error::success();
+  });
+  if (error)
+    return std::move(error);
+
+  return true;
+}
+
+Expected<UUIDList> readMachOUUIDs(MemoryBufferRef bufferRef) {
+  auto buffer = bufferRef.getBuffer();
+  if (buffer.size() < sizeof(uint32_t))
+    return malformedError("file too small");
+
+  UUIDList uuids;
+  bool foundDylib = false;
+  if (isFatBinary(buffer)) {
+    auto error = forEachFatSlice(
+        buffer, [&](uint32_t, uint32_t, StringRef slice) -> Error {
+          // Archives and other non-dylib slices are skipped, the same way the
+          // dylib reader does.
+          auto isDylib = readSliceUUID(slice, /*allowBundle=*/false, uuids);
+          if (!isDylib)
+            return isDylib.takeError();
+          foundDylib |= *isDylib;
+          return Error::success();
+        });
+    if (error)
+      return std::move(error);
+  } else {
+    auto isDylib = readSliceUUID(buffer, /*allowBundle=*/true, uuids);
+    if (!isDylib)
+      return isDylib.takeError();
+    foundDylib = *isDylib;
+  }
+
+  if (!foundDylib)
+    return make_error<StringError>(
+        "file is not a mach-o dynamic library",
+        std::make_error_code(std::errc::not_supported));
+
+  std::stable_sort(uuids.begin(), uuids.end(),
+                   [](const std::pair<Architecture, std::string> &lhs,
+                      const std::pair<Architecture, std::string> &rhs) {
+                     return lhs.first < rhs.first;
+                   });
+  return std::move(uuids);
+}
+
 TAPI_NAMESPACE_INTERNAL_END
@@ -19,6 +19,8 @@
 #include "tapi/Core/TextAPI_v1.h"
 #include "tapi/Core/TextStub_v1.h"
 #include "tapi/Core/TextStub_v2.h"
+#include "tapi/Core/TextStubReader.h"
+#include "tapi/Core/TextStubWriter.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
@@ -27,6 +29,9 @@ using namespace llvm;
 
 TAPI_NAMESPACE_INTERNAL_BEGIN
 
+/// \brief The buffer size for writing files.
+static constexpr size_t OutputBufferSize = 1024 * 1024;
+
 bool Registry::canRead(MemoryBufferRef memBuffer, FileType types) const {
   auto data = memBuffer.getBuffer();
   auto magic = identify_magic(data);
@@ -84,6 +89,9 @@ Error Registry::writeFile(const File *file) const {
   raw_fd_ostream os(file->getPath(), ec, sys::fs::F_Text);
   if (ec)
     return errorCodeToError(ec);
+  // Text-based files of large libraries are several megabytes. Write them in
+  // large chunks instead of the default block size of the file system.
+  os.SetBufferSize(OutputBufferSize);
   auto error = writeFile(os, file);
   if (error)
     return error;
@@ -108,7 +116,7 @@ void Registry::addBinaryReaders() {
   add(std::unique_ptr<Reader>(new MachODylibReader));
 }
 
-void Registry::addYAMLReaders() {
+void Registry::addYAMLReaders(bool useTextStubReader) {
   auto reader = make_unique<YAMLReader>();
   reader->add(
       std::unique_ptr<DocumentHandler>(new stub::v1::YAMLDocumentHandler));
@@ -118,10 +126,16 @@ void Registry::addYAMLReaders() {
       std::unique_ptr<DocumentHandler>(new api::v1::YAMLDocumentHandler));
   reader->add(std::unique_ptr<DocumentHandler>(
       new configuration::v1::YAMLDocumentHandler));
+
+  // The text stub reader handles well-formed text-based stub files and falls
+  // back to the generic YAML reader for everything else. It has to come first,
+  // because the first reader that can read a file wins.
+  if (useTextStubReader)
+    add(std::unique_ptr<Reader>(new TextStubReader(*reader)));
   add(std::unique_ptr<Reader>(std::move(reader)));
 }
 
-void Registry::addYAMLWriters() {
+void Registry::addYAMLWriters(bool useTextStubWriter) {
   auto writer = make_unique<YAMLWriter>();
   writer->add(
       std::unique_ptr<DocumentHandler>(new stub::v1::YAMLDocumentHandler));
@@ -129,6 +143,12 @@ void Registry::addYAMLWriters() {
       std::unique_ptr<DocumentHandler>(new stub::v2::YAMLDocumentHandler));
   writer->add(
       std::unique_ptr<DocumentHandler>(new api::v1::YAMLDocumentHandler));
+
+  // The text stub writer streams the documents directly to the output and
+  // falls back to the generic YAML writer for everything else. It has to come
+  // first, because the first writer that can write a file wins.
+  if (useTextStubWriter)
+    add(std::unique_ptr<Writer>(new TextStubWriter(*writer)));
   add(std::unique_ptr<Writer>(std::move(writer)));
 }
 
@@ -0,0 +1,39 @@
+//===- lib/Core/StringPool.cpp - String Pool --------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the string pool.
+///
+//===----------------------------------------------------------------------===//
+
+#include "tapi/Core/StringPool.h"
+#include <cstring>
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+StringRef StringPool::intern(StringRef string) {
+  if (string.empty())
+    return {};
+
+  auto it = _strings.find(string);
+  if (it != _strings.end())
+    return *it;
+
+  auto *ptr = static_cast<char *>(_allocator.Allocate(string.size(), 1));
+  memcpy(ptr, string.data(), string.size());
+  StringRef copy(ptr, string.size());
+  _strings.insert(copy);
+  return copy;
+}
+
+size_t StringPool::size() const { return _strings.size(); }
+
+TAPI_NAMESPACE_INTERNAL_END
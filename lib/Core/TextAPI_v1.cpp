@@ -20,6 +20,7 @@
 #include "tapi/Core/Framework.h"
 #include "tapi/Core/XPI.h"
 #include "tapi/Core/YAML.h"
+#include "tapi/Core/YAMLEmitter.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/YAMLTraits.h"
@@ -88,7 +89,10 @@ template <> struct MappingTraits<ExportSection> {
 template <> struct MappingTraits<const ExtendedInterfaceFile *> {
   struct NormalizedAPI1 {
     explicit NormalizedAPI1(IO &io) {}
-    NormalizedAPI1(IO &io, const ExtendedInterfaceFile *&file) {
+    NormalizedAPI1(IO &io, const ExtendedInterfaceFile *&file)
+        : NormalizedAPI1(file) {}
+
+    explicit NormalizedAPI1(const ExtendedInterfaceFile *file) {
       if (file->getFileType() == TAPI_INTERNAL::FileType::API_V1)
         isPrivate = false;
       else if (file->getFileType() == TAPI_INTERNAL::FileType::SPI_V1)
@@ -149,12 +153,8 @@ template <> struct MappingTraits<const ExtendedInterfaceFile *> {
           }
         }
 
-        sort(section.symbols);
-        sort(section.classes);
-        sort(section.classEHs);
-        sort(section.ivars);
-        sort(section.weakDefSymbols);
-        sort(section.tlvSymbols);
+        // The exports are ordered by kind and name and every list only holds
+        // one kind, so the lists are already sorted.
         exports.emplace_back(std::move(section));
       }
     }
@@ -208,6 +208,60 @@ template <> struct MappingTraits<const ExtendedInterfaceFile *> {
       io.mapTag("!tapi-api-v1", true);
     io.mapOptional("exports", keys->exports);
   }
+
+  static void emitAvailability(YAMLEmitter &emitter,
+                               const Availability &avail) {
+    emitter.beginMapping();
+    emitter.mapScalar("install-name", StringRef(avail.installName));
+    emitter.mapOptionalScalar("current-version", avail.currentVersion,
+                              PackedVersion(1, 0, 0));
+    emitter.mapOptionalScalar("compatibility-version",
+                              avail.compatibilityVersion,
+                              PackedVersion(1, 0, 0));
+    emitter.key("arch");
+    emitter.beginBitSet();
+#define ARCHINFO(arch, type, subtype)                                          \
+  if (avail.archs.has(Architecture::arch))                                     \
+    emitter.bitSetValue(#arch);
+#include "tapi/Core/Architecture.def"
+#undef ARCHINFO
+    emitter.endBitSet();
+    emitter.mapOptionalScalar("sdk-version", avail.osRange,
+                              AvailabilityInfo());
+    emitter.endMapping();
+  }
+
+  static void emitSection(YAMLEmitter &emitter, const ExportSection &section) {
+    emitter.beginMapping();
+    emitter.key("availability");
+    emitter.beginSequence();
+    for (const auto &avail : section.availabilities)
+      emitAvailability(emitter, avail);
+    emitter.endSequence();
+    emitter.mapOptionalFlowSequence("symbols", section.symbols);
+    emitter.mapOptionalFlowSequence("objc-classes", section.classes);
+    emitter.mapOptionalFlowSequence("objc-eh-types", section.classEHs);
+    emitter.mapOptionalFlowSequence("objc-ivars", section.ivars);
+    emitter.mapOptionalFlowSequence("weak-def-symbols", section.weakDefSymbols);
+    emitter.mapOptionalFlowSequence("thread-local-symbols", section.tlvSymbols);
+    emitter.endMapping();
+  }
+
+  /// \brief Stream the same document as mappingAPI1 without going through
+  ///        llvm::yaml::Output.
+  static void emitAPI1(YAMLEmitter &emitter,
+                       const ExtendedInterfaceFile *file) {
+    NormalizedAPI1 keys(file);
+    emitter.beginDocument(keys.isPrivate ? "!tapi-spi-v1" : "!tapi-api-v1");
+    if (!keys.exports.empty()) {
+      emitter.key("exports");
+      emitter.beginSequence();
+      for (const auto &section : keys.exports)
+        emitSection(emitter, section);
+      emitter.endSequence();
+    }
+    emitter.endDocument();
+  }
 };
 
 } // end namespace yaml.
@@ -299,6 +353,20 @@ bool YAMLDocumentHandler::handleDocument(IO &io, const File *&file) const {
   return true;
 }
 
+bool YAMLDocumentHandler::emitDocument(YAMLEmitter &emitter,
+                                       const File *file) const {
+  if (file->getFileType() != FileType::API_V1 &&
+      file->getFileType() != FileType::SPI_V1)
+    return false;
+
+  const auto *interface = dyn_cast<ExtendedInterfaceFile>(file);
+  if (interface == nullptr)
+    return false;
+
+  MappingTraits<const ExtendedInterfaceFile *>::emitAPI1(emitter, interface);
+  return true;
+}
+
 } // end namespace v1.
 } // end namespace api.
 
@@ -0,0 +1,879 @@
+//===- lib/Core/TextStubReader.cpp - Text Stub Reader -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the fast reader for text-based stub files.
+///
+/// The reader scans the buffer once and adds the symbols directly to the
+/// interface file, instead of building a YAML node tree and a normalized copy
+/// of the document first. It accepts exactly the layout the text-based stub
+/// writers produce: top-level "key: value" pairs, flow sequences for lists and
+/// block sequences of mappings for the export and undefined sections.
+///
+/// Whenever the parser encounters something outside of this grammar it gives
+/// up and the buffer is read again with the generic YAML reader. This keeps the
+/// semantics - and the diagnostics for malformed files - identical to the
+/// generic reader.
+///
+//===----------------------------------------------------------------------===//
+
+#include "tapi/Core/TextStubReader.h"
+#include "tapi/Core/Architecture.h"
+#include "tapi/Core/ArchitectureSupport.h"
+#include "tapi/Core/InterfaceFile.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSwitch.h"
+#include <cctype>
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+namespace {
+
+/// \brief The top-level keys of a text-based stub file.
+enum HeaderKey : unsigned {
+  HK_Invalid = 0U,
+  HK_Archs = 1U << 0,
+  HK_UUIDs = 1U << 1,
+  HK_Platform = 1U << 2,
+  HK_Flags = 1U << 3,
+  HK_InstallName = 1U << 4,
+  HK_CurrentVersion = 1U << 5,
+  HK_CompatibilityVersion = 1U << 6,
+  HK_SwiftVersion = 1U << 7,
+  HK_SwiftABIVersion = 1U << 8,
+  HK_ObjCConstraint = 1U << 9,
+  HK_ParentUmbrella = 1U << 10,
+  HK_Exports = 1U << 11,
+  HK_Undefineds = 1U << 12,
+};
+
+/// \brief The keys of an export or undefined section. The order matches the
+/// order in which the generic reader adds the section content to the
+/// interface file.
+enum class SectionKey : unsigned {
+  Archs,
+  AllowableClients,
+  ReexportedLibraries,
+  Symbols,
+  ObjCClasses,
+  ObjCEHTypes,
+  ObjCIVars,
+  WeakDefSymbols,
+  ThreadLocalSymbols,
+  WeakRefSymbols,
+  Invalid,
+};
+
+enum Flags : unsigned {
+  NoFlags = 0U,
+  FlatNamespace = 1U << 0,
+  NotApplicationExtensionSafe = 1U << 1,
+  InstallAPI = 1U << 2,
+};
+
+} // end anonymous namespace.
+
+FileType getTextStubFileType(StringRef buffer) {
+  auto str = buffer.trim();
+  if (!str.endswith("..."))
+    return FileType::Invalid;
+
+  if (str.startswith("--- !tapi-tbd-v3\n"))
+    return FileType::TBD_V3;
+  if (str.startswith("--- !tapi-tbd-v2\n"))
+    return FileType::TBD_V2;
+  if (str.startswith("---\n") || str.startswith("--- !tapi-tbd-v1\n"))
+    return FileType::TBD_V1;
+
+  return FileType::Invalid;
+}
+
+class TextStubParser {
+public:
+  TextStubParser(StringRef buffer, FileType fileType, ReadFlags readFlags,
+                 ArchitectureSet arches)
+      : _current(buffer.begin()), _end(buffer.end()), _fileType(fileType),
+        _readFlags(readFlags), _arches(arches) {}
+
+  /// \brief Parse the buffer. Returns nullptr if the buffer is not in the
+  ///        canonical form understood by this parser.
+  std::unique_ptr<InterfaceFile> parse(StringRef path);
+
+private:
+  bool atEnd() const { return _current == _end; }
+  char peek() const { return atEnd() ? '\0' : *_current; }
+  bool consume(StringRef str);
+  unsigned getIndentation() const;
+  void skipSpaces();
+  void skipComment();
+  void skipBlankLines();
+  bool skipFlowWhitespace();
+  bool parseLineEnd();
+
+  bool parseKey(StringRef &key);
+  bool parseScalar(StringRef &value, bool inFlow);
+  bool parseQuotedScalar(StringRef &value);
+  template <typename Fn> bool parseFlowSequence(Fn &&handleValue);
+  bool skipFlowSequence();
+
+  HeaderKey getHeaderKey(StringRef key) const;
+  SectionKey getSectionKey(StringRef key, bool isExport) const;
+  bool parseHeaderValue(HeaderKey key);
+  bool parseSections(bool isExport);
+  bool parseSection(bool isExport, unsigned indentation);
+  bool addSymbol(SectionKey key, StringRef name, ArchitectureSet archs,
+                 bool isExport);
+
+  const char *_current;
+  const char *_end;
+  FileType _fileType;
+  ReadFlags _readFlags;
+  ArchitectureSet _arches;
+  InterfaceFile *_file = nullptr;
+
+  ArchitectureSet _archs;
+  Platform _platform = Platform::Unknown;
+  StringRef _installName;
+  PackedVersion _currentVersion = PackedVersion(1, 0, 0);
+  PackedVersion _compatibilityVersion = PackedVersion(1, 0, 0);
+  uint8_t _swiftVersion = 0;
+  ObjCConstraint _objcConstraint = ObjCConstraint::None;
+  unsigned _flags = Flags::NoFlags;
+  StringRef _parentUmbrella;
+};
+
+bool TextStubParser::consume(StringRef str) {
+  if (StringRef(_current, _end - _current).startswith(str)) {
+    _current += str.size();
+    return true;
+  }
+  return false;
+}
+
+unsigned TextStubParser::getIndentation() const {
+  const char *ptr = _current;
+  while (ptr != _end && *ptr == ' ')
+    ++ptr;
+  return ptr - _current;
+}
+
+void TextStubParser::skipSpaces() {
+  while (!atEnd() && *_current == ' ')
+    ++_current;
+}
+
+void TextStubParser::skipComment() {
+  if (peek() != '#')
+    return;
+  while (!atEnd() && *_current != '\n')
+    ++_current;
+}
+
+/// \brief Skip empty and comment-only lines. Leaves the cursor at the
+///        beginning of the next line with content.
+void TextStubParser::skipBlankLines() {
+  while (!atEnd()) {
+    const char *lineStart = _current;
+    skipSpaces();
+    skipComment();
+    if (atEnd())
+      return;
+    if (*_current != '\n') {
+      _current = lineStart;
+      return;
+    }
+    ++_current;
+  }
+}
+
+/// \brief Skip the whitespace (including line breaks) between the elements of
+///        a flow sequence.
+bool TextStubParser::skipFlowWhitespace() {
+  while (!atEnd()) {
+    switch (*_current) {
+    case ' ':
+    case '\n':
+      ++_current;
+      break;
+    case '#':
+      // A comment has to be separated by whitespace.
+      if (_current[-1] != ' ' && _current[-1] != '\n')
+        return false;
+      skipComment();
+      break;
+    default:
+      return true;
+    }
+  }
+  return true;
+}
+
+/// \brief Consume the remainder of the current line, which may only contain
+///        whitespace and a comment.
+bool TextStubParser::parseLineEnd() {
+  skipSpaces();
+  skipComment();
+  if (atEnd())
+    return true;
+  if (*_current != '\n')
+    return false;
+  ++_current;
+  return true;
+}
+
+bool TextStubParser::parseKey(StringRef &key) {
+  const char *start = _current;
+  while (!atEnd() && ((*_current >= 'a' && *_current <= 'z') ||
+                      *_current == '-'))
+    ++_current;
+
+  if (start == _current || peek() != ':')
+    return false;
+  key = StringRef(start, _current - start);
+  ++_current;
+
+  // The value indicator has to be followed by whitespace.
+  if (!atEnd() && *_current != ' ' && *_current != '\n')
+    return false;
+
+  skipSpaces();
+  return true;
+}
+
+/// \brief Parse a single- or double-quoted scalar that doesn't span multiple
+///        lines. Double-quoted scalars with escape sequences are left to the
+///        generic reader.
+bool TextStubParser::parseQuotedScalar(StringRef &value) {
+  char quote = *_current++;
+  const char *start = _current;
+  bool hasEscapedQuotes = false;
+  while (true) {
+    if (atEnd() || *_current == '\n')
+      return false;
+    if (quote == '"' && *_current == '\\')
+      return false;
+    if (*_current == quote) {
+      if (quote == '\'' && _current + 1 != _end && _current[1] == '\'') {
+        hasEscapedQuotes = true;
+        _current += 2;
+        continue;
+      }
+      break;
+    }
+    ++_current;
+  }
+  value = StringRef(start, _current - start);
+  ++_current;
+
+  if (!hasEscapedQuotes)
+    return true;
+
+  std::string unescaped;
+  unescaped.reserve(value.size());
+  for (size_t i = 0, e = value.size(); i != e; ++i) {
+    unescaped.push_back(value[i]);
+    if (value[i] == '\'')
+      ++i;
+  }
+  value = _file->copyString(unescaped);
+  return true;
+}
+
+/// \brief Parse a scalar that fits on a single line. Plain scalars with
+///        characters that have a special meaning in YAML are rejected.
+bool TextStubParser::parseScalar(StringRef &value, bool inFlow) {
+  if (atEnd())
+    return false;
+
+  char c = *_current;
+  if (c == '\'' || c == '"')
+    return parseQuotedScalar(value);
+
+  if (StringRef("-?:,[]{}#&*!|>%@` \t\r\n").find(c) != StringRef::npos)
+    return false;
+
+  const char *start = _current;
+  while (!atEnd()) {
+    c = *_current;
+    if (c == '\n')
+      break;
+    if (c == ' ' && _current + 1 != _end && _current[1] == '#')
+      break;
+    if (inFlow && (c == ',' || c == ']'))
+      break;
+    if (c == ':' || c == '\t' || c == '\r' ||
+        (inFlow && (c == '[' || c == '{' || c == '}')))
+      return false;
+    ++_current;
+  }
+
+  value = StringRef(start, _current - start).rtrim(' ');
+  return true;
+}
+
+template <typename Fn>
+bool TextStubParser::parseFlowSequence(Fn &&handleValue) {
+  if (peek() != '[')
+    return false;
+  ++_current;
+
+  if (!skipFlowWhitespace())
+    return false;
+  if (peek() == ']') {
+    ++_current;
+    return true;
+  }
+
+  while (true) {
+    StringRef value;
+    if (!parseScalar(value, /*inFlow=*/true))
+      return false;
+    if (!handleValue(value))
+      return false;
+    if (!skipFlowWhitespace())
+      return false;
+
+    char c = peek();
+    if (c == ']') {
+      ++_current;
+      return true;
+    }
+    if (c != ',')
+      return false;
+    ++_current;
+    if (!skipFlowWhitespace())
+      return false;
+  }
+}
+
+/// \brief Skip over a flow sequence without looking at its elements.
+bool TextStubParser::skipFlowSequence() {
+  if (peek() != '[')
+    return false;
+
+  StringRef rest(_current + 1, _end - _current - 1);
+
+  // Fast path for the common case of a sequence of plain scalars.
+  auto end = rest.find(']');
+  if (end != StringRef::npos) {
+    auto content = rest.take_front(end);
+    if (none_of(StringRef("[{}'\"#"),
+                [&](char c) { return content.find(c) != StringRef::npos; })) {
+      _current = rest.data() + end + 1;
+      return true;
+    }
+  }
+
+  while (true) {
+    auto pos = rest.find_first_of("[]{}'\"#");
+    if (pos == StringRef::npos)
+      return false;
+
+    char c = rest[pos];
+    switch (c) {
+    case ']':
+      _current = rest.data() + pos + 1;
+      return true;
+    case '[':
+    case '{':
+    case '}':
+      return false;
+    case '#':
+      // A comment has to be separated by whitespace.
+      if (pos != 0 && rest[pos - 1] != ' ' && rest[pos - 1] != '\n')
+        return false;
+      pos = rest.find('\n', pos);
+      if (pos == StringRef::npos)
+        return false;
+      break;
+    default: {
+      // Escaped single quotes ('') simply look like two adjacent scalars.
+      // Backslashes are left to the generic reader.
+      char terminators[] = {c, '\n', '\\'};
+      pos = rest.find_first_of(StringRef(terminators, 3), pos + 1);
+      if (pos == StringRef::npos || rest[pos] != c)
+        return false;
+      break;
+    }
+    }
+    rest = rest.drop_front(pos + 1);
+  }
+}
+
+HeaderKey TextStubParser::getHeaderKey(StringRef key) const {
+  auto headerKey = StringSwitch<HeaderKey>(key)
+                       .Case("archs", HK_Archs)
+                       .Case("platform", HK_Platform)
+                       .Case("install-name", HK_InstallName)
+                       .Case("current-version", HK_CurrentVersion)
+                       .Case("compatibility-version", HK_CompatibilityVersion)
+                       .Case("objc-constraint", HK_ObjCConstraint)
+                       .Case("exports", HK_Exports)
+                       .Case("swift-version", HK_SwiftVersion)
+                       .Case("swift-abi-version", HK_SwiftABIVersion)
+                       .Case("uuids", HK_UUIDs)
+                       .Case("flags", HK_Flags)
+                       .Case("parent-umbrella", HK_ParentUmbrella)
+                       .Case("undefineds", HK_Undefineds)
+                       .Default(HK_Invalid);
+
+  switch (headerKey) {
+  default:
+    return headerKey;
+  case HK_SwiftVersion:
+    return _fileType == FileType::TBD_V3 ? HK_Invalid : headerKey;
+  case HK_SwiftABIVersion:
+    return _fileType == FileType::TBD_V3 ? headerKey : HK_Invalid;
+  case HK_UUIDs:
+  case HK_Flags:
+  case HK_ParentUmbrella:
+  case HK_Undefineds:
+    return _fileType == FileType::TBD_V1 ? HK_Invalid : headerKey;
+  }
+}
+
+SectionKey TextStubParser::getSectionKey(StringRef key, bool isExport) const {
+  auto sectionKey =
+      StringSwitch<SectionKey>(key)
+          .Case("archs", SectionKey::Archs)
+          .Case("allowed-clients", SectionKey::AllowableClients)
+          .Case("allowable-clients", SectionKey::AllowableClients)
+          .Case("re-exports", SectionKey::ReexportedLibraries)
+          .Case("symbols", SectionKey::Symbols)
+          .Case("objc-classes", SectionKey::ObjCClasses)
+          .Case("objc-eh-types", SectionKey::ObjCEHTypes)
+          .Case("objc-ivars", SectionKey::ObjCIVars)
+          .Case("weak-def-symbols", SectionKey::WeakDefSymbols)
+          .Case("thread-local-symbols", SectionKey::ThreadLocalSymbols)
+          .Case("weak-ref-symbols", SectionKey::WeakRefSymbols)
+          .Default(SectionKey::Invalid);
+
+  switch (sectionKey) {
+  default:
+    return sectionKey;
+  case SectionKey::AllowableClients:
+    // TBD v1 uses a different key for the allowable clients.
+    if ((_fileType == FileType::TBD_V1) != key.startswith("allowed"))
+      return SectionKey::Invalid;
+    LLVM_FALLTHROUGH;
+  case SectionKey::ReexportedLibraries:
+  case SectionKey::WeakDefSymbols:
+  case SectionKey::ThreadLocalSymbols:
+    return isExport ? sectionKey : SectionKey::Invalid;
+  case SectionKey::ObjCEHTypes:
+    return _fileType == FileType::TBD_V3 ? sectionKey : SectionKey::Invalid;
+  case SectionKey::WeakRefSymbols:
+    return isExport ? SectionKey::Invalid : sectionKey;
+  }
+}
+
+bool TextStubParser::parseHeaderValue(HeaderKey key) {
+  StringRef value;
+  switch (key) {
+  case HK_Invalid:
+    return false;
+
+  case HK_Archs:
+    if (!parseFlowSequence([&](StringRef arch) {
+          _archs.set(getArchType(arch));
+          return true;
+        }))
+      return false;
+    break;
+
+  case HK_UUIDs:
+    if (!parseFlowSequence([&](StringRef entry) {
+          auto split = entry.split(':');
+          auto uuid = split.second.trim();
+          if (uuid.empty())
+            return false;
+          _file->addUUID(getArchType(split.first.trim()), uuid);
+          return true;
+        }))
+      return false;
+    break;
+
+  case HK_Flags:
+    if (!parseFlowSequence([&](StringRef name) {
+          auto flag = StringSwitch<Flags>(name)
+                          .Case("flat_namespace", Flags::FlatNamespace)
+                          .Case("not_app_extension_safe",
+                                Flags::NotApplicationExtensionSafe)
+                          .Case("installapi", Flags::InstallAPI)
+                          .Default(Flags::NoFlags);
+          _flags |= flag;
+          return flag != Flags::NoFlags;
+        }))
+      return false;
+    break;
+
+  case HK_Platform: {
+    if (!parseScalar(value, /*inFlow=*/false))
+      return false;
+    auto platform = StringSwitch<Optional<Platform>>(value)
+                        .Case("unknown", Platform::Unknown)
+                        .Case("macosx", Platform::OSX)
+                        .Case("ios", Platform::iOS)
+                        .Case("watchos", Platform::watchOS)
+                        .Case("tvos", Platform::tvOS)
+                        .Case("bridgeos", Platform::bridgeOS)
+                        .Default(llvm::None);
+    if (!platform)
+      return false;
+    _platform = *platform;
+    break;
+  }
+
+  case HK_InstallName:
+    if (!parseScalar(_installName, /*inFlow=*/false) || _installName.empty())
+      return false;
+    break;
+
+  case HK_CurrentVersion:
+    if (!parseScalar(value, /*inFlow=*/false) ||
+        !_currentVersion.parse32(value))
+      return false;
+    break;
+
+  case HK_CompatibilityVersion:
+    if (!parseScalar(value, /*inFlow=*/false) ||
+        !_compatibilityVersion.parse32(value))
+      return false;
+    break;
+
+  case HK_SwiftVersion:
+    if (!parseScalar(value, /*inFlow=*/false))
+      return false;
+    _swiftVersion = StringSwitch<uint8_t>(value)
+                        .Case("1.0", 1)
+                        .Case("1.1", 2)
+                        .Case("2.0", 3)
+                        .Case("3.0", 4)
+                        .Default(0);
+    if (_swiftVersion == 0 && value.getAsInteger(10, _swiftVersion))
+      return false;
+    break;
+
+  case HK_SwiftABIVersion: {
+    unsigned long long version;
+    if (!parseScalar(value, /*inFlow=*/false) ||
+        getAsUnsignedInteger(value, 0, version) || version > 0xFF)
+      return false;
+    _swiftVersion = version;
+    break;
+  }
+
+  case HK_ObjCConstraint: {
+    if (!parseScalar(value, /*inFlow=*/false))
+      return false;
+    auto constraint =
+        StringSwitch<Optional<ObjCConstraint>>(value)
+            .Case("none", ObjCConstraint::None)
+            .Case("retain_release", ObjCConstraint::Retain_Release)
+            .Case("retain_release_for_simulator",
+                  ObjCConstraint::Retain_Release_For_Simulator)
+            .Case("retain_release_or_gc", ObjCConstraint::Retain_Release_Or_GC)
+            .Case("gc", ObjCConstraint::GC)
+            .Default(llvm::None);
+    if (!constraint)
+      return false;
+    _objcConstraint = *constraint;
+    break;
+  }
+
+  case HK_ParentUmbrella:
+    if (!parseScalar(_parentUmbrella, /*inFlow=*/false))
+      return false;
+    break;
+
+  case HK_Exports:
+  case HK_Undefineds:
+    // The sections start on the next line.
+    return parseLineEnd() && parseSections(key == HK_Exports);
+  }
+
+  return parseLineEnd();
+}
+
+/// \brief Parse the block sequence of export or undefined sections.
+bool TextStubParser::parseSections(bool isExport) {
+  unsigned itemIndentation = 0;
+  while (true) {
+    skipBlankLines();
+    if (atEnd())
+      return false;
+
+    unsigned indentation = getIndentation();
+    // A line without indentation ends the sequence. Empty sequences are left
+    // to the generic reader.
+    if (indentation == 0)
+      return itemIndentation != 0;
+
+    if (itemIndentation == 0)
+      itemIndentation = indentation;
+    if (indentation != itemIndentation)
+      return false;
+
+    const char *lineStart = _current;
+    _current += indentation;
+    if (!consume("- "))
+      return false;
+    skipSpaces();
+
+    if (!parseSection(isExport, _current - lineStart))
+      return false;
+  }
+}
+
+/// \brief Parse a single section. All keys have to be at the given indentation
+///        and appear in canonical order, starting with the architectures.
+///
+/// The content of sections that don't apply to any of the requested
+/// architectures is skipped without parsing the individual elements.
+bool TextStubParser::parseSection(bool isExport, unsigned indentation) {
+  ArchitectureSet archs;
+  auto lastKey = SectionKey::Invalid;
+  bool skipSymbols = _readFlags < ReadFlags::Symbols;
+  bool skipSection = false;
+
+  while (true) {
+    if (lastKey != SectionKey::Invalid) {
+      skipBlankLines();
+      if (atEnd())
+        return false;
+      // Any other indentation ends the section. The caller verifies it.
+      if (getIndentation() != indentation)
+        return true;
+      _current += indentation;
+    }
+
+    StringRef name;
+    if (!parseKey(name))
+      return false;
+
+    auto key = getSectionKey(name, isExport);
+    if (key == SectionKey::Invalid)
+      return false;
+    if (lastKey == SectionKey::Invalid ? key != SectionKey::Archs
+                                       : key <= lastKey)
+      return false;
+    lastKey = key;
+
+    bool result;
+    if (skipSection || (skipSymbols && key >= SectionKey::Symbols)) {
+      result = skipFlowSequence();
+    } else {
+      switch (key) {
+      case SectionKey::Archs:
+        result = parseFlowSequence([&](StringRef arch) {
+          archs.set(getArchType(arch));
+          return true;
+        });
+        skipSection = _arches != ArchitectureSet::All() &&
+                      (archs & _arches).empty();
+        break;
+      case SectionKey::AllowableClients:
+        result = parseFlowSequence([&](StringRef client) {
+          _file->addAllowableClient(client, archs);
+          return true;
+        });
+        break;
+      case SectionKey::ReexportedLibraries:
+        result = parseFlowSequence([&](StringRef library) {
+          _file->addReexportedLibrary(library, archs);
+          return true;
+        });
+        break;
+      default:
+        result = parseFlowSequence([&](StringRef symbol) {
+          return addSymbol(key, symbol, archs, isExport);
+        });
+        break;
+      }
+    }
+
+    if (!result || !parseLineEnd())
+      return false;
+  }
+}
+
+bool TextStubParser::addSymbol(SectionKey key, StringRef name,
+                               ArchitectureSet archs, bool isExport) {
+  // Only TBD v3 stores the Objective-C names without the leading underscore.
+  bool hasPrefix = _fileType != FileType::TBD_V3;
+  auto kind = SymbolKind::GlobalSymbol;
+  auto flags = SymbolFlags::None;
+  switch (key) {
+  default:
+    llvm_unreachable("unexpected section key");
+  case SectionKey::Symbols:
+    if (hasPrefix && name.startswith("_OBJC_EHTYPE_$_")) {
+      kind = SymbolKind::ObjectiveCClassEHType;
+      name = name.drop_front(15);
+    }
+    break;
+  case SectionKey::ObjCClasses:
+    kind = SymbolKind::ObjectiveCClass;
+    break;
+  case SectionKey::ObjCEHTypes:
+    kind = SymbolKind::ObjectiveCClassEHType;
+    break;
+  case SectionKey::ObjCIVars:
+    kind = SymbolKind::ObjectiveCInstanceVariable;
+    break;
+  case SectionKey::WeakDefSymbols:
+    flags = SymbolFlags::WeakDefined;
+    break;
+  case SectionKey::ThreadLocalSymbols:
+    flags = SymbolFlags::ThreadLocalValue;
+    break;
+  case SectionKey::WeakRefSymbols:
+    flags = SymbolFlags::WeakReferenced;
+    break;
+  }
+
+  if (hasPrefix && (key == SectionKey::ObjCClasses ||
+                    key == SectionKey::ObjCIVars)) {
+    if (name.empty())
+      return false;
+    name = name.drop_front();
+  }
+
+  if (isExport)
+    _file->addSymbolImpl(kind, name, archs, flags, /*copyStrings=*/false);
+  else
+    _file->addUndefinedSymbolImpl(kind, name, archs, flags,
+                                  /*copyStrings=*/false);
+  return true;
+}
+
+std::unique_ptr<InterfaceFile> TextStubParser::parse(StringRef path) {
+  std::unique_ptr<InterfaceFile> file(new InterfaceFile);
+  _file = file.get();
+
+  // The document start marker and the tag have already been verified by
+  // getTextStubFileType.
+  while (!atEnd() && isspace(static_cast<unsigned char>(*_current)))
+    ++_current;
+  while (!atEnd() && *_current++ != '\n')
+    ;
+
+  unsigned seenKeys = 0;
+  while (true) {
+    skipBlankLines();
+    if (atEnd() || *_current == ' ')
+      return nullptr;
+
+    if (consume("...")) {
+      while (!atEnd() && isspace(static_cast<unsigned char>(*_current)))
+        ++_current;
+      if (!atEnd())
+        return nullptr;
+      break;
+    }
+
+    StringRef name;
+    if (!parseKey(name))
+      return nullptr;
+
+    auto key = getHeaderKey(name);
+    if (key == HK_Invalid || (seenKeys & key))
+      return nullptr;
+
+    // The writers emit all header keys before the export and undefined
+    // sections. Leave anything else to the fallback reader. This also applies
+    // to header-only reads, which still have to scan the sections for header
+    // keys and malformed content, but skip the symbol lists unparsed.
+    bool isSection = key == HK_Exports || key == HK_Undefineds;
+    if (!isSection && (seenKeys & (HK_Exports | HK_Undefineds)))
+      return nullptr;
+    seenKeys |= key;
+
+    if (!parseHeaderValue(key))
+      return nullptr;
+  }
+
+  const unsigned requiredKeys = HK_Archs | HK_Platform | HK_InstallName;
+  if ((seenKeys & requiredKeys) != requiredKeys)
+    return nullptr;
+
+  file->setPath(path);
+  file->setFileType(_fileType);
+  file->setPlatform(_platform);
+  file->setArchitectures(_archs);
+  file->setInstallName(_installName);
+  file->setCurrentVersion(_currentVersion);
+  file->setCompatibilityVersion(_compatibilityVersion);
+  file->setSwiftABIVersion(_swiftVersion);
+
+  if (_fileType == FileType::TBD_V1) {
+    file->setTwoLevelNamespace();
+    file->setApplicationExtensionSafe();
+    file->setObjCConstraint(_objcConstraint);
+    return file;
+  }
+
+  file->setObjCConstraint((seenKeys & HK_ObjCConstraint)
+                              ? _objcConstraint
+                              : ObjCConstraint::Retain_Release);
+  file->setParentUmbrella(_parentUmbrella);
+  file->setTwoLevelNamespace(!(_flags & Flags::FlatNamespace));
+  file->setApplicationExtensionSafe(
+      !(_flags & Flags::NotApplicationExtensionSafe));
+  file->setInstallAPI(_flags & Flags::InstallAPI);
+
+  return file;
+}
+
+bool TextStubReader::canRead(file_magic magic, MemoryBufferRef bufferRef,
+                             FileType types) const {
+  auto fileType = getTextStubFileType(bufferRef.getBuffer());
+  if (fileType == FileType::Invalid || !(types & fileType))
+    return false;
+
+  // Never accept a file type that the fallback reader doesn't support. This
+  // reader only speeds up reading, it must not change which files are read.
+  return _fallback.canRead(magic, bufferRef, fileType);
+}
+
+Expected<FileType>
+TextStubReader::getFileType(file_magic magic,
+                            MemoryBufferRef bufferRef) const {
+  auto fileType = getTextStubFileType(bufferRef.getBuffer());
+  if (fileType == FileType::Invalid ||
+      !_fallback.canRead(magic, bufferRef, fileType))
+    return FileType::Invalid;
+  return fileType;
+}
+
+Expected<std::unique_ptr<File>>
+TextStubReader::readFile(std::unique_ptr<MemoryBuffer> memBuffer,
+                         ReadFlags readFlags, ArchitectureSet arches) const {
+  auto fileType = getTextStubFileType(memBuffer->getBuffer());
+  if (fileType != FileType::Invalid) {
+    TextStubParser parser(memBuffer->getBuffer(), fileType, readFlags, arches);
+    if (auto file = parser.parse(memBuffer->getBufferIdentifier())) {
+      file->setMemoryBuffer(std::move(memBuffer));
+      return std::unique_ptr<File>(std::move(file));
+    }
+  }
+
+  // The parser above never looks past the end of the buffer, but the generic
+  // YAML reader requires a null-terminated buffer. The caller might have
+  // provided a buffer that isn't, so hand the fallback reader a copy.
+  auto buffer = MemoryBuffer::getMemBufferCopy(
+      memBuffer->getBuffer(), memBuffer->getBufferIdentifier());
+  return _fallback.readFile(std::move(buffer), readFlags, arches);
+}
+
+TAPI_NAMESPACE_INTERNAL_END
@@ -0,0 +1,38 @@
+//===- lib/Core/TextStubWriter.cpp - Text Stub Writer -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the streaming writer for text-based stub and API files.
+///
+//===----------------------------------------------------------------------===//
+
+#include "tapi/Core/TextStubWriter.h"
+#include "tapi/Core/YAMLEmitter.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+bool TextStubWriter::canWrite(const File *file) const {
+  return _fallback.canWrite(file);
+}
+
+Error TextStubWriter::writeFile(raw_ostream &os, const File *file) const {
+  if (file == nullptr)
+    return errorCodeToError(std::make_error_code(std::errc::invalid_argument));
+
+  YAMLEmitter emitter(os);
+  if (_fallback.emitDocument(emitter, file))
+    return Error::success();
+
+  return _fallback.writeFile(os, file);
+}
+
+TAPI_NAMESPACE_INTERNAL_END
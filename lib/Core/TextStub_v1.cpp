@@ -17,6 +17,7 @@
 #include "tapi/Core/InterfaceFile.h"
 #include "tapi/Core/Registry.h"
 #include "tapi/Core/YAML.h"
+#include "tapi/Core/YAMLEmitter.h"
 #include "tapi/Core/YAMLReaderWriter.h"
 #include "tapi/LinkerInterfaceFile.h"
 #include "llvm/ADT/StringRef.h"
@@ -65,7 +66,10 @@ template <> struct MappingTraits<ExportSection> {
 template <> struct MappingTraits<const InterfaceFile *> {
   struct NormalizedTBD1 {
     explicit NormalizedTBD1(IO &io) {}
-    NormalizedTBD1(IO &io, const InterfaceFile *&file) {
+    template <typename FileT>
+    NormalizedTBD1(IO &io, const FileT *&file) : NormalizedTBD1(file) {}
+
+    template <typename FileT> explicit NormalizedTBD1(const FileT *file) {
       archs = file->getArchitectures();
       platform = file->getPlatform();
       installName = file->getInstallName();
@@ -83,7 +87,7 @@ template <> struct MappingTraits<const InterfaceFile *> {
 
       std::map<const Symbol *, ArchitectureSet> symbolToArchSet;
       for (const auto *symbol : file->exports()) {
-        auto archs = symbol->getArchitectures();
+        auto archs = file->getSymbolArchitectures(symbol);
         symbolToArchSet[symbol] = archs;
         archSet.insert(archs);
       }
@@ -155,6 +159,10 @@ template <> struct MappingTraits<const InterfaceFile *> {
       file->setObjCConstraint(objcConstraint);
 
       for (const auto &section : exports) {
+        // Skip sections for architectures that were not requested.
+        if (!ctx->isRequested(section.archs))
+          continue;
+
         for (const auto &client : section.allowableClients)
           file->addAllowableClient(client, section.archs);
         for (const auto &lib : section.reexportedLibraries)
@@ -215,8 +223,7 @@ template <> struct MappingTraits<const InterfaceFile *> {
     }
   };
 
-  static void mappingTBD1(IO &io, const InterfaceFile *&file) {
-    MappingNormalization<NormalizedTBD1, const InterfaceFile *> keys(io, file);
+  template <typename KeysT> static void mapKeysTBD1(IO &io, KeysT &keys) {
     // Don't write the tag into the .tbd file for TBD v1.
     if (!io.outputting())
       io.mapTag("tapi-tbd-v1", true);
@@ -233,6 +240,65 @@ template <> struct MappingTraits<const InterfaceFile *> {
                    ObjCConstraint::None);
     io.mapOptional("exports", keys->exports);
   }
+
+  static void emitSection(YAMLEmitter &emitter, const ExportSection &section) {
+    emitter.beginMapping();
+    emitter.mapFlowSequence("archs", section.archs);
+    emitter.mapOptionalFlowSequence("allowed-clients",
+                                    section.allowableClients);
+    emitter.mapOptionalFlowSequence("re-exports", section.reexportedLibraries);
+    emitter.mapOptionalFlowSequence("symbols", section.symbols);
+    emitter.mapOptionalFlowSequence("objc-classes", section.classes);
+    emitter.mapOptionalFlowSequence("objc-ivars", section.ivars);
+    emitter.mapOptionalFlowSequence("weak-def-symbols", section.weakDefSymbols);
+    emitter.mapOptionalFlowSequence("thread-local-symbols", section.tlvSymbols);
+    emitter.endMapping();
+  }
+
+  /// \brief Stream the same document as mapKeysTBD1 without going through
+  ///        llvm::yaml::Output.
+  template <typename FileT>
+  static void emitTBD1(YAMLEmitter &emitter, const FileT *file) {
+    NormalizedTBD1 keys(file);
+    // Don't write the tag into the .tbd file for TBD v1.
+    emitter.beginDocument();
+    emitter.mapFlowSequence("archs", keys.archs);
+    emitter.key("platform");
+    emitter.enumScalar(ScalarEnumerationTraits<Platform>::name(keys.platform));
+    emitter.mapScalar("install-name", keys.installName);
+    emitter.mapOptionalScalar("current-version", keys.currentVersion,
+                              PackedVersion(1, 0, 0));
+    emitter.mapOptionalScalar("compatibility-version",
+                              keys.compatibilityVersion,
+                              PackedVersion(1, 0, 0));
+    emitter.mapOptionalScalar("swift-version", keys.swiftVersion,
+                              SwiftVersion(0));
+    if (keys.objcConstraint != ObjCConstraint::None) {
+      emitter.key("objc-constraint");
+      emitter.enumScalar(
+          ScalarEnumerationTraits<ObjCConstraint>::name(keys.objcConstraint));
+    }
+    if (!keys.exports.empty()) {
+      emitter.key("exports");
+      emitter.beginSequence();
+      for (const auto &section : keys.exports)
+        emitSection(emitter, section);
+      emitter.endSequence();
+    }
+    emitter.endDocument();
+  }
+
+  static void mappingTBD1(IO &io, const InterfaceFile *&file) {
+    MappingNormalization<NormalizedTBD1, const InterfaceFile *> keys(io, file);
+    mapKeysTBD1(io, keys);
+  }
+
+  static void mappingTBD1(IO &io, const InterfaceFileView *&view) {
+    assert(io.outputting() && "views can only be written");
+    NormalizedTBD1 normalized(io, view);
+    auto *keys = &normalized;
+    mapKeysTBD1(io, keys);
+  }
 };
 
 } // end namespace yaml.
@@ -264,11 +330,10 @@ FileType YAMLDocumentHandler::getFileType(MemoryBufferRef memBufferRef) const {
 }
 
 bool YAMLDocumentHandler::canWrite(const File *file) const {
-  auto *interface = dyn_cast<InterfaceFile>(file);
-  if (interface == nullptr)
+  if (!isa<InterfaceFile>(file) && !isa<InterfaceFileView>(file))
     return false;
 
-  if (interface->getFileType() != FileType::TBD_V1)
+  if (file->getFileType() != FileType::TBD_V1)
     return false;
 
   return true;
@@ -282,6 +347,13 @@ bool YAMLDocumentHandler::handleDocument(IO &io, const File *&file) const {
       !io.mapTag("tag:yaml.org,2002:map"))
     return false;
 
+  if (io.outputting()) {
+    if (const auto *view = dyn_cast<InterfaceFileView>(file)) {
+      MappingTraits<const InterfaceFile *>::mappingTBD1(io, view);
+      return true;
+    }
+  }
+
   const auto *interface = dyn_cast_or_null<InterfaceFile>(file);
   MappingTraits<const InterfaceFile *>::mappingTBD1(io, interface);
   file = interface;
@@ -289,6 +361,24 @@ bool YAMLDocumentHandler::handleDocument(IO &io, const File *&file) const {
   return true;
 }
 
+bool YAMLDocumentHandler::emitDocument(YAMLEmitter &emitter,
+                                       const File *file) const {
+  if (file->getFileType() != FileType::TBD_V1)
+    return false;
+
+  if (const auto *view = dyn_cast<InterfaceFileView>(file)) {
+    MappingTraits<const InterfaceFile *>::emitTBD1(emitter, view);
+    return true;
+  }
+
+  const auto *interface = dyn_cast<InterfaceFile>(file);
+  if (interface == nullptr)
+    return false;
+
+  MappingTraits<const InterfaceFile *>::emitTBD1(emitter, interface);
+  return true;
+}
+
 } // end namespace v1.
 } // end namespace stub.
 
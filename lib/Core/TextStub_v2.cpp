@@ -17,12 +17,12 @@
 #include "tapi/Core/InterfaceFile.h"
 #include "tapi/Core/Registry.h"
 #include "tapi/Core/YAML.h"
+#include "tapi/Core/YAMLEmitter.h"
 #include "tapi/Core/YAMLReaderWriter.h"
 #include "tapi/LinkerInterfaceFile.h"
 #include "llvm/ADT/StringRef.h"
-#include "llvm/Support/Allocator.h"
 #include "llvm/Support/YAMLTraits.h"
-#include <set>
+#include <map>
 
 using namespace llvm;
 using namespace llvm::yaml;
@@ -34,19 +34,19 @@ struct ExportSection {
   std::vector<Architecture> archs;
   std::vector<FlowStringRef> allowableClients;
   std::vector<FlowStringRef> reexportedLibraries;
-  std::vector<FlowStringRef> symbols;
-  std::vector<FlowStringRef> classes;
-  std::vector<FlowStringRef> ivars;
-  std::vector<FlowStringRef> weakDefSymbols;
-  std::vector<FlowStringRef> tlvSymbols;
+  std::vector<PrefixedFlowStringRef> symbols;
+  std::vector<PrefixedFlowStringRef> classes;
+  std::vector<PrefixedFlowStringRef> ivars;
+  std::vector<PrefixedFlowStringRef> weakDefSymbols;
+  std::vector<PrefixedFlowStringRef> tlvSymbols;
 };
 
 struct UndefinedSection {
   std::vector<Architecture> archs;
-  std::vector<FlowStringRef> symbols;
-  std::vector<FlowStringRef> classes;
-  std::vector<FlowStringRef> ivars;
-  std::vector<FlowStringRef> weakRefSymbols;
+  std::vector<PrefixedFlowStringRef> symbols;
+  std::vector<PrefixedFlowStringRef> classes;
+  std::vector<PrefixedFlowStringRef> ivars;
+  std::vector<PrefixedFlowStringRef> weakRefSymbols;
 };
 
 enum Flags : unsigned {
@@ -110,7 +110,10 @@ template <> struct ScalarBitSetTraits<Flags> {
 template <> struct MappingTraits<const InterfaceFile *> {
   struct NormalizedTBD2 {
     explicit NormalizedTBD2(IO &io) {}
-    NormalizedTBD2(IO &io, const InterfaceFile *&file) {
+    template <typename FileT>
+    NormalizedTBD2(IO &io, const FileT *&file) : NormalizedTBD2(file) {}
+
+    template <typename FileT> explicit NormalizedTBD2(const FileT *file) {
       archs = file->getArchitectures();
       uuids = file->uuids();
       platform = file->getPlatform();
@@ -132,60 +135,53 @@ template <> struct MappingTraits<const InterfaceFile *> {
 
       parentUmbrella = file->getParentUmbrella();
 
-      std::set<ArchitectureSet> archSet;
+      // Bucket everything by architecture set in a single pass. The map keeps
+      // the sections ordered by their architecture set.
+      std::map<ArchitectureSet, ExportSection> exportSections;
       for (const auto &library : file->allowableClients())
-        archSet.insert(library.getArchitectures());
+        exportSections[library.getArchitectures()].allowableClients
+            .emplace_back(library.getInstallName());
 
       for (const auto &library : file->reexportedLibraries())
-        archSet.insert(library.getArchitectures());
+        exportSections[library.getArchitectures()].reexportedLibraries
+            .emplace_back(library.getInstallName());
 
-      std::map<const Symbol *, ArchitectureSet> symbolToArchSet;
+      // Consecutive symbols usually share their architectures, so remember
+      // the last section to skip most of the map lookups.
+      ExportSection *exportSection = nullptr;
+      ArchitectureSet exportArchs;
       for (const auto *symbol : file->exports()) {
-        auto archs = symbol->getArchitectures();
-        symbolToArchSet[symbol] = archs;
-        archSet.insert(archs);
-      }
+        auto archs = file->getSymbolArchitectures(symbol);
+        if (exportSection == nullptr || archs != exportArchs) {
+          exportSection = &exportSections[archs];
+          exportArchs = archs;
+        }
 
-      for (auto archs : archSet) {
-        ExportSection section;
-        section.archs = archs;
-
-        for (const auto &library : file->allowableClients())
-          if (library.getArchitectures() == archs)
-            section.allowableClients.emplace_back(library.getInstallName());
-
-        for (const auto &library : file->reexportedLibraries())
-          if (library.getArchitectures() == archs)
-            section.reexportedLibraries.emplace_back(library.getInstallName());
-
-        for (const auto &symArch : symbolToArchSet) {
-          if (symArch.second != archs)
-            continue;
-
-          const auto *symbol = symArch.first;
-          switch (symbol->getKind()) {
-          case SymbolKind::GlobalSymbol:
-            if (symbol->isWeakDefined())
-              section.weakDefSymbols.emplace_back(symbol->getName());
-            else if (symbol->isThreadLocalValue())
-              section.tlvSymbols.emplace_back(symbol->getName());
-            else
-              section.symbols.emplace_back(symbol->getName());
-            break;
-          case SymbolKind::ObjectiveCClass:
-            section.classes.emplace_back(
-                copyString("_" + symbol->getName().str()));
-            break;
-          case SymbolKind::ObjectiveCClassEHType:
-            section.symbols.emplace_back(
-                copyString("_OBJC_EHTYPE_$_" + symbol->getName().str()));
-            break;
-          case SymbolKind::ObjectiveCInstanceVariable:
-            section.ivars.emplace_back(
-                copyString("_" + symbol->getName().str()));
-            break;
-          }
+        auto &section = *exportSection;
+        switch (symbol->getKind()) {
+        case SymbolKind::GlobalSymbol:
+          if (symbol->isWeakDefined())
+            section.weakDefSymbols.emplace_back(symbol->getName());
+          else if (symbol->isThreadLocalValue())
+            section.tlvSymbols.emplace_back(symbol->getName());
+          else
+            section.symbols.emplace_back(symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCClass:
+          section.classes.emplace_back("_", symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCClassEHType:
+          section.symbols.emplace_back("_OBJC_EHTYPE_$_", symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCInstanceVariable:
+          section.ivars.emplace_back("_", symbol->getName());
+          break;
         }
+      }
+
+      for (auto &it : exportSections) {
+        auto &section = it.second;
+        section.archs = it.first;
         sort(section.symbols);
         sort(section.classes);
         sort(section.ivars);
@@ -194,45 +190,39 @@ template <> struct MappingTraits<const InterfaceFile *> {
         exports.emplace_back(std::move(section));
       }
 
-      archSet.clear();
-      symbolToArchSet.clear();
-
+      std::map<ArchitectureSet, UndefinedSection> undefinedSections;
+      UndefinedSection *undefinedSection = nullptr;
+      ArchitectureSet undefinedArchs;
       for (const auto *symbol : file->undefineds()) {
-        auto archs = symbol->getArchitectures();
-        symbolToArchSet[symbol] = archs;
-        archSet.insert(archs);
-      }
+        auto archs = file->getSymbolArchitectures(symbol);
+        if (undefinedSection == nullptr || archs != undefinedArchs) {
+          undefinedSection = &undefinedSections[archs];
+          undefinedArchs = archs;
+        }
 
-      for (auto archs : archSet) {
-        UndefinedSection section;
-        section.archs = archs;
-
-        for (const auto &symArch : symbolToArchSet) {
-          if (symArch.second != archs)
-            continue;
-
-          const auto *symbol = symArch.first;
-          switch (symbol->getKind()) {
-          case SymbolKind::GlobalSymbol:
-            if (symbol->isWeakReferenced())
-              section.weakRefSymbols.emplace_back(symbol->getName());
-            else
-              section.symbols.emplace_back(symbol->getName());
-            break;
-          case SymbolKind::ObjectiveCClass:
-            section.classes.emplace_back(
-                copyString("_" + symbol->getName().str()));
-            break;
-          case SymbolKind::ObjectiveCClassEHType:
-            section.symbols.emplace_back(
-                copyString("_OBJC_EHTYPE_$_" + symbol->getName().str()));
-            break;
-          case SymbolKind::ObjectiveCInstanceVariable:
-            section.ivars.emplace_back(
-                copyString("_" + symbol->getName().str()));
-            break;
-          }
+        auto &section = *undefinedSection;
+        switch (symbol->getKind()) {
+        case SymbolKind::GlobalSymbol:
+          if (symbol->isWeakReferenced())
+            section.weakRefSymbols.emplace_back(symbol->getName());
+          else
+            section.symbols.emplace_back(symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCClass:
+          section.classes.emplace_back("_", symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCClassEHType:
+          section.symbols.emplace_back("_OBJC_EHTYPE_$_", symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCInstanceVariable:
+          section.ivars.emplace_back("_", symbol->getName());
+          break;
         }
+      }
+
+      for (auto &it : undefinedSections) {
+        auto &section = it.second;
+        section.archs = it.first;
         sort(section.symbols);
         sort(section.classes);
         sort(section.ivars);
@@ -265,6 +255,10 @@ template <> struct MappingTraits<const InterfaceFile *> {
       file->setInstallAPI(flags & Flags::InstallAPI);
 
       for (const auto &section : exports) {
+        // Skip sections for architectures that were not requested.
+        if (!ctx->isRequested(section.archs))
+          continue;
+
         for (const auto &client : section.allowableClients)
           file->addAllowableClient(client, section.archs);
         for (const auto &lib : section.reexportedLibraries)
@@ -280,8 +274,8 @@ template <> struct MappingTraits<const InterfaceFile *> {
                                 sym.value.drop_front(15), section.archs,
                                 SymbolFlags::None, /*copyStrings=*/false);
           else
-            file->addSymbolImpl(SymbolKind::GlobalSymbol, sym, section.archs,
-                                SymbolFlags::None,
+            file->addSymbolImpl(SymbolKind::GlobalSymbol, sym.value,
+                                section.archs, SymbolFlags::None,
                                 /*copyStrings=*/false);
         }
         for (auto &sym : section.classes)
@@ -293,12 +287,12 @@ template <> struct MappingTraits<const InterfaceFile *> {
                               sym.value.drop_front(), section.archs,
                               SymbolFlags::None, /*copyStrings=*/false);
         for (auto &sym : section.weakDefSymbols)
-          file->addSymbolImpl(SymbolKind::GlobalSymbol, sym, section.archs,
-                              SymbolFlags::WeakDefined,
+          file->addSymbolImpl(SymbolKind::GlobalSymbol, sym.value,
+                              section.archs, SymbolFlags::WeakDefined,
                               /*copyStrings=*/false);
         for (auto &sym : section.tlvSymbols)
-          file->addSymbolImpl(SymbolKind::GlobalSymbol, sym, section.archs,
-                              SymbolFlags::ThreadLocalValue,
+          file->addSymbolImpl(SymbolKind::GlobalSymbol, sym.value,
+                              section.archs, SymbolFlags::ThreadLocalValue,
                               /*copyStrings=*/false);
       }
 
@@ -307,6 +301,9 @@ template <> struct MappingTraits<const InterfaceFile *> {
         return file;
 
       for (const auto &section : undefineds) {
+        if (!ctx->isRequested(section.archs))
+          continue;
+
         for (auto &sym : section.symbols) {
           if (sym.value.startswith("_OBJC_EHTYPE_$_"))
             file->addUndefinedSymbolImpl(SymbolKind::ObjectiveCClassEHType,
@@ -314,7 +311,7 @@ template <> struct MappingTraits<const InterfaceFile *> {
                                          section.archs, SymbolFlags::None,
                                          /*copyStrings=*/false);
           else
-            file->addUndefinedSymbolImpl(SymbolKind::GlobalSymbol, sym,
+            file->addUndefinedSymbolImpl(SymbolKind::GlobalSymbol, sym.value,
                                          section.archs, SymbolFlags::None,
                                          /*copyStrings=*/false);
         }
@@ -329,7 +326,7 @@ template <> struct MappingTraits<const InterfaceFile *> {
                                        SymbolFlags::None,
                                        /*copyStrings=*/false);
         for (auto &sym : section.weakRefSymbols)
-          file->addUndefinedSymbolImpl(SymbolKind::GlobalSymbol, sym,
+          file->addUndefinedSymbolImpl(SymbolKind::GlobalSymbol, sym.value,
                                        section.archs,
                                        SymbolFlags::WeakReferenced,
                                        /*copyStrings=*/false);
@@ -350,20 +347,9 @@ template <> struct MappingTraits<const InterfaceFile *> {
     StringRef parentUmbrella;
     std::vector<ExportSection> exports;
     std::vector<UndefinedSection> undefineds;
-
-    llvm::BumpPtrAllocator allocator;
-    StringRef copyString(StringRef string) {
-      if (string.empty())
-        return {};
-
-      void *ptr = allocator.Allocate(string.size(), 1);
-      memcpy(ptr, string.data(), string.size());
-      return {reinterpret_cast<const char *>(ptr), string.size()};
-    }
   };
 
-  static void mappingTBD2(IO &io, const InterfaceFile *&file) {
-    MappingNormalization<NormalizedTBD2, const InterfaceFile *> keys(io, file);
+  template <typename KeysT> static void mapKeysTBD2(IO &io, KeysT &keys) {
     io.mapTag("!tapi-tbd-v2", true);
     io.mapRequired("archs", keys->archs);
     io.mapOptional("uuids", keys->uuids);
@@ -381,6 +367,97 @@ template <> struct MappingTraits<const InterfaceFile *> {
     io.mapOptional("exports", keys->exports);
     io.mapOptional("undefineds", keys->undefineds);
   }
+
+  static void emitSection(YAMLEmitter &emitter, const ExportSection &section) {
+    emitter.beginMapping();
+    emitter.mapFlowSequence("archs", section.archs);
+    emitter.mapOptionalFlowSequence("allowable-clients",
+                                    section.allowableClients);
+    emitter.mapOptionalFlowSequence("re-exports", section.reexportedLibraries);
+    emitter.mapOptionalFlowSequence("symbols", section.symbols);
+    emitter.mapOptionalFlowSequence("objc-classes", section.classes);
+    emitter.mapOptionalFlowSequence("objc-ivars", section.ivars);
+    emitter.mapOptionalFlowSequence("weak-def-symbols", section.weakDefSymbols);
+    emitter.mapOptionalFlowSequence("thread-local-symbols", section.tlvSymbols);
+    emitter.endMapping();
+  }
+
+  static void emitSection(YAMLEmitter &emitter,
+                          const UndefinedSection &section) {
+    emitter.beginMapping();
+    emitter.mapFlowSequence("archs", section.archs);
+    emitter.mapOptionalFlowSequence("symbols", section.symbols);
+    emitter.mapOptionalFlowSequence("objc-classes", section.classes);
+    emitter.mapOptionalFlowSequence("objc-ivars", section.ivars);
+    emitter.mapOptionalFlowSequence("weak-ref-symbols", section.weakRefSymbols);
+    emitter.endMapping();
+  }
+
+  template <typename SectionT>
+  static void emitSections(YAMLEmitter &emitter, StringRef name,
+                           const std::vector<SectionT> &sections) {
+    if (sections.empty())
+      return;
+
+    emitter.key(name);
+    emitter.beginSequence();
+    for (const auto &section : sections)
+      emitSection(emitter, section);
+    emitter.endSequence();
+  }
+
+  /// \brief Stream the same document as mapKeysTBD2 without going through
+  ///        llvm::yaml::Output.
+  template <typename FileT>
+  static void emitTBD2(YAMLEmitter &emitter, const FileT *file) {
+    NormalizedTBD2 keys(file);
+    emitter.beginDocument("!tapi-tbd-v2");
+    emitter.mapFlowSequence("archs", keys.archs);
+    emitter.mapOptionalFlowSequence("uuids", keys.uuids);
+    emitter.key("platform");
+    emitter.enumScalar(ScalarEnumerationTraits<Platform>::name(keys.platform));
+    if (keys.flags != Flags::None) {
+      emitter.key("flags");
+      emitter.beginBitSet();
+      if (keys.flags & Flags::FlatNamespace)
+        emitter.bitSetValue("flat_namespace");
+      if (keys.flags & Flags::NotApplicationExtensionSafe)
+        emitter.bitSetValue("not_app_extension_safe");
+      if (keys.flags & Flags::InstallAPI)
+        emitter.bitSetValue("installapi");
+      emitter.endBitSet();
+    }
+    emitter.mapScalar("install-name", keys.installName);
+    emitter.mapOptionalScalar("current-version", keys.currentVersion,
+                              PackedVersion(1, 0, 0));
+    emitter.mapOptionalScalar("compatibility-version",
+                              keys.compatibilityVersion,
+                              PackedVersion(1, 0, 0));
+    emitter.mapOptionalScalar("swift-version", keys.swiftVersion,
+                              SwiftVersion(0));
+    if (keys.objcConstraint != ObjCConstraint::Retain_Release) {
+      emitter.key("objc-constraint");
+      emitter.enumScalar(
+          ScalarEnumerationTraits<ObjCConstraint>::name(keys.objcConstraint));
+    }
+    emitter.mapOptionalScalar("parent-umbrella", keys.parentUmbrella,
+                              StringRef());
+    emitSections(emitter, "exports", keys.exports);
+    emitSections(emitter, "undefineds", keys.undefineds);
+    emitter.endDocument();
+  }
+
+  static void mappingTBD2(IO &io, const InterfaceFile *&file) {
+    MappingNormalization<NormalizedTBD2, const InterfaceFile *> keys(io, file);
+    mapKeysTBD2(io, keys);
+  }
+
+  static void mappingTBD2(IO &io, const InterfaceFileView *&view) {
+    assert(io.outputting() && "views can only be written");
+    NormalizedTBD2 normalized(io, view);
+    auto *keys = &normalized;
+    mapKeysTBD2(io, keys);
+  }
 };
 
 } // end namespace yaml.
@@ -411,11 +488,10 @@ FileType YAMLDocumentHandler::getFileType(MemoryBufferRef memBufferRef) const {
 }
 
 bool YAMLDocumentHandler::canWrite(const File *file) const {
-  auto *interface = dyn_cast<InterfaceFile>(file);
-  if (interface == nullptr)
+  if (!isa<InterfaceFile>(file) && !isa<InterfaceFileView>(file))
     return false;
 
-  if (interface->getFileType() != FileType::TBD_V2)
+  if (file->getFileType() != FileType::TBD_V2)
     return false;
 
   return true;
@@ -428,6 +504,13 @@ bool YAMLDocumentHandler::handleDocument(IO &io, const File *&file) const {
   if (!io.outputting() && !io.mapTag("!tapi-tbd-v2"))
     return false;
 
+  if (io.outputting()) {
+    if (const auto *view = dyn_cast<InterfaceFileView>(file)) {
+      MappingTraits<const InterfaceFile *>::mappingTBD2(io, view);
+      return true;
+    }
+  }
+
   const auto *interface = dyn_cast_or_null<InterfaceFile>(file);
   MappingTraits<const InterfaceFile *>::mappingTBD2(io, interface);
   file = interface;
@@ -435,6 +518,24 @@ bool YAMLDocumentHandler::handleDocument(IO &io, const File *&file) const {
   return true;
 }
 
+bool YAMLDocumentHandler::emitDocument(YAMLEmitter &emitter,
+                                       const File *file) const {
+  if (file->getFileType() != FileType::TBD_V2)
+    return false;
+
+  if (const auto *view = dyn_cast<InterfaceFileView>(file)) {
+    MappingTraits<const InterfaceFile *>::emitTBD2(emitter, view);
+    return true;
+  }
+
+  const auto *interface = dyn_cast<InterfaceFile>(file);
+  if (interface == nullptr)
+    return false;
+
+  MappingTraits<const InterfaceFile *>::emitTBD2(emitter, interface);
+  return true;
+}
+
 } // end namespace v2.
 } // end namespace stub.
 
@@ -17,11 +17,12 @@
 #include "tapi/Core/InterfaceFile.h"
 #include "tapi/Core/Registry.h"
 #include "tapi/Core/YAML.h"
+#include "tapi/Core/YAMLEmitter.h"
 #include "tapi/Core/YAMLReaderWriter.h"
 #include "tapi/LinkerInterfaceFile.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/YAMLTraits.h"
-#include <set>
+#include <map>
 
 using namespace llvm;
 using namespace llvm::yaml;
@@ -113,7 +114,10 @@ template <> struct ScalarBitSetTraits<Flags> {
 template <> struct MappingTraits<const InterfaceFile *> {
   struct NormalizedTBD3 {
     explicit NormalizedTBD3(IO &io) {}
-    NormalizedTBD3(IO &io, const InterfaceFile *&file) {
+    template <typename FileT>
+    NormalizedTBD3(IO &io, const FileT *&file) : NormalizedTBD3(file) {}
+
+    template <typename FileT> explicit NormalizedTBD3(const FileT *file) {
       archs = file->getArchitectures();
       uuids = file->uuids();
       platform = file->getPlatform();
@@ -135,57 +139,53 @@ template <> struct MappingTraits<const InterfaceFile *> {
 
       parentUmbrella = file->getParentUmbrella();
 
-      std::set<ArchitectureSet> archSet;
+      // Bucket everything by architecture set in a single pass. The map keeps
+      // the sections ordered by their architecture set.
+      std::map<ArchitectureSet, ExportSection> exportSections;
       for (const auto &library : file->allowableClients())
-        archSet.insert(library.getArchitectures());
+        exportSections[library.getArchitectures()].allowableClients
+            .emplace_back(library.getInstallName());
 
       for (const auto &library : file->reexportedLibraries())
-        archSet.insert(library.getArchitectures());
+        exportSections[library.getArchitectures()].reexportedLibraries
+            .emplace_back(library.getInstallName());
 
-      std::map<const Symbol *, ArchitectureSet> symbolToArchSet;
+      // Consecutive symbols usually share their architectures, so remember
+      // the last section to skip most of the map lookups.
+      ExportSection *exportSection = nullptr;
+      ArchitectureSet exportArchs;
       for (const auto *symbol : file->exports()) {
-        auto archs = symbol->getArchitectures();
-        symbolToArchSet[symbol] = archs;
-        archSet.insert(archs);
-      }
+        auto archs = file->getSymbolArchitectures(symbol);
+        if (exportSection == nullptr || archs != exportArchs) {
+          exportSection = &exportSections[archs];
+          exportArchs = archs;
+        }
 
-      for (auto archs : archSet) {
-        ExportSection section;
-        section.archs = archs;
-
-        for (const auto &library : file->allowableClients())
-          if (library.getArchitectures() == archs)
-            section.allowableClients.emplace_back(library.getInstallName());
-
-        for (const auto &library : file->reexportedLibraries())
-          if (library.getArchitectures() == archs)
-            section.reexportedLibraries.emplace_back(library.getInstallName());
-
-        for (const auto &symArch : symbolToArchSet) {
-          if (symArch.second != archs)
-            continue;
-
-          const auto *symbol = symArch.first;
-          switch (symbol->getKind()) {
-          case SymbolKind::GlobalSymbol:
-            if (symbol->isWeakDefined())
-              section.weakDefSymbols.emplace_back(symbol->getName());
-            else if (symbol->isThreadLocalValue())
-              section.tlvSymbols.emplace_back(symbol->getName());
-            else
-              section.symbols.emplace_back(symbol->getName());
-            break;
-          case SymbolKind::ObjectiveCClass:
-            section.classes.emplace_back(symbol->getName());
-            break;
-          case SymbolKind::ObjectiveCClassEHType:
-            section.classEHs.emplace_back(symbol->getName());
-            break;
-          case SymbolKind::ObjectiveCInstanceVariable:
-            section.ivars.emplace_back(symbol->getName());
-            break;
-          }
+        auto &section = *exportSection;
+        switch (symbol->getKind()) {
+        case SymbolKind::GlobalSymbol:
+          if (symbol->isWeakDefined())
+            section.weakDefSymbols.emplace_back(symbol->getName());
+          else if (symbol->isThreadLocalValue())
+            section.tlvSymbols.emplace_back(symbol->getName());
+          else
+            section.symbols.emplace_back(symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCClass:
+          section.classes.emplace_back(symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCClassEHType:
+          section.classEHs.emplace_back(symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCInstanceVariable:
+          section.ivars.emplace_back(symbol->getName());
+          break;
         }
+      }
+
+      for (auto &it : exportSections) {
+        auto &section = it.second;
+        section.archs = it.first;
         sort(section.symbols);
         sort(section.classes);
         sort(section.classEHs);
@@ -195,42 +195,39 @@ template <> struct MappingTraits<const InterfaceFile *> {
         exports.emplace_back(std::move(section));
       }
 
-      archSet.clear();
-      symbolToArchSet.clear();
-
+      std::map<ArchitectureSet, UndefinedSection> undefinedSections;
+      UndefinedSection *undefinedSection = nullptr;
+      ArchitectureSet undefinedArchs;
       for (const auto *symbol : file->undefineds()) {
-        auto archs = symbol->getArchitectures();
-        symbolToArchSet[symbol] = archs;
-        archSet.insert(archs);
-      }
+        auto archs = file->getSymbolArchitectures(symbol);
+        if (undefinedSection == nullptr || archs != undefinedArchs) {
+          undefinedSection = &undefinedSections[archs];
+          undefinedArchs = archs;
+        }
 
-      for (auto archs : archSet) {
-        UndefinedSection section;
-        section.archs = archs;
-
-        for (const auto &symArch : symbolToArchSet) {
-          if (symArch.second != archs)
-            continue;
-
-          const auto *symbol = symArch.first;
-          switch (symbol->getKind()) {
-          case SymbolKind::GlobalSymbol:
-            if (symbol->isWeakReferenced())
-              section.weakRefSymbols.emplace_back(symbol->getName());
-            else
-              section.symbols.emplace_back(symbol->getName());
-            break;
-          case SymbolKind::ObjectiveCClass:
-            section.classes.emplace_back(symbol->getName());
-            break;
-          case SymbolKind::ObjectiveCClassEHType:
-            section.classEHs.emplace_back(symbol->getName());
-            break;
-          case SymbolKind::ObjectiveCInstanceVariable:
-            section.ivars.emplace_back(symbol->getName());
-            break;
-          }
+        auto &section = *undefinedSection;
+        switch (symbol->getKind()) {
+        case SymbolKind::GlobalSymbol:
+          if (symbol->isWeakReferenced())
+            section.weakRefSymbols.emplace_back(symbol->getName());
+          else
+            section.symbols.emplace_back(symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCClass:
+          section.classes.emplace_back(symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCClassEHType:
+          section.classEHs.emplace_back(symbol->getName());
+          break;
+        case SymbolKind::ObjectiveCInstanceVariable:
+          section.ivars.emplace_back(symbol->getName());
+          break;
         }
+      }
+
+      for (auto &it : undefinedSections) {
+        auto &section = it.second;
+        section.archs = it.first;
         sort(section.symbols);
         sort(section.classes);
         sort(section.classEHs);
@@ -264,6 +261,10 @@ template <> struct MappingTraits<const InterfaceFile *> {
       file->setInstallAPI(flags & Flags::InstallAPI);
 
       for (const auto &section : exports) {
+        // Skip sections for architectures that were not requested.
+        if (!ctx->isRequested(section.archs))
+          continue;
+
         for (const auto &client : section.allowableClients)
           file->addAllowableClient(client, section.archs);
         for (const auto &lib : section.reexportedLibraries)
@@ -304,6 +305,9 @@ template <> struct MappingTraits<const InterfaceFile *> {
         return file;
 
       for (const auto &section : undefineds) {
+        if (!ctx->isRequested(section.archs))
+          continue;
+
         for (auto &sym : section.symbols)
           file->addUndefinedSymbolImpl(SymbolKind::GlobalSymbol, sym,
                                        section.archs, SymbolFlags::None,
@@ -344,8 +348,7 @@ template <> struct MappingTraits<const InterfaceFile *> {
     std::vector<UndefinedSection> undefineds;
   };
 
-  static void mappingTBD3(IO &io, const InterfaceFile *&file) {
-    MappingNormalization<NormalizedTBD3, const InterfaceFile *> keys(io, file);
+  template <typename KeysT> static void mapKeysTBD3(IO &io, KeysT &keys) {
     io.mapTag("!tapi-tbd-v3", true);
     io.mapRequired("archs", keys->archs);
     io.mapOptional("uuids", keys->uuids);
@@ -363,6 +366,98 @@ template <> struct MappingTraits<const InterfaceFile *> {
     io.mapOptional("exports", keys->exports);
     io.mapOptional("undefineds", keys->undefineds);
   }
+
+  static void emitSection(YAMLEmitter &emitter, const ExportSection &section) {
+    emitter.beginMapping();
+    emitter.mapFlowSequence("archs", section.archs);
+    emitter.mapOptionalSequence("allowable-clients", section.allowableClients);
+    emitter.mapOptionalSequence("re-exports", section.reexportedLibraries);
+    emitter.mapOptionalSequence("symbols", section.symbols);
+    emitter.mapOptionalSequence("objc-classes", section.classes);
+    emitter.mapOptionalSequence("objc-eh-types", section.classEHs);
+    emitter.mapOptionalSequence("objc-ivars", section.ivars);
+    emitter.mapOptionalSequence("weak-def-symbols", section.weakDefSymbols);
+    emitter.mapOptionalSequence("thread-local-symbols", section.tlvSymbols);
+    emitter.endMapping();
+  }
+
+  static void emitSection(YAMLEmitter &emitter,
+                          const UndefinedSection &section) {
+    emitter.beginMapping();
+    emitter.mapFlowSequence("archs", section.archs);
+    emitter.mapOptionalSequence("symbols", section.symbols);
+    emitter.mapOptionalSequence("objc-classes", section.classes);
+    emitter.mapOptionalSequence("objc-eh-types", section.classEHs);
+    emitter.mapOptionalSequence("objc-ivars", section.ivars);
+    emitter.mapOptionalSequence("weak-ref-symbols", section.weakRefSymbols);
+    emitter.endMapping();
+  }
+
+  template <typename SectionT>
+  static void emitSections(YAMLEmitter &emitter, StringRef name,
+                           const std::vector<SectionT> &sections) {
+    if (sections.empty())
+      return;
+
+    emitter.key(name);
+    emitter.beginSequence();
+    for (const auto &section : sections)
+      emitSection(emitter, section);
+    emitter.endSequence();
+  }
+
+  /// \brief Stream the same document as mapKeysTBD3 without going through
+  ///        llvm::yaml::Output.
+  template <typename FileT>
+  static void emitTBD3(YAMLEmitter &emitter, const FileT *file) {
+    NormalizedTBD3 keys(file);
+    emitter.beginDocument("!tapi-tbd-v3");
+    emitter.mapFlowSequence("archs", keys.archs);
+    emitter.mapOptionalFlowSequence("uuids", keys.uuids);
+    emitter.key("platform");
+    emitter.enumScalar(ScalarEnumerationTraits<Platform>::name(keys.platform));
+    if (keys.flags != Flags::None) {
+      emitter.key("flags");
+      emitter.beginBitSet();
+      if (keys.flags & Flags::FlatNamespace)
+        emitter.bitSetValue("flat_namespace");
+      if (keys.flags & Flags::NotApplicationExtensionSafe)
+        emitter.bitSetValue("not_app_extension_safe");
+      if (keys.flags & Flags::InstallAPI)
+        emitter.bitSetValue("installapi");
+      emitter.endBitSet();
+    }
+    emitter.mapScalar("install-name", keys.installName);
+    emitter.mapOptionalScalar("current-version", keys.currentVersion,
+                              PackedVersion(1, 0, 0));
+    emitter.mapOptionalScalar("compatibility-version",
+                              keys.compatibilityVersion,
+                              PackedVersion(1, 0, 0));
+    emitter.mapOptionalScalar("swift-abi-version", keys.swiftABIVersion,
+                              (uint8_t)0U);
+    if (keys.objcConstraint != ObjCConstraint::Retain_Release) {
+      emitter.key("objc-constraint");
+      emitter.enumScalar(
+          ScalarEnumerationTraits<ObjCConstraint>::name(keys.objcConstraint));
+    }
+    emitter.mapOptionalScalar("parent-umbrella", keys.parentUmbrella,
+                              StringRef());
+    emitSections(emitter, "exports", keys.exports);
+    emitSections(emitter, "undefineds", keys.undefineds);
+    emitter.endDocument();
+  }
+
+  static void mappingTBD3(IO &io, const InterfaceFile *&file) {
+    MappingNormalization<NormalizedTBD3, const InterfaceFile *> keys(io, file);
+    mapKeysTBD3(io, keys);
+  }
+
+  static void mappingTBD3(IO &io, const InterfaceFileView *&view) {
+    assert(io.outputting() && "views can only be written");
+    NormalizedTBD3 normalized(io, view);
+    auto *keys = &normalized;
+    mapKeysTBD3(io, keys);
+  }
 };
 
 } // end namespace yaml.
@@ -393,11 +488,10 @@ FileType YAMLDocumentHandler::getFileType(MemoryBufferRef memBufferRef) const {
 }
 
 bool YAMLDocumentHandler::canWrite(const File *file) const {
-  auto *interface = dyn_cast<InterfaceFile>(file);
-  if (interface == nullptr)
+  if (!isa<InterfaceFile>(file) && !isa<InterfaceFileView>(file))
     return false;
 
-  if (interface->getFileType() != FileType::TBD_V3)
+  if (file->getFileType() != FileType::TBD_V3)
     return false;
 
   return true;
@@ -410,6 +504,13 @@ bool YAMLDocumentHandler::handleDocument(IO &io, const File *&file) const {
   if (!io.outputting() && !io.mapTag("!tapi-tbd-v3"))
     return false;
 
+  if (io.outputting()) {
+    if (const auto *view = dyn_cast<InterfaceFileView>(file)) {
+      MappingTraits<const InterfaceFile *>::mappingTBD3(io, view);
+      return true;
+    }
+  }
+
   const auto *interface = dyn_cast_or_null<InterfaceFile>(file);
   MappingTraits<const InterfaceFile *>::mappingTBD3(io, interface);
   file = interface;
@@ -417,6 +518,24 @@ bool YAMLDocumentHandler::handleDocument(IO &io, const File *&file) const {
   return true;
 }
 
+bool YAMLDocumentHandler::emitDocument(YAMLEmitter &emitter,
+                                       const File *file) const {
+  if (file->getFileType() != FileType::TBD_V3)
+    return false;
+
+  if (const auto *view = dyn_cast<InterfaceFileView>(file)) {
+    MappingTraits<const InterfaceFile *>::emitTBD3(emitter, view);
+    return true;
+  }
+
+  const auto *interface = dyn_cast<InterfaceFile>(file);
+  if (interface == nullptr)
+    return false;
+
+  MappingTraits<const InterfaceFile *>::emitTBD3(emitter, interface);
+  return true;
+}
+
 } // end namespace v3.
 } // end namespace stub.
 
@@ -49,6 +49,43 @@ bool XPI::isExportedSymbol() const {
   return isAvailable();
 }
 
+void XPI::addAvailabilityInfo(Architecture arch, const AvailabilityInfo info,
+                              bool NoOverwrite) {
+  assert(arch != Architecture::unknown && "unexpected architecture");
+  auto &slot = _availabilitySlots[static_cast<size_t>(arch)];
+  if (!_availabilityArchs.has(arch)) {
+    _availabilityArchs.set(arch);
+    slot = getAvailabilityIndex(info);
+    if (!info._unavailable)
+      _archs.set(arch);
+    return;
+  }
+
+  if (!NoOverwrite || _availabilityInfos[slot].isDefault())
+    return;
+
+  // Drop the previous record if no other architecture refers to it anymore.
+  auto oldIndex = slot;
+  slot = getAvailabilityIndex(info);
+  for (auto other : _availabilityArchs)
+    if (_availabilitySlots[static_cast<size_t>(other)] == oldIndex)
+      return;
+
+  _availabilityInfos.erase(_availabilityInfos.begin() + oldIndex);
+  for (auto other : _availabilityArchs)
+    if (_availabilitySlots[static_cast<size_t>(other)] > oldIndex)
+      --_availabilitySlots[static_cast<size_t>(other)];
+}
+
+uint8_t XPI::getAvailabilityIndex(const AvailabilityInfo &info) {
+  auto it = find(_availabilityInfos, info);
+  if (it != _availabilityInfos.end())
+    return it - _availabilityInfos.begin();
+
+  _availabilityInfos.emplace_back(info);
+  return _availabilityInfos.size() - 1;
+}
+
 std::string XPI::getPrettyName(bool demangle) const {
   if (!demangle)
     return _name;
@@ -123,8 +160,8 @@ void XPI::print(raw_ostream &os) const {
     break;
   }
   os << getAnnotatedName();
-  for (const auto &avail : _availability)
-    os << " [" << avail.first << ": " << avail.second << "]";
+  for (auto arch : _availabilityArchs)
+    os << " [" << arch << ": " << *getAvailabilityInfo(arch) << "]";
 }
 
 GlobalSymbol *GlobalSymbol::create(BumpPtrAllocator &A, StringRef name,
@@ -15,6 +15,7 @@
 #include "tapi/Core/XPISet.h"
 #include "tapi/Defines.h"
 #include "clang/Basic/SourceLocation.h"
+#include <algorithm>
 
 using namespace llvm;
 using clang::PresumedLoc;
@@ -25,19 +26,16 @@ GlobalSymbol *XPISet::addGlobalSymbol(StringRef name, PresumedLoc /*loc*/,
                                       XPIAccess access, Architecture arch,
                                       const AvailabilityInfo &info,
                                       bool isWeakDefined) {
-  name = copyString(name);
   GlobalSymbol *globalSymbol;
-  auto result =
-      _symbols.emplace(std::piecewise_construct,
-                       std::forward_as_tuple(XPIKind::GlobalSymbol, name),
-                       std::forward_as_tuple(nullptr));
-  if (result.second) {
+  auto it = _symbols.find({XPIKind::GlobalSymbol, name});
+  if (it == _symbols.end()) {
+    name = copyString(name);
     globalSymbol = GlobalSymbol::create(allocator, name, access,
                                         isWeakDefined ? SymbolFlags::WeakDefined
                                                       : SymbolFlags::None);
-    result.first->second = globalSymbol;
+    insertSymbol({XPIKind::GlobalSymbol, name}, globalSymbol);
   } else {
-    globalSymbol = cast<GlobalSymbol>(result.first->second);
+    globalSymbol = cast<GlobalSymbol>(it->second);
     assert(globalSymbol->isWeakDefined() == isWeakDefined &&
            "Weak defined not equal");
   }
@@ -47,6 +45,8 @@ GlobalSymbol *XPISet::addGlobalSymbol(StringRef name, PresumedLoc /*loc*/,
   (void)success;
 
   globalSymbol->addAvailabilityInfo(arch, info);
+  journal(globalSymbol, nullptr, access, arch, info,
+          isWeakDefined ? SymbolFlags::WeakDefined : SymbolFlags::None);
 
   return globalSymbol;
 }
@@ -55,17 +55,14 @@ ObjCClass *XPISet::addObjCClass(StringRef name, PresumedLoc /*loc*/,
                                 XPIAccess access, Architecture arch,
                                 const AvailabilityInfo &info,
                                 ObjCClass *superClass) {
-  name = copyString(name);
   ObjCClass *objcClass = nullptr;
-  auto result =
-      _symbols.emplace(std::piecewise_construct,
-                       std::forward_as_tuple(XPIKind::ObjectiveCClass, name),
-                       std::forward_as_tuple(nullptr));
-  if (result.second) {
+  auto it = _symbols.find({XPIKind::ObjectiveCClass, name});
+  if (it == _symbols.end()) {
+    name = copyString(name);
     objcClass = ObjCClass::create(allocator, name, access);
-    result.first->second = objcClass;
+    insertSymbol({XPIKind::ObjectiveCClass, name}, objcClass);
   } else {
-    objcClass = cast<ObjCClass>(result.first->second);
+    objcClass = cast<ObjCClass>(it->second);
   }
 
   auto success = objcClass->updateAccess(access);
@@ -75,6 +72,7 @@ ObjCClass *XPISet::addObjCClass(StringRef name, PresumedLoc /*loc*/,
   assert(success && "super class is not equal");
   (void)success;
   objcClass->addAvailabilityInfo(arch, info);
+  journal(objcClass, superClass, access, arch, info);
 
   return objcClass;
 }
@@ -83,23 +81,21 @@ ObjCClassEHType *XPISet::addObjCClassEHType(StringRef name,
                                             clang::PresumedLoc /*loc*/,
                                             XPIAccess access, Architecture arch,
                                             const AvailabilityInfo &info) {
-  name = copyString(name);
   ObjCClassEHType *objcClassEH = nullptr;
-  auto result = _symbols.emplace(
-      std::piecewise_construct,
-      std::forward_as_tuple(XPIKind::ObjectiveCClassEHType, name),
-      std::forward_as_tuple(nullptr));
-  if (result.second) {
+  auto it = _symbols.find({XPIKind::ObjectiveCClassEHType, name});
+  if (it == _symbols.end()) {
+    name = copyString(name);
     objcClassEH = ObjCClassEHType::create(allocator, name, access);
-    result.first->second = objcClassEH;
+    insertSymbol({XPIKind::ObjectiveCClassEHType, name}, objcClassEH);
   } else {
-    objcClassEH = cast<ObjCClassEHType>(result.first->second);
+    objcClassEH = cast<ObjCClassEHType>(it->second);
   }
 
   auto success = objcClassEH->updateAccess(access);
   assert(success && "Access is not equal");
   (void)success;
   objcClassEH->addAvailabilityInfo(arch, info);
+  journal(objcClassEH, nullptr, access, arch, info);
 
   return objcClassEH;
 }
@@ -108,25 +104,24 @@ ObjCInstanceVariable *
 XPISet::addObjCInstanceVariable(StringRef name, PresumedLoc /*loc*/,
                                 XPIAccess access, Architecture arch,
                                 const AvailabilityInfo &info) {
-  name = copyString(name);
   ObjCInstanceVariable *objcInstanceVariable = nullptr;
-  auto result = _symbols.emplace(
-      std::piecewise_construct,
-      std::forward_as_tuple(XPIKind::ObjectiveCInstanceVariable, name),
-      std::forward_as_tuple(nullptr));
+  auto it = _symbols.find({XPIKind::ObjectiveCInstanceVariable, name});
 
-  if (result.second) {
+  if (it == _symbols.end()) {
+    name = copyString(name);
     objcInstanceVariable =
         ObjCInstanceVariable::create(allocator, name, access);
-    result.first->second = objcInstanceVariable;
+    insertSymbol({XPIKind::ObjectiveCInstanceVariable, name},
+                 objcInstanceVariable);
   } else {
-    objcInstanceVariable = cast<ObjCInstanceVariable>(result.first->second);
+    objcInstanceVariable = cast<ObjCInstanceVariable>(it->second);
   }
 
   auto success = objcInstanceVariable->updateAccess(access);
   assert(success && "Access is not equal");
   (void)success;
   objcInstanceVariable->addAvailabilityInfo(arch, info);
+  journal(objcInstanceVariable, nullptr, access, arch, info);
 
   return objcInstanceVariable;
 }
@@ -143,19 +138,19 @@ ObjCSelector *XPISet::addObjCSelector(ObjCContainer *container, StringRef name,
     isCategory = true;
   }
 
-  name = copyString(name);
-  auto result = _selectors.emplace(
-      std::piecewise_construct,
-      std::forward_as_tuple(objcClass->getName(), name, isInstanceMethod,
-                            isa<ObjCProtocol>(objcClass)),
-      std::forward_as_tuple(nullptr));
+  bool isProtocol = isa<ObjCProtocol>(objcClass);
+  auto it = _selectors.find(
+      {objcClass->getName(), name, isInstanceMethod, isProtocol});
   ObjCSelector *objcSelector = nullptr;
-  if (result.second) {
+  if (it == _selectors.end()) {
+    name = copyString(name);
     objcSelector = ObjCSelector::create(allocator, name, isInstanceMethod,
                                         isDynamic, access);
-    result.first->second = objcSelector;
+    _selectors.insert(
+        {{objcClass->getName(), name, isInstanceMethod, isProtocol},
+         objcSelector});
   } else {
-    objcSelector = cast<ObjCSelector>(result.first->second);
+    objcSelector = cast<ObjCSelector>(it->second);
   }
 
   auto success = objcSelector->updateAccess(access);
@@ -165,6 +160,8 @@ ObjCSelector *XPISet::addObjCSelector(ObjCContainer *container, StringRef name,
 
   // Record a reference in the container (class, category, or protocol).
   container->addSelector(objcSelector);
+  journal(objcSelector, container, access, arch, info, SymbolFlags::None,
+          isDynamic);
 
   return objcSelector;
 }
@@ -173,18 +170,15 @@ ObjCCategory *XPISet::addObjCCategory(ObjCClass *baseClass, StringRef name,
                                       PresumedLoc /*loc*/, XPIAccess access,
                                       Architecture arch,
                                       const AvailabilityInfo &info) {
-  name = copyString(name);
   ObjCCategory *objcCategory = nullptr;
-  auto result =
-      _categories.emplace(std::piecewise_construct,
-                          std::forward_as_tuple(baseClass->getName(), name),
-                          std::forward_as_tuple(nullptr));
+  auto it = _categories.find({baseClass->getName(), name});
 
-  if (result.second) {
+  if (it == _categories.end()) {
+    name = copyString(name);
     objcCategory = ObjCCategory::create(allocator, baseClass, name, access);
-    result.first->second = objcCategory;
+    _categories.insert({{baseClass->getName(), name}, objcCategory});
   } else {
-    objcCategory = cast<ObjCCategory>(result.first->second);
+    objcCategory = cast<ObjCCategory>(it->second);
   }
 
   auto success = objcCategory->updateAccess(access);
@@ -194,6 +188,7 @@ ObjCCategory *XPISet::addObjCCategory(ObjCClass *baseClass, StringRef name,
 
   // Record a reference in the base class.
   baseClass->addCategory(objcCategory);
+  journal(objcCategory, baseClass, access, arch, info);
 
   return objcCategory;
 }
@@ -201,40 +196,36 @@ ObjCCategory *XPISet::addObjCCategory(ObjCClass *baseClass, StringRef name,
 ObjCProtocol *XPISet::addObjCProtocol(StringRef name, PresumedLoc /*loc*/,
                                       XPIAccess access, Architecture arch,
                                       const AvailabilityInfo info) {
-  name = copyString(name);
   ObjCProtocol *objcProtocol = nullptr;
-  auto result =
-      _protocols.emplace(std::piecewise_construct, std::forward_as_tuple(name),
-                         std::forward_as_tuple(nullptr));
+  auto it = _protocols.find(name);
 
-  if (result.second) {
+  if (it == _protocols.end()) {
+    name = copyString(name);
     objcProtocol = ObjCProtocol::create(allocator, name, access);
-    result.first->second = objcProtocol;
+    _protocols.insert({name, objcProtocol});
   } else {
-    objcProtocol = cast<ObjCProtocol>(result.first->second);
+    objcProtocol = cast<ObjCProtocol>(it->second);
   }
 
   auto success = objcProtocol->updateAccess(access);
   assert(success && "Access is not equal");
   (void)success;
   objcProtocol->addAvailabilityInfo(arch, info);
+  journal(objcProtocol, nullptr, access, arch, info);
 
   return objcProtocol;
 }
 
 GlobalSymbol *XPISet::addGlobalSymbol(StringRef name, ArchitectureSet archs,
                                       SymbolFlags flags, XPIAccess access) {
-  name = copyString(name);
   GlobalSymbol *globalSymbol;
-  auto result =
-      _symbols.emplace(std::piecewise_construct,
-                       std::forward_as_tuple(XPIKind::GlobalSymbol, name),
-                       std::forward_as_tuple(nullptr));
-  if (result.second) {
+  auto it = _symbols.find({XPIKind::GlobalSymbol, name});
+  if (it == _symbols.end()) {
+    name = copyString(name);
     globalSymbol = GlobalSymbol::create(allocator, name, access, flags);
-    result.first->second = globalSymbol;
+    insertSymbol({XPIKind::GlobalSymbol, name}, globalSymbol);
   } else {
-    globalSymbol = cast<GlobalSymbol>(result.first->second);
+    globalSymbol = cast<GlobalSymbol>(it->second);
     assert(globalSymbol->getSymbolFlags() == flags && "flags are not equal");
   }
 
@@ -244,6 +235,7 @@ GlobalSymbol *XPISet::addGlobalSymbol(StringRef name, ArchitectureSet archs,
 
   for (auto arch : archs)
     globalSymbol->addAvailabilityInfo(arch);
+  journal(globalSymbol, nullptr, access, archs, flags);
 
   return globalSymbol;
 }
@@ -251,17 +243,14 @@ GlobalSymbol *XPISet::addGlobalSymbol(StringRef name, ArchitectureSet archs,
 
 ObjCClass *XPISet::addObjCClass(StringRef name, ArchitectureSet archs,
                                 XPIAccess access, ObjCClass *superClass) {
-  name = copyString(name);
   ObjCClass *objcClass = nullptr;
-  auto result =
-      _symbols.emplace(std::piecewise_construct,
-                       std::forward_as_tuple(XPIKind::ObjectiveCClass, name),
-                       std::forward_as_tuple(nullptr));
-  if (result.second) {
+  auto it = _symbols.find({XPIKind::ObjectiveCClass, name});
+  if (it == _symbols.end()) {
+    name = copyString(name);
     objcClass = ObjCClass::create(allocator, name, access);
-    result.first->second = objcClass;
+    insertSymbol({XPIKind::ObjectiveCClass, name}, objcClass);
   } else {
-    objcClass = cast<ObjCClass>(result.first->second);
+    objcClass = cast<ObjCClass>(it->second);
   }
 
   auto success = objcClass->updateAccess(access);
@@ -273,6 +262,7 @@ ObjCClass *XPISet::addObjCClass(StringRef name, ArchitectureSet archs,
 
   for (auto arch : archs)
     objcClass->addAvailabilityInfo(arch);
+  journal(objcClass, superClass, access, archs);
 
   return objcClass;
 }
@@ -280,17 +270,14 @@ ObjCClass *XPISet::addObjCClass(StringRef name, ArchitectureSet archs,
 ObjCClassEHType *XPISet::addObjCClassEHType(StringRef name,
                                             ArchitectureSet archs,
                                             XPIAccess access) {
-  name = copyString(name);
   ObjCClassEHType *objCClassEH = nullptr;
-  auto result = _symbols.emplace(
-      std::piecewise_construct,
-      std::forward_as_tuple(XPIKind::ObjectiveCClassEHType, name),
-      std::forward_as_tuple(nullptr));
-  if (result.second) {
+  auto it = _symbols.find({XPIKind::ObjectiveCClassEHType, name});
+  if (it == _symbols.end()) {
+    name = copyString(name);
     objCClassEH = ObjCClassEHType::create(allocator, name, access);
-    result.first->second = objCClassEH;
+    insertSymbol({XPIKind::ObjectiveCClassEHType, name}, objCClassEH);
   } else {
-    objCClassEH = cast<ObjCClassEHType>(result.first->second);
+    objCClassEH = cast<ObjCClassEHType>(it->second);
   }
 
   auto success = objCClassEH->updateAccess(access);
@@ -299,6 +286,7 @@ ObjCClassEHType *XPISet::addObjCClassEHType(StringRef name,
 
   for (auto arch : archs)
     objCClassEH->addAvailabilityInfo(arch);
+  journal(objCClassEH, nullptr, access, archs);
 
   return objCClassEH;
 }
@@ -306,19 +294,17 @@ ObjCClassEHType *XPISet::addObjCClassEHType(StringRef name,
 ObjCInstanceVariable *XPISet::addObjCInstanceVariable(StringRef name,
                                                       ArchitectureSet archs,
                                                       XPIAccess access) {
-  name = copyString(name);
   ObjCInstanceVariable *objcInstanceVariable = nullptr;
-  auto result = _symbols.emplace(
-      std::piecewise_construct,
-      std::forward_as_tuple(XPIKind::ObjectiveCInstanceVariable, name),
-      std::forward_as_tuple(nullptr));
+  auto it = _symbols.find({XPIKind::ObjectiveCInstanceVariable, name});
 
-  if (result.second) {
+  if (it == _symbols.end()) {
+    name = copyString(name);
     objcInstanceVariable =
         ObjCInstanceVariable::create(allocator, name, access);
-    result.first->second = objcInstanceVariable;
+    insertSymbol({XPIKind::ObjectiveCInstanceVariable, name},
+                 objcInstanceVariable);
   } else {
-    objcInstanceVariable = cast<ObjCInstanceVariable>(result.first->second);
+    objcInstanceVariable = cast<ObjCInstanceVariable>(it->second);
   }
 
   auto success = objcInstanceVariable->updateAccess(access);
@@ -327,6 +313,7 @@ ObjCInstanceVariable *XPISet::addObjCInstanceVariable(StringRef name,
 
   for (auto arch : archs)
     objcInstanceVariable->addAvailabilityInfo(arch);
+  journal(objcInstanceVariable, nullptr, access, archs);
 
   return objcInstanceVariable;
 }
@@ -339,19 +326,19 @@ ObjCSelector *XPISet::addObjCSelector(ObjCContainer *container, StringRef name,
   if (auto *category = dyn_cast<ObjCCategory>(container))
     objcClass = category->getBaseClass();
 
-  name = copyString(name);
-  auto result = _selectors.emplace(
-      std::piecewise_construct,
-      std::forward_as_tuple(objcClass->getName(), name, isInstanceMethod,
-                            isa<ObjCProtocol>(objcClass)),
-      std::forward_as_tuple(nullptr));
+  bool isProtocol = isa<ObjCProtocol>(objcClass);
+  auto it = _selectors.find(
+      {objcClass->getName(), name, isInstanceMethod, isProtocol});
   ObjCSelector *objcSelector = nullptr;
-  if (result.second) {
+  if (it == _selectors.end()) {
+    name = copyString(name);
     objcSelector = ObjCSelector::create(allocator, name, isInstanceMethod,
                                         isDynamic, access);
-    result.first->second = objcSelector;
+    _selectors.insert(
+        {{objcClass->getName(), name, isInstanceMethod, isProtocol},
+         objcSelector});
   } else {
-    objcSelector = cast<ObjCSelector>(result.first->second);
+    objcSelector = cast<ObjCSelector>(it->second);
   }
 
   auto success = objcSelector->updateAccess(access);
@@ -363,24 +350,23 @@ ObjCSelector *XPISet::addObjCSelector(ObjCContainer *container, StringRef name,
 
   // Record a reference in the container (class, category, or protocol).
   container->addSelector(objcSelector);
+  journal(objcSelector, container, access, archs, SymbolFlags::None,
+          isDynamic);
 
   return objcSelector;
 }
 
 ObjCCategory *XPISet::addObjCCategory(ObjCClass *baseClass, StringRef name,
                                       ArchitectureSet archs, XPIAccess access) {
-  name = copyString(name);
   ObjCCategory *objcCategory = nullptr;
-  auto result =
-      _categories.emplace(std::piecewise_construct,
-                          std::forward_as_tuple(baseClass->getName(), name),
-                          std::forward_as_tuple(nullptr));
+  auto it = _categories.find({baseClass->getName(), name});
 
-  if (result.second) {
+  if (it == _categories.end()) {
+    name = copyString(name);
     objcCategory = ObjCCategory::create(allocator, baseClass, name, access);
-    result.first->second = objcCategory;
+    _categories.insert({{baseClass->getName(), name}, objcCategory});
   } else {
-    objcCategory = cast<ObjCCategory>(result.first->second);
+    objcCategory = cast<ObjCCategory>(it->second);
   }
 
   auto success = objcCategory->updateAccess(access);
@@ -392,23 +378,22 @@ ObjCCategory *XPISet::addObjCCategory(ObjCClass *baseClass, StringRef name,
 
   // Record a reference in the base class.
   baseClass->addCategory(objcCategory);
+  journal(objcCategory, baseClass, access, archs);
 
   return objcCategory;
 }
 
 ObjCProtocol *XPISet::addObjCProtocol(StringRef name, ArchitectureSet archs,
                                       XPIAccess access) {
-  name = copyString(name);
   ObjCProtocol *objcProtocol = nullptr;
-  auto result =
-      _protocols.emplace(std::piecewise_construct, std::forward_as_tuple(name),
-                         std::forward_as_tuple(nullptr));
+  auto it = _protocols.find(name);
 
-  if (result.second) {
+  if (it == _protocols.end()) {
+    name = copyString(name);
     objcProtocol = ObjCProtocol::create(allocator, name, access);
-    result.first->second = objcProtocol;
+    _protocols.insert({name, objcProtocol});
   } else {
-    objcProtocol = cast<ObjCProtocol>(result.first->second);
+    objcProtocol = cast<ObjCProtocol>(it->second);
   }
 
   auto success = objcProtocol->updateAccess(access);
@@ -417,10 +402,100 @@ ObjCProtocol *XPISet::addObjCProtocol(StringRef name, ArchitectureSet archs,
 
   for (auto arch : archs)
     objcProtocol->addAvailabilityInfo(arch);
+  journal(objcProtocol, nullptr, access, archs);
 
   return objcProtocol;
 }
 
+void XPISet::merge(const XPISet &other) {
+  assert(other._isJournaled && "only journaled sets can be merged");
+
+  // Maps the XPIs of the other set to the XPIs of this set.
+  DenseMap<const XPI *, XPI *> merged;
+  for (const auto &insertion : other._journal) {
+    XPI *parent = nullptr;
+    if (insertion.parent) {
+      parent = merged.lookup(insertion.parent);
+      assert(parent && "parent was not inserted before");
+    }
+
+    auto name = insertion.xpi->getName();
+    auto access = insertion.access;
+    auto archs = insertion.archs;
+    auto arch =
+        insertion.isDeclaration ? *archs.begin() : Architecture::unknown;
+    const auto &info = insertion.info;
+    XPI *xpi = nullptr;
+    switch (insertion.xpi->getKind()) {
+    case XPIKind::GlobalSymbol:
+      if (insertion.isDeclaration)
+        xpi = addGlobalSymbol(name, PresumedLoc(), access, arch, info,
+                              insertion.flags == SymbolFlags::WeakDefined);
+      else
+        xpi = addGlobalSymbol(name, archs, insertion.flags, access);
+      break;
+    case XPIKind::ObjectiveCClass:
+      if (insertion.isDeclaration)
+        xpi = addObjCClass(name, PresumedLoc(), access, arch, info,
+                           cast_or_null<ObjCClass>(parent));
+      else
+        xpi = addObjCClass(name, archs, access,
+                           cast_or_null<ObjCClass>(parent));
+      break;
+    case XPIKind::ObjectiveCClassEHType:
+      if (insertion.isDeclaration)
+        xpi = addObjCClassEHType(name, PresumedLoc(), access, arch, info);
+      else
+        xpi = addObjCClassEHType(name, archs, access);
+      break;
+    case XPIKind::ObjectiveCInstanceVariable:
+      if (insertion.isDeclaration)
+        xpi = addObjCInstanceVariable(name, PresumedLoc(), access, arch, info);
+      else
+        xpi = addObjCInstanceVariable(name, archs, access);
+      break;
+    case XPIKind::ObjCSelector: {
+      auto *container = cast<ObjCContainer>(parent);
+      bool isInstanceMethod =
+          cast<ObjCSelector>(insertion.xpi)->isInstanceMethod();
+      if (insertion.isDeclaration)
+        xpi = addObjCSelector(container, name, isInstanceMethod,
+                              insertion.isDynamic, PresumedLoc(), access,
+                              arch, info);
+      else
+        xpi = addObjCSelector(container, name, archs, isInstanceMethod,
+                              insertion.isDynamic, access);
+      break;
+    }
+    case XPIKind::ObjCCategory:
+      if (insertion.isDeclaration)
+        xpi = addObjCCategory(cast<ObjCClass>(parent), name, PresumedLoc(),
+                              access, arch, info);
+      else
+        xpi = addObjCCategory(cast<ObjCClass>(parent), name, archs, access);
+      break;
+    case XPIKind::ObjCProtocol:
+      if (insertion.isDeclaration)
+        xpi = addObjCProtocol(name, PresumedLoc(), access, arch, info);
+      else
+        xpi = addObjCProtocol(name, archs, access);
+      break;
+    }
+    merged[insertion.xpi] = xpi;
+  }
+}
+
+void XPISet::orderSymbols() const {
+  if (_numOrderedSymbols == _orderedSymbols.size())
+    return;
+
+  auto cmp = [](const XPI *lhs, const XPI *rhs) { return *lhs < *rhs; };
+  auto mid = _orderedSymbols.begin() + _numOrderedSymbols;
+  std::sort(mid, _orderedSymbols.end(), cmp);
+  std::inplace_merge(_orderedSymbols.begin(), mid, _orderedSymbols.end(), cmp);
+  _numOrderedSymbols = _orderedSymbols.size();
+}
+
 const XPI *XPISet::findSymbol(XPIKind kind, StringRef name) const {
   assert((kind == XPIKind::GlobalSymbol || kind == XPIKind::ObjectiveCClass ||
           kind == XPIKind::ObjectiveCClassEHType ||
@@ -0,0 +1,212 @@
+//===- lib/Core/YAMLEmitter.cpp - Streaming YAML Emitter --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the streaming YAML emitter.
+///
+/// The state handling mirrors llvm::yaml::Output, so that documents written
+/// by the emitter and by the generic YAML writer are byte-identical.
+///
+//===----------------------------------------------------------------------===//
+
+#include "tapi/Core/YAMLEmitter.h"
+#include <cassert>
+
+using namespace llvm;
+using namespace llvm::yaml;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+void YAMLEmitter::beginDocument(StringRef tag) {
+  assert(_states.empty() && "unterminated document");
+  outputUpToEndOfLine("---");
+  beginMapping();
+  if (tag.empty())
+    return;
+  output(" ");
+  output(tag);
+}
+
+void YAMLEmitter::endDocument() {
+  endMapping();
+  assert(_states.empty() && "unterminated mapping or sequence");
+  output("\n...\n");
+  _needsNewLine = false;
+  _column = 0;
+}
+
+void YAMLEmitter::beginMapping() {
+  _states.push_back(InMapFirstKey);
+  _needsNewLine = true;
+}
+
+void YAMLEmitter::endMapping() { _states.pop_back(); }
+
+void YAMLEmitter::key(StringRef key) {
+  assert((_states.back() == InMapFirstKey ||
+          _states.back() == InMapOtherKey) &&
+         "keys are only valid in mappings");
+  newLineCheck();
+
+  // Pad the key, so that the values of short keys line up.
+  static const char spaces[] = "                ";
+  output(key);
+  output(":");
+  if (key.size() < sizeof(spaces) - 1)
+    output(StringRef(spaces + key.size()));
+  else
+    output(" ");
+
+  // Only the first key of a mapping in a sequence gets the dash.
+  _states.back() = InMapOtherKey;
+}
+
+void YAMLEmitter::beginSequence() {
+  _states.push_back(InSequence);
+  _needsNewLine = true;
+}
+
+void YAMLEmitter::endSequence() { _states.pop_back(); }
+
+void YAMLEmitter::beginFlowSequence() {
+  _states.push_back(InFlowSequence);
+  newLineCheck();
+  _columnAtFlowStart = _column;
+  output("[ ");
+  _needFlowSequenceComma = false;
+}
+
+void YAMLEmitter::endFlowSequence() {
+  _states.pop_back();
+  outputUpToEndOfLine(" ]");
+}
+
+void YAMLEmitter::beginBitSet() {
+  newLineCheck();
+  output("[ ");
+  _needBitValueComma = false;
+}
+
+void YAMLEmitter::bitSetValue(StringRef value) {
+  if (_needBitValueComma)
+    output(", ");
+  output(value);
+  _needBitValueComma = true;
+}
+
+void YAMLEmitter::endBitSet() { outputUpToEndOfLine(" ]"); }
+
+void YAMLEmitter::enumScalar(StringRef value) {
+  newLineCheck();
+  outputUpToEndOfLine(value);
+}
+
+void YAMLEmitter::scalar(StringRef value) {
+  preflightScalar();
+  scalarString(StringRef(), value, ScalarTraits<StringRef>::mustQuote(value));
+}
+
+void YAMLEmitter::scalar(const PrefixedFlowStringRef &value) {
+  preflightScalar();
+  if (value.prefix.empty()) {
+    scalarString(StringRef(), value.value,
+                 ScalarTraits<StringRef>::mustQuote(value.value));
+    return;
+  }
+
+  // The quoting rules depend on the whole string, so check the concatenated
+  // string. Symbol names fit into the stack buffer.
+  SmallString<128> str(value.prefix);
+  str.append(value.value);
+  scalarString(value.prefix, value.value,
+               ScalarTraits<StringRef>::mustQuote(str));
+}
+
+void YAMLEmitter::outputUpToEndOfLine(StringRef str) {
+  output(str);
+  if (_states.empty() || _states.back() != InFlowSequence)
+    _needsNewLine = true;
+}
+
+void YAMLEmitter::newLineCheck() {
+  if (!_needsNewLine)
+    return;
+  _needsNewLine = false;
+
+  _os << '\n';
+  _column = 0;
+
+  assert(!_states.empty() && "no mapping or sequence");
+  unsigned indent = _states.size() - 1;
+  bool outputDash = false;
+  if (_states.back() == InSequence) {
+    outputDash = true;
+  } else if (_states.size() > 1 &&
+             (_states.back() == InMapFirstKey ||
+              _states.back() == InFlowSequence) &&
+             _states[_states.size() - 2] == InSequence) {
+    --indent;
+    outputDash = true;
+  }
+
+  for (unsigned i = 0; i < indent; ++i)
+    output("  ");
+  if (outputDash)
+    output("- ");
+}
+
+void YAMLEmitter::preflightScalar() {
+  if (_states.empty() || _states.back() != InFlowSequence)
+    return;
+
+  if (_needFlowSequenceComma)
+    output(", ");
+  if (_wrapColumn && _column > _wrapColumn) {
+    _os << '\n';
+    _column = 0;
+    for (unsigned i = 0; i < _columnAtFlowStart; ++i)
+      output(" ");
+    output("  ");
+  }
+  _needFlowSequenceComma = true;
+}
+
+void YAMLEmitter::scalarString(StringRef prefix, StringRef value,
+                               bool mustQuote) {
+  newLineCheck();
+  if (prefix.empty() && value.empty()) {
+    // Leaving the field empty is not allowed.
+    outputUpToEndOfLine("''");
+    return;
+  }
+
+  if (!mustQuote) {
+    output(prefix);
+    outputUpToEndOfLine(value);
+    return;
+  }
+
+  output("'");
+  outputQuoted(prefix);
+  outputQuoted(value);
+  outputUpToEndOfLine("'");
+}
+
+void YAMLEmitter::outputQuoted(StringRef str) {
+  // Single quotes are escaped by doubling them.
+  size_t pos;
+  while ((pos = str.find('\'')) != StringRef::npos) {
+    output(str.take_front(pos + 1));
+    output("'");
+    str = str.drop_front(pos + 1);
+  }
+  output(str);
+}
+
+TAPI_NAMESPACE_INTERNAL_END
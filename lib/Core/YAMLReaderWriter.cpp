@@ -97,6 +97,14 @@ bool YAMLBase::handleDocument(IO &io, const File *&file) const {
   return false;
 }
 
+bool YAMLBase::emitDocument(YAMLEmitter &emitter, const File *file) const {
+  for (const auto &handler : _documentHandlers) {
+    if (handler->emitDocument(emitter, file))
+      return true;
+  }
+  return false;
+}
+
 bool YAMLReader::canRead(file_magic magic, MemoryBufferRef memBufferRef,
                          FileType types) const {
   return YAMLBase::canRead(memBufferRef, types);
@@ -114,6 +122,7 @@ YAMLReader::readFile(std::unique_ptr<MemoryBuffer> memBuffer,
   YAMLContext ctx(*this);
   ctx.path = memBuffer->getBufferIdentifier();
   ctx.readFlags = readFlags;
+  ctx.arches = arches;
   llvm::yaml::Input yin(memBuffer->getBuffer(), &ctx, DiagHandler, &ctx);
 
   // Fill vector with File objects created by parsing yaml.
@@ -94,7 +94,7 @@ bool Driver::Archive::run(DiagnosticsEngine &diag, Options &opts) {
     inputs.emplace_back(cast<InterfaceFile>(file.get().release()));
   }
 
-  std::unique_ptr<InterfaceFile> output;
+  std::unique_ptr<File> output;
   switch (opts.archiveOptions.action) {
   default:
     return false;
@@ -106,13 +106,15 @@ bool Driver::Archive::run(DiagnosticsEngine &diag, Options &opts) {
 
   case ArchiveAction::ExtractArchitecture: {
     assert(inputs.size() == 1 && "expecting exactly one input file");
-    auto file = inputs.front()->extract(opts.archiveOptions.arch);
-    if (!file) {
+    // The input outlives the output, so write a view of the slice instead
+    // of copying it into a new file.
+    auto view = inputs.front()->getView(opts.archiveOptions.arch);
+    if (!view) {
       diag.report(diag::err) << inputs.front()->getPath()
-                             << toString(file.takeError());
+                             << toString(view.takeError());
       return false;
     }
-    output = std::move(file.get());
+    output = make_unique<InterfaceFileView>(std::move(view.get()));
     break;
   }
 
@@ -122,20 +124,25 @@ bool Driver::Archive::run(DiagnosticsEngine &diag, Options &opts) {
 
   case ArchiveAction::Merge: {
     assert(!inputs.empty() && "expecting at least one input file");
-    for (auto &file : inputs) {
-      if (!output) {
-        output = std::move(file);
-        continue;
-      }
-
-      auto result = output->merge(file.get());
-      if (!result) {
-        diag.report(diag::err) << file->getPath()
-                               << toString(result.takeError());
-        return false;
-      }
-      output = std::move(result.get());
+    if (inputs.size() == 1) {
+      output = std::move(inputs.front());
+      break;
+    }
+
+    std::vector<const InterfaceFile *> files;
+    for (const auto &file : inputs)
+      files.push_back(file.get());
+
+    auto result = InterfaceFile::merge(files);
+    if (!result) {
+      // Report the error against the input that doesn't match.
+      handleAllErrors(result.takeError(), [&](const MergeError &error) {
+        diag.report(diag::err) << inputs[error.getIndex()]->getPath()
+                               << error.getMessage();
+      });
+      return false;
     }
+    output = std::move(result.get());
     break;
   }
   case ArchiveAction::ListSymbols: {
@@ -333,7 +333,12 @@ bool DirectoryScanner::scanLibraryDirectory(Framework &framework,
 }
 
 Expected<bool> DirectoryScanner::isDynamicLibrary(StringRef path) const {
-  auto bufferOrErr = _fm.getBufferForFile(path);
+  // Only the mach headers are read, so the file doesn't need to be null
+  // terminated. This allows the file to be mapped instead of read, even if
+  // its size is a multiple of the page size.
+  auto &fs = *_fm.getVirtualFileSystem();
+  auto bufferOrErr = fs.getBufferForFile(path, /*FileSize=*/-1,
+                                         /*RequiresNullTerminator=*/false);
   if (auto ec = bufferOrErr.getError())
     return errorCodeToError(ec);
 
@@ -50,21 +50,9 @@ static bool verifySymbols(const ExtendedInterfaceFile *apiFile,
                           VerificationMode verificationMode, bool demangle) {
   diag.setWarningsAsErrors(verificationMode == VerificationMode::Pedantic);
 
-  auto xpiCmp = [](const XPI *lhs, const XPI *rhs) {
-    if (lhs->getKind() < rhs->getKind())
-      return true;
-    if (rhs->getKind() < lhs->getKind())
-      return false;
-
-    return lhs->getName() < rhs->getName();
-  };
-
-  std::vector<const XPI *> symbols;
-  for (const auto *symbol : apiFile->symbols())
-    symbols.emplace_back(symbol);
-  sort(symbols, xpiCmp);
-
-  for (const auto *hsymbol : symbols) {
+  // The symbol sets iterate in kind and name order, so the diagnostics are
+  // reported in a stable order.
+  for (const auto *hsymbol : apiFile->symbols()) {
     const XPI *dsymbol = nullptr;
     bool haveSymbol =
         dylibFile->contains(hsymbol->getKind(), hsymbol->getName(), &dsymbol);
@@ -116,11 +104,7 @@ static bool verifySymbols(const ExtendedInterfaceFile *apiFile,
 
   // Check for all special linker symbols. They can affect the runtime behavior
   // and are always required to match even for ErrorsOnly mode.
-  symbols.clear();
-  for (const auto *symbol : dylibFile->exports())
-    symbols.emplace_back(symbol);
-  sort(symbols, xpiCmp);
-  for (const auto *dsymbol : symbols) {
+  for (const auto *dsymbol : dylibFile->exports()) {
     // Skip normal symbols. We only care about special linker symbols here.
     if (!dsymbol->getName().startswith("$ld$"))
       continue;
@@ -136,7 +120,7 @@ static bool verifySymbols(const ExtendedInterfaceFile *apiFile,
   if (verificationMode == VerificationMode::ErrorsOnly)
     return !diag.hasErrorOccurred();
 
-  for (const auto *dsymbol : symbols) {
+  for (const auto *dsymbol : dylibFile->exports()) {
     // Skip special linker symbols. We already checked them.
     if (dsymbol->getName().startswith("$ld$"))
       continue;
@@ -388,20 +372,16 @@ getCodeCoverageSymbols(DiagnosticsEngine &diag, ArchitectureSet architectures,
   }
 
   // Merge all the interface files into one.
-  std::unique_ptr<ExtendedInterfaceFile> output;
-  for (auto &file : files) {
-    if (!output) {
-      output = std::move(file);
-      continue;
-    }
+  if (files.empty())
+    return nullptr;
+  if (files.size() == 1)
+    return std::move(files.front());
 
-    auto result = output->merge(file.get());
-    if (!result)
-      return result.takeError();
-    output = std::move(result.get());
-  }
+  std::vector<const ExtendedInterfaceFile *> inputs;
+  for (const auto &file : files)
+    inputs.push_back(file.get());
 
-  return std::move(output);
+  return ExtendedInterfaceFile::merge(inputs);
 }
 
 /// \brief Parses the headers and generate a text-based stub file.
@@ -457,6 +437,7 @@ bool Driver::InstallAPI::run(DiagnosticsEngine &diag, Options &opts) {
   job->clangResourcePath = opts.frontendOptions.clangResourcePath;
   job->useObjectiveCARC = opts.frontendOptions.useObjectiveCARC;
   job->useObjectiveCWeakARC = opts.frontendOptions.useObjectiveCWeakARC;
+  job->numThreads = opts.frontendOptions.numParseJobs;
 
   if (opts.driverOptions.inputs.empty()) {
     diag.report(clang::diag::err_drv_no_input_files);
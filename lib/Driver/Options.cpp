@@ -207,7 +207,7 @@ bool FrontendOptions::operator==(const FrontendOptions &other) const {
                   systemIncludePaths, includePaths, macros, useRTTI, visibility,
                   enableModules, moduleCachePath, validateSystemHeaders,
                   clangExtraArgs, clangResourcePath, useObjectiveCARC,
-                  useObjectiveCWeakARC) ==
+                  useObjectiveCWeakARC, numParseJobs) ==
          std::tie(other.platform, other.osVersion, other.language,
                   other.language_std, other.isysroot,
                   other.systemFrameworkPaths, other.frameworkPaths,
@@ -216,7 +216,7 @@ bool FrontendOptions::operator==(const FrontendOptions &other) const {
                   other.visibility, other.enableModules, other.moduleCachePath,
                   other.validateSystemHeaders, other.clangExtraArgs,
                   other.clangResourcePath, other.useObjectiveCARC,
-                  other.useObjectiveCWeakARC);
+                  other.useObjectiveCWeakARC, other.numParseJobs);
 }
 
 bool DiagnosticsOptions::operator==(const DiagnosticsOptions &other) const {
@@ -687,6 +687,17 @@ bool Options::processFrontendOptions(DiagnosticsEngine &diag,
   if (args.hasArg(OPT_fobjc_weak))
     frontendOptions.useObjectiveCWeakARC = true;
 
+  // Handle concurrent header parsing.
+  if (auto *arg = args.getLastArg(OPT_parse_jobs_EQ)) {
+    if (StringRef(arg->getValue())
+            .getAsInteger(10, frontendOptions.numParseJobs) ||
+        frontendOptions.numParseJobs == 0) {
+      diag.report(clang::diag::err_drv_invalid_int_value)
+          << arg->getAsString(args) << arg->getValue();
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -85,6 +85,7 @@ bool Driver::Reexport::run(DiagnosticsEngine &diag, Options &opts) {
   job->clangResourcePath = opts.frontendOptions.clangResourcePath;
   job->useObjectiveCARC = opts.frontendOptions.useObjectiveCARC;
   job->useObjectiveCWeakARC = opts.frontendOptions.useObjectiveCWeakARC;
+  job->numThreads = opts.frontendOptions.numParseJobs;
 
   // Infer additional include paths.
   std::set<std::string> inferredIncludePaths;
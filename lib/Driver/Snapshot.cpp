@@ -18,6 +18,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/xxhash.h"
+#include <algorithm>
 #include <sstream>
 
 using namespace llvm;
@@ -59,6 +60,13 @@ template <> struct MappingTraits<InterfaceFileRef> {
   static void mapping(IO &io, InterfaceFileRef &ref) {
     io.mapRequired("install-name", ref._installName);
     io.mapOptional("architectures", ref._architectures);
+
+    // The reference doesn't own its install name, which points into the
+    // buffer that is read. Intern it into the string pool of the snapshot.
+    if (!io.outputting()) {
+      auto *stringPool = static_cast<StringPool *>(io.getContext());
+      ref._installName = stringPool->intern(ref._installName);
+    }
   }
 };
 
@@ -155,6 +163,7 @@ template <> struct MappingTraits<tapi::internal::FrontendOptions> {
                    false);
     io.mapOptional("use-objc-arc", opts.useObjectiveCARC, false);
     io.mapOptional("use-objc-weak", opts.useObjectiveCWeakARC, false);
+    io.mapOptional("parse-jobs", opts.numParseJobs, 1U);
     io.mapOptional("clang-extra-args", opts.clangExtraArgs, {});
     io.mapOptional("clang-resource-path", opts.clangResourcePath,
                    std::string());
@@ -279,6 +288,20 @@ void Snapshot::writeSnapshot(bool isCrash) {
     }
   }
 
+  // Concurrent header parsing records the paths in a nondeterministic order.
+  // Sort them, so the snapshot doesn't depend on the thread scheduling.
+  // Don't wait for the lock in a crash handler, the crashing thread might be
+  // the one holding it.
+  {
+    std::unique_lock<std::mutex> lock(recordMutex, std::try_to_lock);
+    if (!lock.owns_lock() && !isCrash)
+      lock.lock();
+    if (lock.owns_lock()) {
+      std::sort(files.begin(), files.end());
+      std::sort(directories.begin(), directories.end());
+    }
+  }
+
   for (auto &path : files) {
     // Normalize all paths.
     SmallString<PATH_MAX> normalizedPathStorage(path);
@@ -421,7 +444,7 @@ bool Snapshot::loadSnapshot(StringRef path_) {
   }
 
   auto buffer = (*bufferOr)->getBuffer();
-  yaml::Input yin(buffer);
+  yaml::Input yin(buffer, &stringPool);
 
   yin >> *this;
 
@@ -482,14 +505,24 @@ void Snapshot::recordOptions(const Options &options) {
   driverOptions = options.driverOptions;
   archiveOptions = options.archiveOptions;
   linkerOptions = options.linkerOptions;
+  for (auto &ref : linkerOptions.allowableClients)
+    ref = InterfaceFileRef(stringPool.intern(ref.getInstallName()),
+                           ref.getArchitectures());
+  for (auto &ref : linkerOptions.reexportedLibraries)
+    ref = InterfaceFileRef(stringPool.intern(ref.getInstallName()),
+                           ref.getArchitectures());
   frontendOptions = options.frontendOptions;
   diagnosticsOptions = options.diagnosticsOptions;
   tapiOptions = options.tapiOptions;
 }
 
-void Snapshot::recordFile(StringRef path) { files.emplace_back(path); }
+void Snapshot::recordFile(StringRef path) {
+  std::lock_guard<std::mutex> lock(recordMutex);
+  files.emplace_back(path);
+}
 
 void Snapshot::recordDirectory(StringRef path) {
+  std::lock_guard<std::mutex> lock(recordMutex);
   directories.emplace_back(path);
 }
 
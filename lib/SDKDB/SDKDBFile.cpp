@@ -53,13 +53,12 @@ static inline Error mergeAvailabilityInfo(AvailabilityInfo &A,
       std::make_error_code(std::errc::not_supported));
 }
 
-static inline Expected<AvailabilityInfo> mergeAllAvailabilityInfo(
-    const llvm::SmallVectorImpl<std::pair<Architecture, AvailabilityInfo>>
-        &availability,
-    const XPI *xpi) {
+static inline Expected<AvailabilityInfo>
+mergeAllAvailabilityInfo(ArrayRef<AvailabilityInfo> availability,
+                         const XPI *xpi) {
   AvailabilityInfo result;
   for (const auto &info : availability)
-    if (auto error = mergeAvailabilityInfo(result, info.second,
+    if (auto error = mergeAvailabilityInfo(result, info,
                                            xpi->getAnnotatedName(false)))
       return std::move(error);
   return result;
@@ -67,6 +66,7 @@ static inline Expected<AvailabilityInfo> mergeAllAvailabilityInfo(
 
 void SDKDBFile::addGlobalSymbol(StringRef name, bool isPublic,
                                 const AvailabilityInfo &availability) {
+  name = stringPool->intern(name);
   auto entry = SymbolEntry(name, isPublic, availability);
   auto result = symbols.emplace(std::make_pair(name, entry));
   assert(result.second && "unexpected element in the global symbol map");
@@ -77,6 +77,8 @@ SDKDBFile::ObjCClassEntry *
 SDKDBFile::addObjectiveCClass(StringRef name, StringRef superClassName,
                               bool isPublic,
                               const AvailabilityInfo &availability) {
+  name = stringPool->intern(name);
+  superClassName = stringPool->intern(superClassName);
   auto entry = ObjCClassEntry(name, superClassName, isPublic, availability);
   auto result = classes.emplace(std::make_pair(name, entry));
   assert(result.second && "unexpected element in class map");
@@ -87,6 +89,8 @@ SDKDBFile::ObjCCategoryEntry *
 SDKDBFile::addObjectiveCCategory(StringRef name, StringRef baseClassName,
                                  bool isPublic,
                                  const AvailabilityInfo &availability) {
+  name = stringPool->intern(name);
+  baseClassName = stringPool->intern(baseClassName);
   auto entry = ObjCCategoryEntry(name, baseClassName, isPublic, availability);
   CategoriesMapKey catKey(baseClassName, name);
   auto result = categories.emplace(std::make_pair(catKey, entry));
@@ -97,6 +101,7 @@ SDKDBFile::addObjectiveCCategory(StringRef name, StringRef baseClassName,
 SDKDBFile::ObjCProtocolEntry *
 SDKDBFile::addObjectiveCProtocol(StringRef name, bool isPublic,
                                  const AvailabilityInfo &availability) {
+  name = stringPool->intern(name);
   auto entry = ObjCProtocolEntry(name, isPublic, availability);
   auto result = protocols.emplace(std::make_pair(name, entry));
   assert(result.second && "unexpected element in protocol map");
@@ -107,6 +112,7 @@ void SDKDBFile::addObjectiveCMethod(
     SDKDBFile::ObjCContainerEntry *objcContainer, StringRef name,
     bool isInstanceMethod, bool isPublic,
     const AvailabilityInfo &availability) {
+  name = stringPool->intern(name);
   auto entry = MethodEntry(name, isInstanceMethod, isPublic, availability);
   MethodMapKey methodKey(name, isInstanceMethod);
   auto result =
@@ -126,7 +132,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
     if (declaration) {
       isPublic = declaration->getAccess() == XPIAccess::Public;
       auto result = mergeAllAvailabilityInfo(
-          declaration->getAvailabilityInfo(), declaration);
+          declaration->availabilityInfos(), declaration);
       if (!result)
         appendError(result.takeError());
       else
@@ -159,7 +165,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
     if (objcClassDecl) {
       isPublic = objcClassDecl->getAccess() == XPIAccess::Public;
       auto result = mergeAllAvailabilityInfo(
-          objcClassDecl->getAvailabilityInfo(), objcClassDecl);
+          objcClassDecl->availabilityInfos(), objcClassDecl);
       if (!result)
         appendError(result.takeError());
       else
@@ -181,7 +187,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
       if (selDecl) {
         isPublic = selDecl->getAccess() == XPIAccess::Public;
         auto result =
-            mergeAllAvailabilityInfo(selDecl->getAvailabilityInfo(), selDecl);
+            mergeAllAvailabilityInfo(selDecl->availabilityInfos(), selDecl);
         if (!result)
           appendError(result.takeError());
         else
@@ -204,7 +210,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
     if (objcCategoryDecl) {
       isPublic = objcCategoryDecl->getAccess() == XPIAccess::Public;
       auto result = mergeAllAvailabilityInfo(
-          objcCategoryDecl->getAvailabilityInfo(), objcCategoryDecl);
+          objcCategoryDecl->availabilityInfos(), objcCategoryDecl);
       if (!result)
         appendError(result.takeError());
       else
@@ -227,7 +233,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
       if (selDecl) {
         isPublic = selDecl->getAccess() == XPIAccess::Public;
         auto result =
-            mergeAllAvailabilityInfo(selDecl->getAvailabilityInfo(), selDecl);
+            mergeAllAvailabilityInfo(selDecl->availabilityInfos(), selDecl);
         if (!result)
           appendError(result.takeError());
         else
@@ -255,7 +261,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
       if (sel->getAccess() == XPIAccess::Public)
         s->second.isPublic = true;
       auto availability =
-          mergeAllAvailabilityInfo(sel->getAvailabilityInfo(), sel);
+          mergeAllAvailabilityInfo(sel->availabilityInfos(), sel);
       if (!availability)
         appendError(availability.takeError());
       else {
@@ -277,7 +283,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
     if (objcProtocolDecl) {
       isPublic = objcProtocolDecl->getAccess() == XPIAccess::Public;
       auto result = mergeAllAvailabilityInfo(
-          objcProtocolDecl->getAvailabilityInfo(), objcProtocolDecl);
+          objcProtocolDecl->availabilityInfos(), objcProtocolDecl);
       if (!result)
         appendError(result.takeError());
       else
@@ -299,7 +305,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
       if (selDecl) {
         isPublic = selDecl->getAccess() == XPIAccess::Public;
         auto result =
-            mergeAllAvailabilityInfo(selDecl->getAvailabilityInfo(), selDecl);
+            mergeAllAvailabilityInfo(selDecl->availabilityInfos(), selDecl);
         if (!result)
           appendError(result.takeError());
         else
@@ -321,7 +327,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
     AvailabilityInfo availability;
     isPublic = objcProtocol->getAccess() == XPIAccess::Public;
     auto result = mergeAllAvailabilityInfo(
-        objcProtocol->getAvailabilityInfo(), objcProtocol);
+        objcProtocol->availabilityInfos(), objcProtocol);
     if (!result)
       appendError(result.takeError());
     else
@@ -335,7 +341,7 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
       AvailabilityInfo availability;
       isPublic = selector->getAccess() == XPIAccess::Public;
       auto result =
-          mergeAllAvailabilityInfo(selector->getAvailabilityInfo(), selector);
+          mergeAllAvailabilityInfo(selector->availabilityInfos(), selector);
       if (!result)
         appendError(result.takeError());
       else
@@ -348,8 +354,33 @@ void SDKDBFile::addXPISets(const XPISet *declarations,
 }
 
 void SDKDBFile::merge(SDKDBFile &&Other) {
+  // The entries of the other file reference its string pool, which goes away
+  // with the other file. Intern all names into the pool of this file.
+  auto intern = [&](StringRef string) { return stringPool->intern(string); };
+
+  auto mergeMethods = [&](MethodMapType &methods,
+                          const MethodMapType &otherMethods) {
+    for (auto &s : otherMethods) {
+      auto entry = s.second;
+      entry.name = intern(entry.name);
+      MethodMapKey methodKey(entry.name, entry.isInstanceMethod);
+      auto s_result = methods.emplace(std::make_pair(methodKey, entry));
+      if (!s_result.second) {
+        if (s.second.isPublic)
+          s_result.first->second.isPublic = true;
+      }
+
+      auto err = mergeAvailabilityInfo(s_result.first->second.availability,
+                                       s.second.availability, s.second.name);
+      if (err)
+        appendError(std::move(err));
+    }
+  };
+
   for (auto &sym : Other.symbols) {
-    auto result = symbols.emplace(sym);
+    auto entry = sym.second;
+    entry.name = intern(entry.name);
+    auto result = symbols.emplace(std::make_pair(entry.name, entry));
 
     if (!result.second) {
       if (sym.second.isPublic)
@@ -362,7 +393,10 @@ void SDKDBFile::merge(SDKDBFile &&Other) {
   }
 
   for (auto &cls : Other.classes) {
-    auto result = classes.emplace(cls);
+    ObjCClassEntry entry(intern(cls.second.name),
+                         intern(cls.second.superClassName), cls.second.isPublic,
+                         cls.second.availability);
+    auto result = classes.emplace(std::make_pair(entry.name, entry));
 
     if (!result.second) {
       if (cls.second.isPublic)
@@ -373,22 +407,13 @@ void SDKDBFile::merge(SDKDBFile &&Other) {
     if (err)
       appendError(std::move(err));
 
-    for (auto &s : cls.second.methods) {
-      auto s_result = result.first->second.methods.emplace(s);
-      if (!s_result.second) {
-        if (s.second.isPublic)
-          s_result.first->second.isPublic = true;
-      }
-
-      auto err = mergeAvailabilityInfo(s_result.first->second.availability,
-                                       s.second.availability, s.second.name);
-      if (err)
-        appendError(std::move(err));
-    }
+    mergeMethods(result.first->second.methods, cls.second.methods);
   }
 
   for (auto &proto : Other.protocols) {
-    auto result = protocols.emplace(proto);
+    ObjCProtocolEntry entry(intern(proto.second.name), proto.second.isPublic,
+                            proto.second.availability);
+    auto result = protocols.emplace(std::make_pair(entry.name, entry));
 
     if (!result.second) {
       if (proto.second.isPublic)
@@ -400,22 +425,15 @@ void SDKDBFile::merge(SDKDBFile &&Other) {
     if (err)
       appendError(std::move(err));
 
-    for (auto &s : proto.second.methods) {
-      auto s_result = result.first->second.methods.emplace(s);
-      if (!s_result.second) {
-        if (s.second.isPublic)
-          s_result.first->second.isPublic = true;
-      }
-
-      auto err = mergeAvailabilityInfo(s_result.first->second.availability,
-                                       s.second.availability, s.second.name);
-      if (err)
-        appendError(std::move(err));
-    }
+    mergeMethods(result.first->second.methods, proto.second.methods);
   }
 
   for (auto &cat : Other.categories) {
-    auto result = categories.emplace(cat);
+    ObjCCategoryEntry entry(intern(cat.second.name),
+                            intern(cat.second.baseClassName),
+                            cat.second.isPublic, cat.second.availability);
+    CategoriesMapKey catKey(entry.baseClassName, entry.name);
+    auto result = categories.emplace(std::make_pair(catKey, entry));
 
     if (!result.second) {
       if (cat.second.isPublic)
@@ -426,18 +444,7 @@ void SDKDBFile::merge(SDKDBFile &&Other) {
     if (err)
       appendError(std::move(err));
 
-    for (auto &s : cat.second.methods) {
-      auto s_result = result.first->second.methods.emplace(s);
-      if (!s_result.second) {
-        if (s.second.isPublic)
-          s_result.first->second.isPublic = true;
-      }
-
-      auto err = mergeAvailabilityInfo(s_result.first->second.availability,
-                                       s.second.availability, s.second.name);
-      if (err)
-        appendError(std::move(err));
-    }
+    mergeMethods(result.first->second.methods, cat.second.methods);
   }
 
   appendError(std::move(Other.error));
@@ -550,9 +557,9 @@ Error SDKDBFile::verifySDKDBFile(const SDKDBFile *baseline) const {
   auto diagnoseInfoEntry = [&](const InfoEntry &A, const InfoEntry &B,
                                const InfoEntry *context = nullptr) {
     assert(A.name == B.name && "Name must be equal");
-    std::string name = A.name;
+    std::string name = A.name.str();
     if (context)
-      name += " (" + context->name + ")";
+      name += (" (" + context->name + ")").str();
     if (A.isPublic && !B.isPublic) {
       addNewError(make_error<StringError>(
           "API " + name + " becomes SPI",
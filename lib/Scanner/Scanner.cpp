@@ -22,13 +22,16 @@
 #include "tapi/Scanner/APIScanner.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Frontend/FrontendOptions.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <string>
 
 using namespace llvm;
@@ -95,7 +98,8 @@ static StringRef getLanguageOptions(clang::InputKind::Language lang) {
 ParseContext parseHeaders(XPISet *xpi, std::vector<std::string> args,
                           const char *headerContent, FileManager *fm,
                           std::map<const FileEntry *, HeaderType> &files,
-                          Architecture arch) {
+                          Architecture arch,
+                          DiagnosticConsumer *diagConsumer = nullptr) {
   ParseContext ctx;
   ctx.xpi = xpi;
   ctx.files = files;
@@ -103,6 +107,8 @@ ParseContext parseHeaders(XPISet *xpi, std::vector<std::string> args,
 
   ToolInvocation invocation(std::move(args), new APIScannerAction(ctx), fm);
   invocation.mapVirtualFile("tapi_autogen_header_includes.h", headerContent);
+  if (diagConsumer)
+    invocation.setDiagnosticConsumer(diagConsumer);
 
   ctx.ReturnValue = static_cast<int>(invocation.run());
 
@@ -299,35 +305,100 @@ std::unique_ptr<XPISet> Scanner::run(std::unique_ptr<ParsingJob> job) {
 
   commonArgs.emplace_back("tapi_autogen_header_includes.h");
 
-  std::unique_ptr<XPISet> xpiSet(new XPISet);
+  // Collect the parser invocations in the order they are performed serially.
+  std::vector<std::pair<HeaderType, Architecture>> invocations;
   for (auto type : {HeaderType::Public, HeaderType::Private}) {
     if ((type == HeaderType::Public) && !job->scanPublicHeaders)
       continue;
     if ((type == HeaderType::Private) && !job->scanPrivateHeaders)
       continue;
 
-    const char *headerContents = nullptr;
-    if (type == HeaderType::Public)
-      headerContents = publicHeaderContents.c_str();
-    else
-      headerContents = privateHeaderContents.c_str();
-
-    for (auto arch : job->architectures) {
-      std::vector<std::string> finalArgs;
-      finalArgs.insert(finalArgs.end(), commonArgs.begin(), commonArgs.end());
-      std::string target("--target=");
-      target += makeTargetTriple(arch, job->platform);
-      finalArgs.emplace_back(target);
-      auto result = parseHeaders(xpiSet.get(), finalArgs, headerContents,
-                                 job->fileManager, files, arch);
-
-      // The tooling code removes our recording stat cache. We need to re-create
-      // it after every invocation, so we keep recording all the files.
+    for (auto arch : job->architectures)
+      invocations.emplace_back(type, arch);
+  }
+
+  auto getArgs = [&](Architecture arch) {
+    std::vector<std::string> finalArgs;
+    finalArgs.insert(finalArgs.end(), commonArgs.begin(), commonArgs.end());
+    std::string target("--target=");
+    target += makeTargetTriple(arch, job->platform);
+    finalArgs.emplace_back(target);
+    return finalArgs;
+  };
+
+  // SmallString::c_str() modifies the string, so only call it once.
+  const char *publicContents = publicHeaderContents.c_str();
+  const char *privateContents = privateHeaderContents.c_str();
+  auto getHeaderContents = [&](HeaderType type) {
+    return type == HeaderType::Public ? publicContents : privateContents;
+  };
+
+  std::unique_ptr<XPISet> xpiSet(new XPISet);
+
+  // All invocations would write the same serialized diagnostics file, so they
+  // have to run one after another.
+  unsigned numThreads = std::min<size_t>(job->numThreads, invocations.size());
+  if (numThreads <= 1 || !job->serializeDiagnosticsFile.empty()) {
+    for (const auto &invocation : invocations) {
+      auto type = invocation.first;
+      auto arch = invocation.second;
+      auto result = parseHeaders(xpiSet.get(), getArgs(arch),
+                                 getHeaderContents(type), job->fileManager,
+                                 files, arch);
+
+      // The tooling code removes our recording stat cache. We need to
+      // re-create it after every invocation, so we keep recording all the
+      // files.
       job->fileManager->installStatRecorder();
 
       if (!result.ReturnValue)
         return nullptr;
     }
+
+    return xpiSet;
+  }
+
+  // Parse concurrently into journaled sets. The clang file manager is not
+  // thread-safe, so every invocation gets its own. Merging the sets in the
+  // serial invocation order yields the exact same set as a serial run.
+  // Diagnostics are buffered per invocation and replayed in the same order.
+  std::vector<std::unique_ptr<XPISet>> localSets(invocations.size());
+  std::vector<std::string> diagnostics(invocations.size());
+  std::vector<int> results(invocations.size(), 0);
+  ThreadPool pool(numThreads);
+  for (size_t i = 0; i < invocations.size(); ++i) {
+    pool.async([&, i]() {
+      auto type = invocations[i].first;
+      auto arch = invocations[i].second;
+      FileManager fm(job->fileManager->getFileSystemOpts(),
+                     job->fileManager->getVirtualFileSystem());
+
+      // The scanner identifies the header files by their file entries.
+      std::map<const FileEntry *, HeaderType> localFiles;
+      for (const auto &it : files)
+        if (const auto *file = fm.getFile(it.first->getName()))
+          localFiles.emplace(file, it.second);
+
+      raw_string_ostream diagOS(diagnostics[i]);
+      TextDiagnosticPrinter diagPrinter(diagOS, new DiagnosticOptions());
+
+      localSets[i].reset(new XPISet(/*isJournaled=*/true));
+      auto result = parseHeaders(localSets[i].get(), getArgs(arch),
+                                 getHeaderContents(type), &fm, localFiles,
+                                 arch, &diagPrinter);
+      diagOS.flush();
+      results[i] = result.ReturnValue;
+    });
+  }
+  pool.wait();
+
+  // A serial run stops at the first failing invocation, so only report the
+  // diagnostics up to that one.
+  for (size_t i = 0; i < invocations.size(); ++i) {
+    errs() << diagnostics[i];
+    if (!results[i])
+      return nullptr;
+    xpiSet->merge(*localSets[i]);
   }
 
   return xpiSet;
@@ -0,0 +1,104 @@
+//===- libtapi/InterfaceFileCache.cpp - Parsed Interface File Cache -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the process-wide cache of parsed interface files.
+///
+//===----------------------------------------------------------------------===//
+#include "InterfaceFileCache.h"
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+InterfaceFileCache &InterfaceFileCache::get() {
+  static InterfaceFileCache cache;
+  return cache;
+}
+
+InterfaceFileCache::FilePtr
+InterfaceFileCache::lookup(StringRef path, uint64_t hash, uint64_t size) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _index.find(path);
+  if (it == _index.end()) {
+    ++_numMisses;
+    return nullptr;
+  }
+
+  auto entry = it->second;
+  if (entry->hash != hash || entry->size != size) {
+    // The file has been modified since it was cached.
+    erase(entry);
+    ++_numMisses;
+    return nullptr;
+  }
+
+  _entries.splice(_entries.begin(), _entries, entry);
+  ++_numHits;
+  return entry->file;
+}
+
+void InterfaceFileCache::insert(StringRef path, uint64_t hash, uint64_t size,
+                                FilePtr file) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _index.find(path);
+  if (it != _index.end())
+    erase(it->second);
+
+  uint64_t capacity = _capacity;
+  if (size > capacity)
+    return;
+
+  shrinkTo(capacity - size);
+  _entries.push_front({path, hash, size, std::move(file)});
+  _index[path] = _entries.begin();
+  _size += size;
+}
+
+void InterfaceFileCache::evict(StringRef path) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _index.find(path);
+  if (it == _index.end())
+    return;
+
+  erase(it->second);
+  ++_numEvictions;
+}
+
+void InterfaceFileCache::clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _numEvictions += _entries.size();
+  _entries.clear();
+  _index.clear();
+  _size = 0;
+}
+
+void InterfaceFileCache::setCapacity(uint64_t capacity) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _capacity = capacity;
+  shrinkTo(capacity);
+}
+
+uint64_t InterfaceFileCache::getSize() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _size;
+}
+
+void InterfaceFileCache::erase(EntryList::iterator it) {
+  _size -= it->size;
+  _index.erase(it->path);
+  _entries.erase(it);
+}
+
+void InterfaceFileCache::shrinkTo(uint64_t capacity) {
+  while (_size > capacity) {
+    erase(std::prev(_entries.end()));
+    ++_numEvictions;
+  }
+}
+
+TAPI_NAMESPACE_INTERNAL_END
@@ -0,0 +1,96 @@
+//===- libtapi/InterfaceFileCache.h - Parsed Interface File Cache -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the process-wide cache of parsed interface files.
+///
+//===----------------------------------------------------------------------===//
+#ifndef TAPI_LIBTAPI_INTERFACE_FILE_CACHE_H
+#define TAPI_LIBTAPI_INTERFACE_FILE_CACHE_H
+
+#include "LinkerDirectives.h"
+#include "tapi/Core/LLVM.h"
+#include "tapi/Defines.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief A size-bounded LRU cache of parsed interface files.
+///
+/// Entries are keyed by the path of the file and a hash of its content, so a
+/// modified file is never served from the cache. The size of an entry is
+/// approximated by the size of the text-based stub file it was parsed from.
+/// Every cached interface file owns its own copy of the input buffer and
+/// contains all architectures of the original file. The pre-parsed linker
+/// directives are cached together with the interface file.
+///
+/// The cache is disabled until it is given a non-zero capacity. All methods
+/// are thread-safe.
+class InterfaceFileCache {
+public:
+  using FilePtr = std::shared_ptr<const ParsedInterfaceFile>;
+
+  /// \brief Return the process-wide cache instance.
+  static InterfaceFileCache &get();
+
+  bool isEnabled() const { return _capacity != 0; }
+
+  /// \brief Look up the interface file for the given path and content hash.
+  FilePtr lookup(StringRef path, uint64_t hash, uint64_t size);
+
+  /// \brief Add the interface file for the given path and content hash. This
+  ///        replaces any previous entry for the same path.
+  void insert(StringRef path, uint64_t hash, uint64_t size, FilePtr file);
+
+  /// \brief Remove the entry for the given path (if any).
+  void evict(StringRef path);
+
+  /// \brief Remove all entries.
+  void clear();
+
+  void setCapacity(uint64_t capacity);
+  uint64_t getCapacity() const { return _capacity; }
+  uint64_t getSize();
+
+  uint64_t getNumHits() const { return _numHits; }
+  uint64_t getNumMisses() const { return _numMisses; }
+  uint64_t getNumEvictions() const { return _numEvictions; }
+
+private:
+  struct Entry {
+    std::string path;
+    uint64_t hash;
+    uint64_t size;
+    FilePtr file;
+  };
+  using EntryList = std::list<Entry>;
+
+  void erase(EntryList::iterator it);
+  void shrinkTo(uint64_t capacity);
+
+  std::mutex _mutex;
+  /// Most recently used entries come first.
+  EntryList _entries;
+  llvm::StringMap<EntryList::iterator> _index;
+  uint64_t _size = 0;
+
+  std::atomic<uint64_t> _capacity{0};
+  std::atomic<uint64_t> _numHits{0};
+  std::atomic<uint64_t> _numMisses{0};
+  std::atomic<uint64_t> _numEvictions{0};
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_LIBTAPI_INTERFACE_FILE_CACHE_H
@@ -0,0 +1,117 @@
+//===- libtapi/LinkerDirectives.cpp - Linker Directive Index --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Implements the index of pre-parsed $ld$ linker directives.
+///
+//===----------------------------------------------------------------------===//
+#include "LinkerDirectives.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSwitch.h"
+#include <algorithm>
+#include <tuple>
+
+using namespace llvm;
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+PackedVersion32 parseVersion32(StringRef str) {
+  uint32_t version = 0;
+  if (str.empty())
+    return 0;
+
+  SmallVector<StringRef, 3> parts;
+  SplitString(str, parts, ".");
+
+  unsigned long long num = 0;
+  if (getAsUnsignedInteger(parts[0], 10, num))
+    return 0;
+
+  if (num > UINT16_MAX)
+    return 0;
+
+  version = num << 16;
+
+  if (parts.size() > 1) {
+    if (getAsUnsignedInteger(parts[1], 10, num))
+      return 0;
+
+    if (num > UINT8_MAX)
+      return 0;
+
+    version |= (num << 8);
+  }
+
+  if (parts.size() > 2) {
+    if (getAsUnsignedInteger(parts[2], 10, num))
+      return 0;
+
+    if (num > UINT8_MAX)
+      return 0;
+
+    version |= num;
+  }
+
+  return version;
+}
+
+LinkerDirectives::LinkerDirectives(const InterfaceFile &interface) {
+  for (const auto *symbol :
+       interface.exports(ArchitectureSet::All(), SymbolKind::GlobalSymbol)) {
+    // $ld$ <action> $ <condition> $ <symbol-name>
+    auto name = symbol->getName();
+    if (!name.startswith("$ld$"))
+      continue;
+
+    StringRef action, condition, symbolName;
+    std::tie(action, name) = name.drop_front(4).split('$');
+    std::tie(condition, symbolName) = name.split('$');
+    if (action.empty() || condition.empty() || symbolName.empty())
+      continue;
+
+    if (!condition.startswith("os"))
+      continue;
+
+    auto kind = StringSwitch<Optional<Action>>(action)
+                    .Case("hide", Action::Hide)
+                    .Case("add", Action::Add)
+                    .Case("weak", Action::Weak)
+                    .Case("install_name", Action::InstallName)
+                    .Case("compatibility_version",
+                          Action::CompatibilityVersion)
+                    .Default(llvm::None);
+    if (!kind)
+      continue;
+
+    _directives.push_back({parseVersion32(condition.drop_front(2)), *kind,
+                           symbol->getArchitectures(), symbolName});
+  }
+
+  // Keep the original order for directives of the same version. Later
+  // directives override earlier ones.
+  std::stable_sort(_directives.begin(), _directives.end(), compareVersion);
+}
+
+bool LinkerDirectives::compareVersion(const Directive &lhs,
+                                      const Directive &rhs) {
+  return lhs.osVersion < rhs.osVersion;
+}
+
+ArrayRef<LinkerDirectives::Directive>
+LinkerDirectives::lookup(PackedVersion32 osVersion) const {
+  Directive key{osVersion, Action::Hide, ArchitectureSet(), StringRef()};
+  auto range = std::equal_range(_directives.begin(), _directives.end(), key,
+                                compareVersion);
+  return makeArrayRef(_directives)
+      .slice(range.first - _directives.begin(), range.second - range.first);
+}
+
+TAPI_NAMESPACE_INTERNAL_END
@@ -0,0 +1,81 @@
+//===- libtapi/LinkerDirectives.h - Linker Directive Index ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the index of pre-parsed $ld$ linker directives.
+///
+//===----------------------------------------------------------------------===//
+#ifndef TAPI_LIBTAPI_LINKER_DIRECTIVES_H
+#define TAPI_LIBTAPI_LINKER_DIRECTIVES_H
+
+#include "tapi/Core/ArchitectureSet.h"
+#include "tapi/Core/InterfaceFile.h"
+#include "tapi/Core/LLVM.h"
+#include "tapi/Defines.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include <memory>
+#include <tapi/PackedVersion32.h>
+#include <vector>
+
+TAPI_NAMESPACE_INTERNAL_BEGIN
+
+/// \brief Parse a version string of the form X[.Y[.Z]] for the linker.
+///
+/// Returns 0 for invalid version strings.
+PackedVersion32 parseVersion32(StringRef str);
+
+/// \brief The $ld$ directives of an interface file.
+///
+/// Linker directives are exported symbols of the form
+/// $ld$ <action> $ os<version> $ <symbol-name>. They only apply when the
+/// minimum deployment target matches the version exactly. The directives are
+/// parsed once and sorted by version, so every LinkerInterfaceFile only has
+/// to look at the directives for its deployment target.
+class LinkerDirectives {
+public:
+  enum class Action : uint8_t {
+    Hide,
+    Add,
+    Weak,
+    InstallName,
+    CompatibilityVersion,
+  };
+
+  struct Directive {
+    PackedVersion32 osVersion;
+    Action action;
+    ArchitectureSet archs;
+    StringRef symbolName;
+  };
+
+  explicit LinkerDirectives(const InterfaceFile &interface);
+
+  /// \brief Return the directives for the given OS version in the order in
+  ///        which they appear in the interface file.
+  ArrayRef<Directive> lookup(PackedVersion32 osVersion) const;
+
+private:
+  static bool compareVersion(const Directive &lhs, const Directive &rhs);
+
+  std::vector<Directive> _directives;
+};
+
+/// \brief A parsed interface file together with its linker directives.
+struct ParsedInterfaceFile {
+  explicit ParsedInterfaceFile(std::unique_ptr<const InterfaceFile> file)
+      : interface(std::move(file)), directives(*interface) {}
+
+  std::unique_ptr<const InterfaceFile> interface;
+  LinkerDirectives directives;
+};
+
+TAPI_NAMESPACE_INTERNAL_END
+
+#endif // TAPI_LIBTAPI_LINKER_DIRECTIVES_H
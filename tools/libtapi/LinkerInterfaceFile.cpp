@@ -11,13 +11,24 @@
 /// \brief Implements the C++ linker interface file API.
 ///
 //===----------------------------------------------------------------------===//
+#include "InterfaceFileCache.h"
+#include "LinkerDirectives.h"
 #include "tapi/Core/ExtendedInterfaceFile.h"
 #include "tapi/Core/InterfaceFile.h"
 #include "tapi/Core/LLVM.h"
 #include "tapi/Core/Registry.h"
+#include "tapi/Core/MachODylibReader.h"
 #include "tapi/Core/STLExtras.h"
-#include "llvm/ADT/StringExtras.h"
+#include "tapi/Core/TextStubReader.h"
 #include "llvm/Object/MachO.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/xxhash.h"
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <string>
 #include <tapi/LinkerInterfaceFile.h>
 #include <tapi/PackedVersion32.h>
@@ -29,44 +40,15 @@ TAPI_NAMESPACE_V1_BEGIN
 
 using namespace tapi::internal;
 
-static PackedVersion32 parseVersion32(StringRef str) {
-  uint32_t version = 0;
-  if (str.empty())
-    return 0;
-
-  SmallVector<StringRef, 3> parts;
-  SplitString(str, parts, ".");
-
-  unsigned long long num = 0;
-  if (getAsUnsignedInteger(parts[0], 10, num))
-    return 0;
-
-  if (num > UINT16_MAX)
-    return 0;
-
-  version = num << 16;
-
-  if (parts.size() > 1) {
-    if (getAsUnsignedInteger(parts[1], 10, num))
-      return 0;
-
-    if (num > UINT8_MAX)
-      return 0;
-
-    version |= (num << 8);
-  }
-
-  if (parts.size() > 2) {
-    if (getAsUnsignedInteger(parts[2], 10, num))
-      return 0;
-
-    if (num > UINT8_MAX)
-      return 0;
-
-    version |= num;
-  }
-
-  return version;
+/// \brief Copy the concatenation of prefix and name into the string pool.
+static StringRef copyString(BumpPtrAllocator &allocator, StringRef prefix,
+                            StringRef name) {
+  auto length = prefix.size() + name.size();
+  auto *str = allocator.Allocate<char>(length + 1);
+  memcpy(str, prefix.data(), prefix.size());
+  memcpy(str + prefix.size(), name.data(), name.size());
+  str[length] = '\0';
+  return StringRef(str, length);
 }
 
 class LinkerInterfaceFile::Impl {
@@ -88,66 +70,72 @@ public:
   std::vector<std::string> _reexportedLibraries;
   std::vector<std::string> _allowableClients;
   std::vector<std::string> _ignoreExports;
+
+  /// String pool for all exported and undefined symbol names. The pool is
+  /// shared by all files that have been created from the same parse.
+  std::shared_ptr<BumpPtrAllocator> _allocator;
+  std::vector<SymbolRef> _exportRefs;
+  std::vector<SymbolRef> _undefinedRefs;
+
+  /// Lazily constructed for the 1.0 API.
+  std::once_flag _exportsOnce;
+  std::once_flag _undefinedsOnce;
   std::vector<Symbol> _exports;
   std::vector<Symbol> _undefineds;
 
   Impl() noexcept = default;
 
-  template <typename T> void addSymbol(T &&name, SymbolFlags flags) {
-    if (find(_ignoreExports, name) == _ignoreExports.end())
-      _exports.emplace_back(std::forward<T>(name), flags);
-  }
-
-  void processSymbol(StringRef name, PackedVersion32 minOSVersion,
-                     bool disallowWeakImports) {
-    // $ld$ <action> $ <condition> $ <symbol-name>
-    if (!name.startswith("$ld$"))
-      return;
+  static std::vector<std::unique_ptr<LinkerInterfaceFile>>
+  createViews(const ParsedInterfaceFile &file, ArrayRef<Architecture> archs,
+              ParsingFlags flags, PackedVersion32 minOSVersion);
 
-    StringRef action, condition, symbolName;
-    std::tie(action, name) = name.drop_front(4).split('$');
-    std::tie(condition, symbolName) = name.split('$');
-    if (action.empty() || condition.empty() || symbolName.empty())
-      return;
-
-    if (!condition.startswith("os"))
+  void addSymbol(StringRef name, SymbolFlags flags) {
+    // The ignore list is sorted once all directives have been applied.
+    if (!_ignoreExports.empty() &&
+        std::binary_search(_ignoreExports.begin(), _ignoreExports.end(), name))
       return;
+    _exportRefs.emplace_back(name.data(), name.size(), flags);
+  }
 
-    auto version = parseVersion32(condition.drop_front(2));
-    if (version != minOSVersion)
-      return;
+  void addUndefinedSymbol(StringRef name, SymbolFlags flags) {
+    _undefinedRefs.emplace_back(name.data(), name.size(), flags);
+  }
 
-    if (action == "hide") {
-      _ignoreExports.emplace_back(symbolName);
-      return;
-    }
+  static void buildSymbols(std::vector<Symbol> &symbols,
+                           ArrayRef<SymbolRef> refs) {
+    symbols.reserve(refs.size());
+    for (const auto &ref : refs)
+      symbols.emplace_back(std::string(ref.getName(), ref.getNameLength()),
+                           ref.getFlags());
+  }
 
-    if (action == "add") {
-      _exports.emplace_back(symbolName);
-      return;
+  void applyDirective(const LinkerDirectives::Directive &directive,
+                      bool disallowWeakImports) {
+    switch (directive.action) {
+    case LinkerDirectives::Action::Hide:
+      _ignoreExports.emplace_back(directive.symbolName);
+      break;
+    case LinkerDirectives::Action::Add: {
+      auto name = copyString(*_allocator, "", directive.symbolName);
+      _exportRefs.emplace_back(name.data(), name.size());
+      break;
     }
-
-    if (action == "weak") {
+    case LinkerDirectives::Action::Weak:
       if (disallowWeakImports)
-        _ignoreExports.emplace_back(symbolName);
-
-      return;
-    }
-
-    if (action == "install_name") {
-      _installName = symbolName;
+        _ignoreExports.emplace_back(directive.symbolName);
+      break;
+    case LinkerDirectives::Action::InstallName:
+      _installName = directive.symbolName;
       _installPathOverride = true;
       if (_installName == "/System/Library/Frameworks/"
                           "ApplicationServices.framework/Versions/A/"
                           "ApplicationServices") {
         _compatibilityVersion = PackedVersion32(1, 0, 0);
       }
-      return;
-    }
-
-    if (action == "compatibility_version") {
-      _compatibilityVersion = parseVersion32(symbolName);
-      return;
+      break;
+    case LinkerDirectives::Action::CompatibilityVersion:
+      _compatibilityVersion = parseVersion32(directive.symbolName);
+      break;
     }
   }
 };
@@ -167,6 +155,28 @@ static Architecture getArchForCPU(cpu_type_t cpuType, cpu_subtype_t cpuSubType,
   return archs.getABICompatibleSlice(arch);
 }
 
+/// \brief Return all architectures getArchForCPU could possibly select for the
+///        given cpu type and cpu sub type.
+static ArchitectureSet getCandidateArchsForCPU(cpu_type_t cpuType,
+                                               cpu_subtype_t cpuSubType,
+                                               bool enforceCpuSubType) {
+  auto arch = getArchType(cpuType, cpuSubType);
+  if (arch == Architecture::unknown)
+    return ArchitectureSet::All();
+
+  if (enforceCpuSubType)
+    return arch;
+
+  ArchitectureSet archs;
+#define ARCHINFO(name, type, subtype)                                          \
+  if (static_cast<uint32_t>(cpuType) == (type))                                \
+    archs.set(Architecture::name);
+#include "tapi/Core/Architecture.def"
+#undef ARCHINFO
+
+  return archs;
+}
+
 LinkerInterfaceFile::LinkerInterfaceFile() noexcept
     : _pImpl{new LinkerInterfaceFile::Impl} {}
 LinkerInterfaceFile::~LinkerInterfaceFile() noexcept = default;
@@ -180,15 +190,44 @@ LinkerInterfaceFile::getSupportedFileExtensions() noexcept {
   return {".tbd"};
 }
 
+static std::atomic<uint64_t> numAvoidedBufferCopies{0};
+
+/// \brief Wrap the caller provided buffer without copying it.
+///
+/// The buffer is not required to be null-terminated. The text-based stub
+/// reader never looks past the end of the buffer and only copies the buffer
+/// when it has to hand it to the generic YAML reader.
+static std::unique_ptr<MemoryBuffer>
+getMemBufferForInput(const std::string &path, const uint8_t *data,
+                     size_t size) {
+  auto buffer = StringRef(reinterpret_cast<const char *>(data), size);
+  return MemoryBuffer::getMemBuffer(buffer, path,
+                                    /*RequiresNullTerminator=*/false);
+}
+
+namespace {
+struct TextStubRegistry : Registry {
+  TextStubRegistry() { addYAMLReaders(); }
+};
+} // end anonymous namespace.
+
+/// \brief Return the registry for text-based stub files.
+///
+/// The readers are stateless, so the registry is created once and shared by
+/// all threads.
+static const Registry &getTextStubRegistry() {
+  static const TextStubRegistry registry;
+  return registry;
+}
+
 /// \brief Load and parse the provided TBD file in the buffer and return on
 ///        success the interface file.
 static Expected<std::unique_ptr<const InterfaceFile>>
 loadFile(std::unique_ptr<MemoryBuffer> buffer,
-         ReadFlags readFlags = ReadFlags::Symbols) {
-  Registry registry;
-  registry.addYAMLReaders();
-
-  auto textFile = registry.readFile(std::move(buffer), readFlags);
+         ReadFlags readFlags = ReadFlags::Symbols,
+         ArchitectureSet arches = ArchitectureSet::All()) {
+  auto textFile =
+      getTextStubRegistry().readFile(std::move(buffer), readFlags, arches);
   if (!textFile)
     return textFile.takeError();
 
@@ -196,14 +235,55 @@ loadFile(std::unique_ptr<MemoryBuffer> buffer,
       cast<const InterfaceFile>(textFile.get().release()));
 }
 
+/// \brief Return the interface file for the provided buffer.
+///
+/// Without the cache only the requested architectures are read. Cached
+/// interface files contain all architectures, because later requests for the
+/// same file might ask for a different slice.
+static Expected<std::shared_ptr<const ParsedInterfaceFile>>
+getInterfaceFile(const std::string &path, const uint8_t *data, size_t size,
+                 ArchitectureSet arches) {
+  auto &cache = InterfaceFileCache::get();
+  if (!cache.isEnabled()) {
+    auto inputFile = loadFile(getMemBufferForInput(path, data, size),
+                              ReadFlags::Symbols, arches);
+    if (!inputFile)
+      return inputFile.takeError();
+
+    // The file still references the caller provided buffer, unless the reader
+    // had to copy it for the generic YAML parser.
+    auto bufferStart = inputFile.get()->getMemBufferRef().getBufferStart();
+    if (bufferStart == reinterpret_cast<const char *>(data))
+      ++numAvoidedBufferCopies;
+    return std::make_shared<const ParsedInterfaceFile>(
+        std::move(inputFile.get()));
+  }
+
+  auto buffer = StringRef(reinterpret_cast<const char *>(data), size);
+  auto hash = xxHash64(buffer);
+  if (auto file = cache.lookup(path, hash, size))
+    return file;
+
+  // The cached file must not reference the caller provided buffer.
+  auto inputFile = loadFile(MemoryBuffer::getMemBufferCopy(buffer, path));
+  if (!inputFile)
+    return inputFile.takeError();
+
+  auto file =
+      std::make_shared<const ParsedInterfaceFile>(std::move(inputFile.get()));
+  cache.insert(path, hash, size, file);
+  return file;
+}
+
 bool LinkerInterfaceFile::isSupported(const std::string &path,
                                       const uint8_t *data,
                                       size_t size) noexcept {
-  Registry registry;
-  registry.addYAMLReaders();
-  auto memBuffer = MemoryBufferRef(
-      StringRef(reinterpret_cast<const char *>(data), size), path);
-  return registry.canRead(memBuffer);
+  // Only look at the document markers. This is called for every candidate
+  // file on the search paths and must not allocate memory.
+  auto buffer = StringRef(reinterpret_cast<const char *>(data), size);
+  auto fileType = getTextStubFileType(buffer);
+  return fileType == TAPI_INTERNAL::FileType::TBD_V1 ||
+         fileType == TAPI_INTERNAL::FileType::TBD_V2;
 }
 
 bool LinkerInterfaceFile::shouldPreferTextBasedStubFile(
@@ -223,10 +303,6 @@ bool LinkerInterfaceFile::shouldPreferTextBasedStubFile(
 
 bool LinkerInterfaceFile::areEquivalent(const std::string &tbdPath,
                                         const std::string &dylibPath) noexcept {
-  Registry registry;
-  registry.addYAMLReaders();
-  registry.addBinaryReaders();
-
   auto tbdErrorOr = MemoryBuffer::getFile(tbdPath);
   if (tbdErrorOr.getError())
     return false;
@@ -240,29 +316,29 @@ bool LinkerInterfaceFile::areEquivalent(const std::string &tbdPath,
   if (textFile.get()->uuids().empty())
     return false;
 
-  auto machoErrorOr = MemoryBuffer::getFile(dylibPath);
+  // Only the load commands are needed to compare the UUIDs.
+  auto machoErrorOr = MemoryBuffer::getFile(dylibPath, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false);
   if (machoErrorOr.getError())
     return false;
 
-  auto machoFile =
-      registry.readFile(std::move(machoErrorOr.get()), ReadFlags::Header);
-  if (!machoFile) {
-    consumeError(machoFile.takeError());
+  auto dylibUUIDs = readMachOUUIDs(machoErrorOr.get()->getMemBufferRef());
+  if (!dylibUUIDs) {
+    consumeError(dylibUUIDs.takeError());
     return false;
   }
 
-  auto *dylibFile = cast<InterfaceFileBase>(machoFile.get().get());
   for (const auto &uuid1 : textFile.get()->uuids()) {
     // Ignore unknown architectures.
     if (uuid1.first == Architecture::unknown)
       continue;
 
-    auto it = find_if(dylibFile->uuids(),
+    auto it = find_if(*dylibUUIDs,
                       [&](const std::pair<Architecture, std::string> &uuid2) {
                         return uuid1.first == uuid2.first;
                       });
 
-    if (it == dylibFile->uuids().end())
+    if (it == dylibUUIDs->end())
       continue;
 
     if (uuid1 != *it)
@@ -288,164 +364,307 @@ LinkerInterfaceFile *LinkerInterfaceFile::create(
     const std::string &path, const uint8_t *data, size_t size,
     cpu_type_t cpuType, cpu_subtype_t cpuSubType, ParsingFlags flags,
     PackedVersion32 minOSVersion, std::string &errorMessage) noexcept {
-  if (path.empty() || data == nullptr || size < 8) {
-    errorMessage = "invalid argument";
+  auto files = createForArchitectures(path, data, size,
+                                      {std::make_pair(cpuType, cpuSubType)},
+                                      flags, minOSVersion, errorMessage);
+  if (files.empty())
     return nullptr;
+
+  return files.front().release();
+}
+
+std::vector<std::unique_ptr<LinkerInterfaceFile>>
+LinkerInterfaceFile::createForArchitectures(
+    const std::string &path, const uint8_t *data, size_t size,
+    const std::vector<std::pair<cpu_type_t, cpu_subtype_t>> &cpuTypes,
+    ParsingFlags flags, PackedVersion32 minOSVersion,
+    std::string &errorMessage) noexcept {
+  if (path.empty() || data == nullptr || size < 8 || cpuTypes.empty()) {
+    errorMessage = "invalid argument";
+    return {};
   }
 
-  // Use a copy to make sure the buffer is null-terminated (the YAML parser
-  // relies on that). Mmap guarantees that pages are padded with zeros, so
-  // this mostly works, but it breaks down when a TBD file size is exactly
-  // a multiple of the page size. 
-  // We could make the copy conditional on the file size, but as we're going
-  // to read it completely anyway, I doubt there's any real performance
-  // benefit to balance the added complexity.
-  auto input = MemoryBuffer::getMemBufferCopy(
-      StringRef(reinterpret_cast<const char *>(data), size), path);
-
-  auto inputFile = loadFile(std::move(input));
+  // Only the sections for the requested slices are of interest to the linker.
+  // The slices are selected after parsing, so all architectures they could
+  // resolve to have to be read.
+  bool enforceCpuSubType = flags & ParsingFlags::ExactCpuSubType;
+  ArchitectureSet arches;
+  for (const auto &cpu : cpuTypes)
+    arches |= getCandidateArchsForCPU(cpu.first, cpu.second, enforceCpuSubType);
+
+  auto inputFile = getInterfaceFile(path, data, size, arches);
   if (!inputFile) {
     errorMessage = toString(inputFile.takeError());
-    return nullptr;
+    return {};
   }
 
-  const auto *interface = inputFile.get().get();
-  bool enforceCpuSubType = flags & ParsingFlags::ExactCpuSubType;
-  auto arch = getArchForCPU(cpuType, cpuSubType, enforceCpuSubType,
-                            interface->getArchitectures());
-  if (arch == Architecture::unknown) {
-    auto arch = getArchType(cpuType, cpuSubType);
-    auto count = interface->getArchitectures().count();
-    if (count > 1)
-      errorMessage = "missing required architecture " +
-                     getArchName(arch).str() + " in file " + path + " (" +
-                     std::to_string(count) + " slices)";
-    else
-      errorMessage = "missing required architecture " +
-                     getArchName(arch).str() + " in file " + path;
-    return nullptr;
+  const auto *interface = inputFile.get()->interface.get();
+  SmallVector<Architecture, 4> archs;
+  for (const auto &cpu : cpuTypes) {
+    auto arch = getArchForCPU(cpu.first, cpu.second, enforceCpuSubType,
+                              interface->getArchitectures());
+    if (arch == Architecture::unknown) {
+      auto arch = getArchType(cpu.first, cpu.second);
+      auto count = interface->getArchitectures().count();
+      if (count > 1)
+        errorMessage = "missing required architecture " +
+                       getArchName(arch).str() + " in file " + path + " (" +
+                       std::to_string(count) + " slices)";
+      else
+        errorMessage = "missing required architecture " +
+                       getArchName(arch).str() + " in file " + path;
+      return {};
+    }
+    archs.emplace_back(arch);
   }
 
   // Remove the patch level.
   minOSVersion =
       PackedVersion32(minOSVersion.getMajor(), minOSVersion.getMinor(), 0);
 
-  auto file = new LinkerInterfaceFile;
-  if (file == nullptr) {
-    errorMessage = "could not allocate memory";
-    return nullptr;
+  return Impl::createViews(*inputFile.get(), archs, flags, minOSVersion);
+}
+
+std::vector<std::unique_ptr<LinkerInterfaceFile>>
+LinkerInterfaceFile::createBatch(const std::vector<InputBuffer> &inputs,
+                                 cpu_type_t cpuType, cpu_subtype_t cpuSubType,
+                                 ParsingFlags flags,
+                                 PackedVersion32 minOSVersion,
+                                 std::vector<std::string> &errorMessages,
+                                 unsigned numThreads) noexcept {
+  std::vector<std::unique_ptr<LinkerInterfaceFile>> files(inputs.size());
+  errorMessages.assign(inputs.size(), std::string());
+
+  auto createFile = [&](size_t i) {
+    const auto &input = inputs[i];
+    files[i].reset(create(input.path, input.data, input.size, cpuType,
+                          cpuSubType, flags, minOSVersion, errorMessages[i]));
+  };
+
+  if (numThreads == 0)
+    numThreads = std::thread::hardware_concurrency();
+  numThreads = std::min<size_t>(numThreads, inputs.size());
+
+  if (numThreads <= 1) {
+    for (size_t i = 0, e = inputs.size(); i != e; ++i)
+      createFile(i);
+    return files;
   }
 
-  file->_pImpl->_platform = interface->getPlatform();
-  file->_pImpl->_installName = interface->getInstallName();
-  file->_pImpl->_currentVersion = interface->getCurrentVersion();
-  file->_pImpl->_compatibilityVersion = interface->getCompatibilityVersion();
-  file->_pImpl->_hasTwoLevelNamespace = interface->isTwoLevelNamespace();
-  file->_pImpl->_isAppExtensionSafe = interface->isApplicationExtensionSafe();
-  file->_pImpl->_objcConstraint = interface->getObjCConstraint();
-  file->_pImpl->_swiftABIVersion = interface->getSwiftABIVersion();
-  file->_pImpl->_parentFrameworkName = interface->getParentUmbrella();
-  if (interface->getFileType() == TAPI_INTERNAL::FileType::TBD_V1)
-    file->_pImpl->_fileType = FileType::TBD_V1;
-  else if (interface->getFileType() == TAPI_INTERNAL::FileType::TBD_V2)
-    file->_pImpl->_fileType = FileType::TBD_V2;
-  else
-    file->_pImpl->_fileType = FileType::Unsupported;
-
-  auto platform = interface->getPlatform();
-
-  // Pre-scan for special linker symbols.
-  for (const auto *symbol : interface->exports()) {
-    if (symbol->getKind() != SymbolKind::GlobalSymbol)
-      continue;
+  // Every task writes only to its own result slot, so no further
+  // synchronization is required.
+  ThreadPool pool(numThreads);
+  for (size_t i = 0, e = inputs.size(); i != e; ++i)
+    pool.async(createFile, i);
+  pool.wait();
 
-    if (!symbol->getArchitectures().has(arch))
-      continue;
+  return files;
+}
 
-    file->_pImpl->processSymbol(symbol->getName(), minOSVersion,
-                                flags & ParsingFlags::DisallowWeakImports);
+/// \brief Provides the linker symbol names of a single symbol.
+///
+/// A symbol usually maps to the same linker symbol names for all requested
+/// architectures. Each name is only copied into the string pool once and is
+/// shared by all views.
+class LinkerSymbolNames {
+public:
+  explicit LinkerSymbolNames(BumpPtrAllocator &allocator)
+      : _allocator(allocator) {}
+
+  void reset(StringRef name) {
+    _name = name;
+    _names.clear();
   }
-  sort(file->_pImpl->_ignoreExports);
-  auto last = std::unique(file->_pImpl->_ignoreExports.begin(),
-                          file->_pImpl->_ignoreExports.end());
-  file->_pImpl->_ignoreExports.erase(last, file->_pImpl->_ignoreExports.end());
 
-  for (const auto *symbol : interface->exports()) {
-    if (!symbol->getArchitectures().has(arch))
-      continue;
+  StringRef get(StringRef prefix) {
+    for (const auto &entry : _names)
+      if (entry.first == prefix)
+        return entry.second;
 
-    switch (symbol->getKind()) {
-    case SymbolKind::GlobalSymbol:
-      if (symbol->getName().startswith("$ld$"))
-        continue;
-      file->_pImpl->addSymbol(symbol->getName(), symbol->getFlags());
-      break;
-    case SymbolKind::ObjectiveCClass:
-      if (platform == Platform::OSX && arch == Architecture::i386) {
-        file->_pImpl->addSymbol(".objc_class_name_" + symbol->getName().str(),
-                                symbol->getFlags());
-      } else {
-        file->_pImpl->addSymbol("_OBJC_CLASS_$_" + symbol->getName().str(),
-                                symbol->getFlags());
-        file->_pImpl->addSymbol("_OBJC_METACLASS_$_" + symbol->getName().str(),
-                                symbol->getFlags());
-      }
-      break;
-    case SymbolKind::ObjectiveCClassEHType:
-      file->_pImpl->addSymbol("_OBJC_EHTYPE_$_" + symbol->getName().str(),
-                              symbol->getFlags());
-      break;
-    case SymbolKind::ObjectiveCInstanceVariable:
-      file->_pImpl->addSymbol("_OBJC_IVAR_$_" + symbol->getName().str(),
-                              symbol->getFlags());
-      break;
+    auto name = copyString(_allocator, prefix, _name);
+    _names.emplace_back(prefix, name);
+    return name;
+  }
+
+private:
+  BumpPtrAllocator &_allocator;
+  StringRef _name;
+  SmallVector<std::pair<StringRef, StringRef>, 2> _names;
+};
+
+/// \brief Invoke the callback with the prefix of every linker symbol the
+///        symbol expands to.
+template <typename Fn>
+static void forEachLinkerSymbolPrefix(SymbolKind kind, Platform platform,
+                                      Architecture arch, Fn &&callback) {
+  switch (kind) {
+  case SymbolKind::GlobalSymbol:
+    callback("");
+    break;
+  case SymbolKind::ObjectiveCClass:
+    if (platform == Platform::OSX && arch == Architecture::i386) {
+      callback(".objc_class_name_");
+    } else {
+      callback("_OBJC_CLASS_$_");
+      callback("_OBJC_METACLASS_$_");
     }
+    break;
+  case SymbolKind::ObjectiveCClassEHType:
+    callback("_OBJC_EHTYPE_$_");
+    break;
+  case SymbolKind::ObjectiveCInstanceVariable:
+    callback("_OBJC_IVAR_$_");
+    break;
+  }
+}
 
-    if (symbol->isWeakDefined())
-      file->_pImpl->_hasWeakDefExports = true;
+std::vector<std::unique_ptr<LinkerInterfaceFile>>
+LinkerInterfaceFile::Impl::createViews(const ParsedInterfaceFile &file,
+                                       ArrayRef<Architecture> archs,
+                                       ParsingFlags flags,
+                                       PackedVersion32 minOSVersion) {
+  const auto &interface = *file.interface;
+  auto directives = file.directives.lookup(minOSVersion);
+  auto allocator = std::make_shared<BumpPtrAllocator>();
+  auto platform = interface.getPlatform();
+  auto exports = interface.exports();
+  auto undefineds = interface.undefineds();
+
+  std::vector<std::unique_ptr<LinkerInterfaceFile>> files;
+  files.reserve(archs.size());
+  for (auto arch : archs) {
+    std::unique_ptr<LinkerInterfaceFile> file(new LinkerInterfaceFile);
+    auto &impl = *file->_pImpl;
+    impl._allocator = allocator;
+    impl._platform = interface.getPlatform();
+    impl._installName = interface.getInstallName();
+    impl._currentVersion = interface.getCurrentVersion();
+    impl._compatibilityVersion = interface.getCompatibilityVersion();
+    impl._hasTwoLevelNamespace = interface.isTwoLevelNamespace();
+    impl._isAppExtensionSafe = interface.isApplicationExtensionSafe();
+    impl._objcConstraint = interface.getObjCConstraint();
+    impl._swiftABIVersion = interface.getSwiftABIVersion();
+    impl._parentFrameworkName = interface.getParentUmbrella();
+    if (interface.getFileType() == TAPI_INTERNAL::FileType::TBD_V1)
+      impl._fileType = FileType::TBD_V1;
+    else if (interface.getFileType() == TAPI_INTERNAL::FileType::TBD_V2)
+      impl._fileType = FileType::TBD_V2;
+    else
+      impl._fileType = FileType::Unsupported;
+
+    for (const auto &directive : directives)
+      if (directive.archs.has(arch))
+        impl.applyDirective(directive,
+                            flags & ParsingFlags::DisallowWeakImports);
+    sort(impl._ignoreExports);
+    auto last =
+        std::unique(impl._ignoreExports.begin(), impl._ignoreExports.end());
+    impl._ignoreExports.erase(last, impl._ignoreExports.end());
+
+    for (const auto &client : interface.allowableClients())
+      if (client.hasArchitecture(arch))
+        impl._allowableClients.emplace_back(client.getInstallName());
+
+    for (const auto &reexport : interface.reexportedLibraries())
+      if (reexport.hasArchitecture(arch))
+        impl._reexportedLibraries.emplace_back(reexport.getInstallName());
+
+    impl._exportRefs.reserve(impl._exportRefs.size() +
+                             std::distance(exports.begin(), exports.end()));
+    impl._undefinedRefs.reserve(
+        std::distance(undefineds.begin(), undefineds.end()));
+    files.emplace_back(std::move(file));
   }
 
-  for (const auto *symbol : interface->undefineds()) {
-    if (!symbol->getArchitectures().has(arch))
+  // Only visit the symbols of the requested architectures. The filter scans
+  // the symbol columns and a symbol is only dereferenced for its name.
+  ArchitectureSet requested;
+  for (auto arch : archs)
+    requested.set(arch);
+
+  LinkerSymbolNames names(*allocator);
+  auto requestedExports = interface.exports(requested);
+  for (auto it = requestedExports.begin(), end = requestedExports.end();
+       it != end; ++it) {
+    auto kind = it.getKind();
+    auto name = it->getName();
+    if (kind == SymbolKind::GlobalSymbol && name.startswith("$ld$"))
       continue;
 
-    switch (symbol->getKind()) {
-    case SymbolKind::GlobalSymbol:
-      file->_pImpl->_undefineds.emplace_back(symbol->getName(),
-                                             symbol->getFlags());
-      break;
-    case SymbolKind::ObjectiveCClass:
-      if (platform == Platform::OSX && arch == Architecture::i386) {
-        file->_pImpl->_undefineds.emplace_back(
-            ".objc_class_name_" + symbol->getName().str(), symbol->getFlags());
-      } else {
-        file->_pImpl->_undefineds.emplace_back(
-            "_OBJC_CLASS_$_" + symbol->getName().str(), symbol->getFlags());
-        file->_pImpl->_undefineds.emplace_back(
-            "_OBJC_METACLASS_$_" + symbol->getName().str(), symbol->getFlags());
-      }
-      break;
-    case SymbolKind::ObjectiveCClassEHType:
-      file->_pImpl->_undefineds.emplace_back(
-          "_OBJC_EHTYPE_$_" + symbol->getName().str(), symbol->getFlags());
-      break;
-    case SymbolKind::ObjectiveCInstanceVariable:
-      file->_pImpl->_undefineds.emplace_back(
-          "_OBJC_IVAR_$_" + symbol->getName().str(), symbol->getFlags());
-      break;
+    auto symbolArchs = it.getArchitectures();
+    auto symbolFlags = it.getFlags();
+    names.reset(name);
+    for (unsigned i = 0, e = archs.size(); i != e; ++i) {
+      if (!symbolArchs.has(archs[i]))
+        continue;
+
+      auto &impl = *files[i]->_pImpl;
+      forEachLinkerSymbolPrefix(
+          kind, platform, archs[i], [&](StringRef prefix) {
+            impl.addSymbol(names.get(prefix), symbolFlags);
+          });
+
+      if ((symbolFlags & SymbolFlags::WeakDefined) == SymbolFlags::WeakDefined)
+        impl._hasWeakDefExports = true;
     }
   }
 
-  for (const auto &client : interface->allowableClients())
-    if (client.hasArchitecture(arch))
-      file->_pImpl->_allowableClients.emplace_back(client.getInstallName());
+  auto requestedUndefineds = interface.undefineds(requested);
+  for (auto it = requestedUndefineds.begin(), end = requestedUndefineds.end();
+       it != end; ++it) {
+    auto kind = it.getKind();
+    auto symbolArchs = it.getArchitectures();
+    auto symbolFlags = it.getFlags();
+    names.reset(it->getName());
+    for (unsigned i = 0, e = archs.size(); i != e; ++i) {
+      if (!symbolArchs.has(archs[i]))
+        continue;
 
-  for (const auto &reexport : interface->reexportedLibraries())
-    if (reexport.hasArchitecture(arch))
-      file->_pImpl->_reexportedLibraries.emplace_back(
-          reexport.getInstallName());
+      auto &impl = *files[i]->_pImpl;
+      forEachLinkerSymbolPrefix(
+          kind, platform, archs[i], [&](StringRef prefix) {
+            impl.addUndefinedSymbol(names.get(prefix), symbolFlags);
+          });
+    }
+  }
 
-  return file;
+  return files;
+}
+
+uint64_t LinkerInterfaceFile::getNumAvoidedBufferCopies() noexcept {
+  return numAvoidedBufferCopies;
+}
+
+void LinkerInterfaceFile::setCacheCapacity(uint64_t capacity) noexcept {
+  InterfaceFileCache::get().setCapacity(capacity);
+}
+
+uint64_t LinkerInterfaceFile::getCacheCapacity() noexcept {
+  return InterfaceFileCache::get().getCapacity();
+}
+
+void LinkerInterfaceFile::evictFromCache(const std::string &path) noexcept {
+  InterfaceFileCache::get().evict(path);
+}
+
+void LinkerInterfaceFile::clearCache() noexcept {
+  InterfaceFileCache::get().clear();
+}
+
+uint64_t LinkerInterfaceFile::getNumCacheHits() noexcept {
+  return InterfaceFileCache::get().getNumHits();
+}
+
+uint64_t LinkerInterfaceFile::getNumCacheMisses() noexcept {
+  return InterfaceFileCache::get().getNumMisses();
+}
+
+uint64_t LinkerInterfaceFile::getNumCacheEvictions() noexcept {
+  return InterfaceFileCache::get().getNumEvictions();
+}
+
+uint64_t LinkerInterfaceFile::getCacheSize() noexcept {
+  return InterfaceFileCache::get().getSize();
 }
 
 FileType LinkerInterfaceFile::getFileType() const noexcept {
@@ -520,11 +739,27 @@ const std::vector<std::string> &LinkerInterfaceFile::ignoreExports() const
 }
 
 const std::vector<Symbol> &LinkerInterfaceFile::exports() const noexcept {
+  std::call_once(_pImpl->_exportsOnce, Impl::buildSymbols,
+                 std::ref(_pImpl->_exports),
+                 ArrayRef<SymbolRef>(_pImpl->_exportRefs));
   return _pImpl->_exports;
 }
 
 const std::vector<Symbol> &LinkerInterfaceFile::undefineds() const noexcept {
+  std::call_once(_pImpl->_undefinedsOnce, Impl::buildSymbols,
+                 std::ref(_pImpl->_undefineds),
+                 ArrayRef<SymbolRef>(_pImpl->_undefinedRefs));
   return _pImpl->_undefineds;
 }
 
+SymbolRefRange LinkerInterfaceFile::exportRefs() const noexcept {
+  const auto &refs = _pImpl->_exportRefs;
+  return SymbolRefRange(refs.data(), refs.data() + refs.size());
+}
+
+SymbolRefRange LinkerInterfaceFile::undefinedRefs() const noexcept {
+  const auto &refs = _pImpl->_undefinedRefs;
+  return SymbolRefRange(refs.data(), refs.data() + refs.size());
+}
+
 TAPI_NAMESPACE_V1_END
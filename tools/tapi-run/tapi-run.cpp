@@ -13,7 +13,11 @@
 ///
 //===----------------------------------------------------------------------===//
 
+#include "tapi/Core/Architecture.h"
 #include "tapi/Core/FileSystem.h"
+#include "tapi/Core/InterfaceFile.h"
+#include "tapi/Core/Registry.h"
+#include "tapi/Core/XPISet.h"
 #include "tapi/tapi.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
@@ -37,6 +41,20 @@ static cl::opt<std::string> inputDirectory(cl::Positional,
                                            cl::desc("<directory>"),
                                            cl::cat(tapiRunCategory));
 
+static cl::opt<bool>
+    singleParse("single-parse",
+                cl::desc("create all architectures from a single parse"),
+                cl::cat(tapiRunCategory));
+
+static cl::opt<bool>
+    batch("batch",
+          cl::desc("collect all files first and create them as one batch"),
+          cl::cat(tapiRunCategory));
+
+static cl::opt<unsigned>
+    numThreads("j", cl::desc("number of worker threads for -batch"),
+               cl::value_desc("0"), cl::init(0), cl::cat(tapiRunCategory));
+
 static cl::opt<std::string> outputFilename("o", cl::desc("Output filename"),
                                            cl::value_desc("filename"));
 
@@ -53,6 +71,34 @@ static cl::opt<unsigned> num("n", cl::desc("number of iterations"),
                              cl::value_desc("1"), cl::init(1),
                              cl::cat(tapiRunCategory));
 
+static cl::opt<unsigned> symbolTableSize(
+    "symbol-table",
+    cl::desc("benchmark the interface file symbol table with the given number "
+             "of synthetic symbols instead of reading a directory"),
+    cl::value_desc("100000"), cl::init(0), cl::cat(tapiRunCategory));
+
+static cl::opt<unsigned> xpiSetSize(
+    "xpi-set",
+    cl::desc("benchmark the XPI set with the given number of synthetic "
+             "declarations instead of reading a directory"),
+    cl::value_desc("100000"), cl::init(0), cl::cat(tapiRunCategory));
+
+enum class ReaderKind {
+  LinkerInterfaceFile,
+  TextStub,
+  YAML,
+};
+
+static cl::opt<ReaderKind> readerKind(
+    "reader", cl::desc("reader used to parse the text-based stub files"),
+    cl::init(ReaderKind::LinkerInterfaceFile),
+    cl::values(clEnumValN(ReaderKind::LinkerInterfaceFile, "libtapi",
+                          "libtapi linker interface (default)"),
+               clEnumValN(ReaderKind::TextStub, "text-stub",
+                          "text-based stub reader"),
+               clEnumValN(ReaderKind::YAML, "yaml", "generic YAML reader")),
+    cl::cat(tapiRunCategory));
+
 static std::tuple<cpu_type_t, cpu_subtype_t, StringRef>
 parseArchKind(StringRef arch) {
   auto cpuType = StringSwitch<cpu_type_t>(arch)
@@ -118,6 +164,127 @@ static tapi::PackedVersion32 parseVersion32(StringRef str) {
   return version;
 }
 
+static void printTime(raw_ostream &os, StringRef name, TimeRecord start) {
+  auto time = TimeRecord::getCurrentTime(/*start=*/false);
+  time -= start;
+  os << "nts." << name << ".user " << format("%0.6f", time.getUserTime())
+     << "\n";
+  os << "nts." << name << ".sys " << format("%0.6f", time.getSystemTime())
+     << "\n";
+  os << "nts." << name << ".wall " << format("%0.6f", time.getWallTime())
+     << "\n";
+}
+
+/// \brief Time adding, looking up, and merging synthetic symbols. These are
+///        the operations that were quadratic in the symbol count before the
+///        symbol table was indexed.
+static void runSymbolTableBenchmark(raw_ostream &os, unsigned numSymbols) {
+  using namespace tapi::internal;
+
+  std::vector<std::string> names;
+  names.reserve(numSymbols);
+  for (unsigned i = 0; i < numSymbols; ++i)
+    names.emplace_back(("_symbol" + Twine(i)).str());
+
+  auto createFile = [&](Architecture arch) {
+    std::unique_ptr<InterfaceFile> file(new InterfaceFile);
+    file->setFileType(FileType::TBD_V2);
+    file->setPlatform(tapi::Platform::OSX);
+    file->setArch(arch);
+    file->setInstallName("/usr/lib/libbenchmark.dylib");
+    for (const auto &name : names)
+      file->addSymbol(SymbolKind::GlobalSymbol, name, arch);
+    return file;
+  };
+
+  for (unsigned j = 0; j < num; ++j) {
+    auto start = TimeRecord::getCurrentTime(/*start=*/true);
+    auto file = createFile(Architecture::x86_64);
+    printTime(os, "symbol-table.add", start);
+
+    start = TimeRecord::getCurrentTime(/*start=*/true);
+    unsigned found = 0;
+    for (const auto &name : names)
+      found += file->contains(SymbolKind::GlobalSymbol, name);
+    printTime(os, "symbol-table.contains", start);
+    assert(found == numSymbols && "missing symbol");
+    (void)found;
+
+    auto other = createFile(Architecture::arm64);
+    start = TimeRecord::getCurrentTime(/*start=*/true);
+    auto merged = file->merge(other.get());
+    printTime(os, "symbol-table.merge", start);
+    if (!merged)
+      consumeError(merged.takeError());
+  }
+}
+
+/// \brief Time the add and find mix of the API scanner. Every declaration is
+///        added once per architecture, every tenth declaration is an
+///        Objective-C class with selectors and a category, and every symbol
+///        and selector is looked up again afterwards.
+static void runXPISetBenchmark(raw_ostream &os, unsigned numDecls) {
+  using namespace tapi::internal;
+
+  std::vector<std::string> names;
+  names.reserve(numDecls);
+  for (unsigned i = 0; i < numDecls; ++i)
+    names.emplace_back(("Symbol" + Twine(i)).str());
+
+  const Architecture archs[] = {Architecture::i386, Architecture::x86_64,
+                                Architecture::arm64};
+  const StringRef selectors[] = {"init", "dealloc", "description", "copy"};
+  const AvailabilityInfo info;
+  const clang::PresumedLoc loc;
+
+  for (unsigned j = 0; j < num; ++j) {
+    XPISet xpiSet;
+    auto start = TimeRecord::getCurrentTime(/*start=*/true);
+    for (auto arch : archs) {
+      for (unsigned i = 0; i < numDecls; ++i) {
+        if (i % 10 != 0) {
+          xpiSet.addGlobalSymbol(names[i], loc, XPIAccess::Public, arch, info);
+          continue;
+        }
+
+        auto *objcClass =
+            xpiSet.addObjCClass(names[i], loc, XPIAccess::Public, arch, info);
+        for (auto selector : selectors)
+          xpiSet.addObjCSelector(objcClass, selector,
+                                 /*isInstanceMethod=*/true,
+                                 /*isDynamic=*/false, loc, XPIAccess::Public,
+                                 arch, info);
+        auto *objcCategory = xpiSet.addObjCCategory(
+            objcClass, "Extras", loc, XPIAccess::Public, arch, info);
+        xpiSet.addObjCSelector(objcCategory, "extra",
+                               /*isInstanceMethod=*/true, /*isDynamic=*/false,
+                               loc, XPIAccess::Public, arch, info);
+      }
+    }
+    printTime(os, "xpi-set.add", start);
+
+    start = TimeRecord::getCurrentTime(/*start=*/true);
+    unsigned found = 0;
+    for (unsigned i = 0; i < numDecls; ++i) {
+      if (i % 10 != 0) {
+        found += xpiSet.findSymbol(XPIKind::GlobalSymbol, names[i]) != nullptr;
+        continue;
+      }
+
+      found += xpiSet.findSymbol(XPIKind::ObjectiveCClass, names[i]) != nullptr;
+      for (auto selector : selectors)
+        found += xpiSet.findSelector({names[i], selector,
+                                      /*isInstanceMethod=*/true,
+                                      /*containerIsProtocol=*/false}) !=
+                 nullptr;
+      found += xpiSet.findCategory({names[i], "Extras"}) != nullptr;
+    }
+    printTime(os, "xpi-set.find", start);
+    assert(found == numDecls + (numDecls + 9) / 10 * 5 && "missing symbol");
+    (void)found;
+  }
+}
+
 int main(int argc, const char *argv[]) {
   // Standard set up, so program fails gracefully.
   sys::PrintStackTraceOnErrorSignal(argv[0]);
@@ -127,6 +294,31 @@ int main(int argc, const char *argv[]) {
   cl::HideUnrelatedOptions(tapiRunCategory);
   cl::ParseCommandLineOptions(argc, argv, "TAPI Run Tool\n");
 
+  if (outputFilename.empty())
+    outputFilename = "-";
+
+  if (symbolTableSize != 0) {
+    std::error_code ec;
+    raw_fd_ostream file(outputFilename, ec, sys::fs::OpenFlags::F_None);
+    if (ec) {
+      errs() << "error: " << ec.message() << "\n";
+      return 1;
+    }
+    runSymbolTableBenchmark(file, symbolTableSize);
+    return 0;
+  }
+
+  if (xpiSetSize != 0) {
+    std::error_code ec;
+    raw_fd_ostream file(outputFilename, ec, sys::fs::OpenFlags::F_None);
+    if (ec) {
+      errs() << "error: " << ec.message() << "\n";
+      return 1;
+    }
+    runXPISetBenchmark(file, xpiSetSize);
+    return 0;
+  }
+
   if (inputDirectory.empty()) {
     cl::PrintHelpMessage();
     return 0;
@@ -163,6 +355,10 @@ int main(int argc, const char *argv[]) {
     return 1;
   }
 
+  std::vector<std::pair<cpu_type_t, cpu_subtype_t>> cpuTypes;
+  for (auto &arch : archSet)
+    cpuTypes.emplace_back(std::get<0>(arch), std::get<1>(arch));
+
   if (deploymentTarget.empty()) {
     errs() << "error: no minimum deployment target specified.\n";
     return 1;
@@ -174,14 +370,17 @@ int main(int argc, const char *argv[]) {
     return 1;
   }
 
-  if (outputFilename.empty())
-    outputFilename = "-";
-
   std::error_code ec2;
   raw_fd_ostream file(outputFilename, ec2, sys::fs::OpenFlags::F_None);
 
   auto currentBenchmarkName = sys::path::stem(path);
 
+  tapi::internal::Registry registry;
+  registry.addYAMLReaders(readerKind == ReaderKind::TextStub);
+
+  std::vector<std::unique_ptr<MemoryBuffer>> batchBuffers;
+  std::vector<std::string> batchPaths;
+
   auto start = TimeRecord::getCurrentTime(/*start=*/true);
   std::error_code ec;
   for (sys::fs::recursive_directory_iterator i(path, ec), ie; i != ie;
@@ -214,9 +413,44 @@ int main(int argc, const char *argv[]) {
       return 1;
     }
 
+    if (readerKind == ReaderKind::LinkerInterfaceFile && batch) {
+      batchBuffers.emplace_back(std::move(bufferOrError.get()));
+      batchPaths.emplace_back(i->path());
+      continue;
+    }
+
     auto buffer = bufferOrError.get()->getBuffer();
+    if (readerKind == ReaderKind::LinkerInterfaceFile && singleParse) {
+      for (unsigned j = 0; j < num; ++j) {
+        std::string errorMessage;
+        auto files = tapi::LinkerInterfaceFile::createForArchitectures(
+            i->path(), reinterpret_cast<const uint8_t *>(buffer.data()),
+            buffer.size(), cpuTypes, tapi::ParsingFlags::None, packedVersion,
+            errorMessage);
+        if (files.empty()) {
+          errs() << "error: " << errorMessage << "\n";
+          return 1;
+        }
+      }
+      continue;
+    }
+
     for (auto &arch : archSet) {
       for (unsigned j = 0; j < num; ++j) {
+        if (readerKind != ReaderKind::LinkerInterfaceFile) {
+          auto file = registry.readFile(
+              MemoryBuffer::getMemBuffer(
+                  bufferOrError.get()->getMemBufferRef()),
+              tapi::internal::ReadFlags::Symbols,
+              tapi::internal::getArchType(std::get<0>(arch),
+                                          std::get<1>(arch)));
+          if (!file) {
+            errs() << "error: " << toString(file.takeError()) << "\n";
+            return 1;
+          }
+          continue;
+        }
+
         std::string errorMessage;
         auto file = std::unique_ptr<tapi::LinkerInterfaceFile>(
             tapi::LinkerInterfaceFile::create(
@@ -232,6 +466,32 @@ int main(int argc, const char *argv[]) {
     }
   }
 
+  if (!batchBuffers.empty()) {
+    std::vector<tapi::InputBuffer> inputs;
+    for (unsigned j = 0, e = batchBuffers.size(); j != e; ++j) {
+      auto buffer = batchBuffers[j]->getBuffer();
+      inputs.push_back({batchPaths[j],
+                        reinterpret_cast<const uint8_t *>(buffer.data()),
+                        buffer.size()});
+    }
+
+    for (auto &arch : archSet) {
+      for (unsigned j = 0; j < num; ++j) {
+        std::vector<std::string> errorMessages;
+        auto files = tapi::LinkerInterfaceFile::createBatch(
+            inputs, std::get<0>(arch), std::get<1>(arch),
+            tapi::ParsingFlags::None, packedVersion, errorMessages,
+            numThreads);
+        for (unsigned k = 0, e = files.size(); k != e; ++k) {
+          if (files[k] == nullptr) {
+            errs() << "error: " << errorMessages[k] << "\n";
+            return 1;
+          }
+        }
+      }
+    }
+  }
+
   auto time = TimeRecord::getCurrentTime(/*start=*/false);
   time -= start;
   file << "nts." << currentBenchmarkName << ".user "
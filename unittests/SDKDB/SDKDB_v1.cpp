@@ -622,6 +622,81 @@ TEST(SDKDB, ConflictMerge) {
   EXPECT_STREQ(error, buffer.c_str());
 }
 
+TEST(SDKDB, MergeOutlivesOther) {
+  Registry registry = setupRegistry();
+
+  auto db1 = make_unique<SDKDBFile>();
+  db1->setFileType(SDKDB_V1);
+  db1->setInstallName("/usr/lib/libtest.dylib");
+
+  auto db2 = make_unique<SDKDBFile>();
+  db2->setFileType(SDKDB_V1);
+  db2->setInstallName("/usr/lib/libtest.dylib");
+  db2->addGlobalSymbol("sym1", /*isPublic=*/true, AvailabilityInfo());
+  auto *cls = db2->addObjectiveCClass("Class1", "NSObject", /*isPublic=*/true,
+                                      AvailabilityInfo());
+  db2->addObjectiveCMethod(cls, "method1", /*isInstanceMethod=*/true,
+                           /*isPublic=*/true, AvailabilityInfo());
+  auto *cat = db2->addObjectiveCCategory("Category1", "Class2",
+                                         /*isPublic=*/true, AvailabilityInfo());
+  db2->addObjectiveCMethod(cat, "method2", /*isInstanceMethod=*/false,
+                           /*isPublic=*/true, AvailabilityInfo());
+  auto *proto =
+      db2->addObjectiveCProtocol("Protocol1", /*isPublic=*/true,
+                                 AvailabilityInfo());
+  db2->addObjectiveCMethod(proto, "method3", /*isInstanceMethod=*/true,
+                           /*isPublic=*/true, AvailabilityInfo());
+
+  // The merged entries don't reference the names owned by the other file.
+  db1->merge(std::move(*db2));
+  db2.reset();
+  EXPECT_FALSE(db1->takeError());
+
+  SmallString<1024> buffer;
+  raw_svector_ostream os(buffer);
+  auto err = registry.writeFile(os, db1.get());
+  EXPECT_FALSE(err);
+
+  const char *expected = "--- !tapi-sdkdb-v1\n"
+                         "install-name:    /usr/lib/libtest.dylib\n"
+                         "access:          public\n"
+                         "symbols:         \n"
+                         "  - name:            sym1\n"
+                         "    access:          public\n"
+                         "    availability:    0\n"
+                         "classes:         \n"
+                         "  - name:            Class1\n"
+                         "    super-class:     NSObject\n"
+                         "    access:          public\n"
+                         "    availability:    0\n"
+                         "    methods:         \n"
+                         "      - name:            method1\n"
+                         "        kind:            instance\n"
+                         "        access:          public\n"
+                         "        availability:    0\n"
+                         "categories:      \n"
+                         "  - name:            Category1\n"
+                         "    extends:         Class2\n"
+                         "    access:          public\n"
+                         "    availability:    0\n"
+                         "    methods:         \n"
+                         "      - name:            method2\n"
+                         "        kind:            class\n"
+                         "        access:          public\n"
+                         "        availability:    0\n"
+                         "protocols:       \n"
+                         "  - name:            Protocol1\n"
+                         "    access:          public\n"
+                         "    availability:    0\n"
+                         "    methods:         \n"
+                         "      - name:            method3\n"
+                         "        kind:            instance\n"
+                         "        access:          public\n"
+                         "        availability:    0\n"
+                         "...\n";
+  EXPECT_STREQ(expected, buffer.c_str());
+}
+
 TEST(SDKDB, VerifySuccess) {
   auto db1 = make_unique<SDKDBFile>();
   db1->setFileType(SDKDB_V1);
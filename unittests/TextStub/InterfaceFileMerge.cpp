@@ -0,0 +1,125 @@
+//===- unittests/TextStub/InterfaceFileMerge.cpp - Merge Test -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#include "tapi/Core/InterfaceFile.h"
+#include "llvm/Support/Error.h"
+#include "gtest/gtest.h"
+#define DEBUG_TYPE "interface-file-merge-test"
+
+using namespace llvm;
+using namespace tapi::internal;
+
+namespace {
+
+std::unique_ptr<InterfaceFile> createFile(Architecture arch) {
+  std::unique_ptr<InterfaceFile> file(new InterfaceFile);
+  file->setFileType(FileType::TBD_V2);
+  file->setPlatform(tapi::Platform::OSX);
+  file->setArch(arch);
+  file->setInstallName("/usr/lib/libfoo.dylib");
+  return file;
+}
+
+using FileRefs = std::vector<std::pair<std::string, ArchitectureSet>>;
+
+FileRefs getFileRefs(const std::vector<InterfaceFileRef> &refs) {
+  FileRefs result;
+  for (const auto &ref : refs)
+    result.emplace_back(ref.getInstallName(), ref.getArchitectures());
+  return result;
+}
+
+TEST(InterfaceFileMerge, MergeSorted) {
+  auto i386 = createFile(Architecture::i386);
+  i386->addAllowableClient("ClientA", Architecture::i386);
+  i386->addAllowableClient("ClientC", Architecture::i386);
+  i386->addReexportedLibrary("/usr/lib/libx.dylib", Architecture::i386);
+  i386->addUUID(Architecture::i386, "11111111-1111-1111-1111-111111111111");
+  i386->addSymbol(SymbolKind::GlobalSymbol, "_sym1", Architecture::i386);
+
+  auto x86_64 = createFile(Architecture::x86_64);
+  x86_64->addAllowableClient("ClientB", Architecture::x86_64);
+  x86_64->addAllowableClient("ClientC", Architecture::x86_64);
+  x86_64->addReexportedLibrary("/usr/lib/libx.dylib", Architecture::x86_64);
+  x86_64->addReexportedLibrary("/usr/lib/liby.dylib", Architecture::x86_64);
+  x86_64->addUUID(Architecture::x86_64,
+                  "22222222-2222-2222-2222-222222222222");
+  x86_64->addSymbol(SymbolKind::GlobalSymbol, "_sym1", Architecture::x86_64);
+  x86_64->addSymbol(SymbolKind::GlobalSymbol, "_sym2", Architecture::x86_64);
+
+  // The UUID for i386 duplicates the one from the first file. Like addUUID,
+  // the later one wins.
+  auto x86_64h = createFile(Architecture::x86_64h);
+  x86_64h->addAllowableClient("ClientA", Architecture::x86_64h);
+  x86_64h->addReexportedLibrary("/usr/lib/liby.dylib", Architecture::x86_64h);
+  x86_64h->addUUID(Architecture::i386, "44444444-4444-4444-4444-444444444444");
+  x86_64h->addUUID(Architecture::x86_64h,
+                   "33333333-3333-3333-3333-333333333333");
+  x86_64h->addSymbol(SymbolKind::GlobalSymbol, "_sym2", Architecture::x86_64h);
+
+  const InterfaceFile *files[] = {i386.get(), x86_64.get(), x86_64h.get()};
+  auto result = InterfaceFile::merge(files);
+  ASSERT_TRUE(!!result);
+  const auto &merged = *result.get();
+
+  ArchitectureSet all(Architecture::i386);
+  all.set(Architecture::x86_64);
+  all.set(Architecture::x86_64h);
+  EXPECT_EQ(all, merged.getArchitectures());
+
+  ArchitectureSet clientA(Architecture::i386);
+  clientA.set(Architecture::x86_64h);
+  ArchitectureSet clientC(Architecture::i386);
+  clientC.set(Architecture::x86_64);
+  FileRefs clients = {{"ClientA", clientA},
+                      {"ClientB", Architecture::x86_64},
+                      {"ClientC", clientC}};
+  EXPECT_EQ(clients, getFileRefs(merged.allowableClients()));
+
+  ArchitectureSet libx(Architecture::i386);
+  libx.set(Architecture::x86_64);
+  ArchitectureSet liby(Architecture::x86_64);
+  liby.set(Architecture::x86_64h);
+  FileRefs reexports = {{"/usr/lib/libx.dylib", libx},
+                        {"/usr/lib/liby.dylib", liby}};
+  EXPECT_EQ(reexports, getFileRefs(merged.reexportedLibraries()));
+
+  std::vector<std::pair<Architecture, std::string>> uuids = {
+      {Architecture::i386, "44444444-4444-4444-4444-444444444444"},
+      {Architecture::x86_64, "22222222-2222-2222-2222-222222222222"},
+      {Architecture::x86_64h, "33333333-3333-3333-3333-333333333333"}};
+  EXPECT_EQ(uuids, merged.uuids());
+
+  const Symbol *symbol;
+  ASSERT_TRUE(merged.contains(SymbolKind::GlobalSymbol, "_sym1", &symbol));
+  EXPECT_EQ(clientC, symbol->getArchitectures());
+  ASSERT_TRUE(merged.contains(SymbolKind::GlobalSymbol, "_sym2", &symbol));
+  EXPECT_EQ(liby, symbol->getArchitectures());
+  EXPECT_EQ(2, std::distance(merged.exports().begin(), merged.exports().end()));
+}
+
+TEST(InterfaceFileMerge, MergeErrorIndex) {
+  auto i386 = createFile(Architecture::i386);
+  auto x86_64 = createFile(Architecture::x86_64);
+  auto x86_64h = createFile(Architecture::x86_64h);
+  x86_64h->setInstallName("/usr/lib/libbar.dylib");
+
+  const InterfaceFile *files[] = {i386.get(), x86_64.get(), x86_64h.get()};
+  auto result = InterfaceFile::merge(files);
+  ASSERT_FALSE(!!result);
+  size_t index = 0;
+  std::string message;
+  handleAllErrors(result.takeError(), [&](const MergeError &error) {
+    index = error.getIndex();
+    message = error.getMessage();
+  });
+  EXPECT_EQ(2U, index);
+  EXPECT_EQ("install names do not match", message);
+}
+
+} // end anonymous namespace.
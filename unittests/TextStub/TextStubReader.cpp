@@ -0,0 +1,586 @@
+//===- unittests/TextStub/TextStubReader.cpp - Text Stub Reader Test ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#include "tapi/Core/InterfaceFile.h"
+#include "tapi/Core/Registry.h"
+#include "tapi/Core/TextStubReader.h"
+#include "tapi/Core/TextStub_v1.h"
+#include "tapi/Core/TextStub_v2.h"
+#include "tapi/Core/TextStub_v3.h"
+#include "tapi/Core/YAMLReaderWriter.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "gtest/gtest.h"
+#define DEBUG_TYPE "text-stub-reader-test"
+
+using namespace llvm;
+using namespace tapi::internal;
+
+namespace {
+
+/// A reader that claims every file but refuses to read it. Used to verify
+/// that the text stub reader doesn't fall back to the generic YAML reader.
+class NoFallbackReader final : public Reader {
+public:
+  bool canRead(file_magic, MemoryBufferRef, FileType) const override {
+    return true;
+  }
+  Expected<FileType> getFileType(file_magic, MemoryBufferRef) const override {
+    return FileType::Invalid;
+  }
+  Expected<std::unique_ptr<File>> readFile(std::unique_ptr<MemoryBuffer>,
+                                           ReadFlags,
+                                           ArchitectureSet) const override {
+    return make_error<StringError>("unexpected fallback",
+                                   inconvertibleErrorCode());
+  }
+};
+
+std::unique_ptr<InterfaceFile> readInterface(const Registry &registry,
+                                             StringRef buffer) {
+  auto file =
+      registry.readFile(MemoryBuffer::getMemBuffer(buffer, "Test.tbd"));
+  if (!file) {
+    ADD_FAILURE() << toString(file.takeError());
+    return nullptr;
+  }
+  return std::unique_ptr<InterfaceFile>(
+      cast<InterfaceFile>(file.get().release()));
+}
+
+std::unique_ptr<InterfaceFile>
+readWithoutFallback(StringRef buffer,
+                    ArchitectureSet arches = ArchitectureSet::All()) {
+  NoFallbackReader noFallback;
+  TextStubReader reader(noFallback);
+  auto file = reader.readFile(MemoryBuffer::getMemBuffer(buffer, "Test.tbd"),
+                              ReadFlags::All, arches);
+  if (!file) {
+    ADD_FAILURE() << toString(file.takeError());
+    return nullptr;
+  }
+  return std::unique_ptr<InterfaceFile>(
+      cast<InterfaceFile>(file.get().release()));
+}
+
+void expectEqualSymbols(InterfaceFile::const_symbol_range lhs,
+                        InterfaceFile::const_symbol_range rhs) {
+  ASSERT_EQ(std::distance(lhs.begin(), lhs.end()),
+            std::distance(rhs.begin(), rhs.end()));
+  for (auto it = lhs.begin(), it2 = rhs.begin(); it != lhs.end(); ++it, ++it2) {
+    EXPECT_EQ((*it)->getKind(), (*it2)->getKind());
+    EXPECT_EQ((*it)->getName(), (*it2)->getName());
+    EXPECT_EQ((*it)->getArchitectures(), (*it2)->getArchitectures());
+    EXPECT_EQ((*it)->getFlags(), (*it2)->getFlags());
+  }
+}
+
+void expectEqualRefs(const std::vector<InterfaceFileRef> &lhs,
+                     const std::vector<InterfaceFileRef> &rhs) {
+  ASSERT_EQ(lhs.size(), rhs.size());
+  for (size_t i = 0, e = lhs.size(); i != e; ++i) {
+    EXPECT_EQ(lhs[i].getInstallName(), rhs[i].getInstallName());
+    EXPECT_EQ(lhs[i].getArchitectures(), rhs[i].getArchitectures());
+  }
+}
+
+void expectEqual(const InterfaceFile *lhs, const InterfaceFile *rhs) {
+  ASSERT_NE(nullptr, lhs);
+  ASSERT_NE(nullptr, rhs);
+  EXPECT_EQ(lhs->getPath(), rhs->getPath());
+  EXPECT_EQ(lhs->getFileType(), rhs->getFileType());
+  EXPECT_EQ(lhs->getArchitectures(), rhs->getArchitectures());
+  EXPECT_EQ(lhs->uuids(), rhs->uuids());
+  EXPECT_EQ(lhs->getPlatform(), rhs->getPlatform());
+  EXPECT_EQ(lhs->getInstallName(), rhs->getInstallName());
+  EXPECT_EQ(lhs->getCurrentVersion(), rhs->getCurrentVersion());
+  EXPECT_EQ(lhs->getCompatibilityVersion(), rhs->getCompatibilityVersion());
+  EXPECT_EQ(lhs->getSwiftABIVersion(), rhs->getSwiftABIVersion());
+  EXPECT_EQ(lhs->getObjCConstraint(), rhs->getObjCConstraint());
+  EXPECT_EQ(lhs->isTwoLevelNamespace(), rhs->isTwoLevelNamespace());
+  EXPECT_EQ(lhs->isApplicationExtensionSafe(),
+            rhs->isApplicationExtensionSafe());
+  EXPECT_EQ(lhs->isInstallAPI(), rhs->isInstallAPI());
+  EXPECT_EQ(lhs->getParentUmbrella(), rhs->getParentUmbrella());
+  expectEqualRefs(lhs->allowableClients(), rhs->allowableClients());
+  expectEqualRefs(lhs->reexportedLibraries(), rhs->reexportedLibraries());
+  expectEqualSymbols(lhs->exports(), rhs->exports());
+  expectEqualSymbols(lhs->undefineds(), rhs->undefineds());
+}
+
+/// Read the buffer with the text stub reader (without fallback) and the
+/// generic YAML reader and compare the results.
+void expectSameAsYAMLReader(StringRef buffer) {
+  // The default registry doesn't read TBD v3 files, so set up all text stub
+  // document handlers explicitly.
+  std::unique_ptr<YAMLReader> reader(new YAMLReader);
+  reader->add(
+      std::unique_ptr<DocumentHandler>(new stub::v1::YAMLDocumentHandler));
+  reader->add(
+      std::unique_ptr<DocumentHandler>(new stub::v2::YAMLDocumentHandler));
+  reader->add(
+      std::unique_ptr<DocumentHandler>(new stub::v3::YAMLDocumentHandler));
+  Registry yamlRegistry;
+  yamlRegistry.add(std::unique_ptr<Reader>(std::move(reader)));
+
+  auto expected = readInterface(yamlRegistry, buffer);
+  auto file = readWithoutFallback(buffer);
+  expectEqual(file.get(), expected.get());
+}
+
+static const char tbd_v1_file[] =
+    "---\n"
+    "archs: [ armv7, armv7s, arm64 ]\n"
+    "platform: ios\n"
+    "install-name: /usr/lib/libfoo.dylib\n"
+    "current-version: 2.3.4\n"
+    "compatibility-version: 1.0\n"
+    "swift-version: 1.1\n"
+    "objc-constraint: retain_release\n"
+    "exports:\n"
+    "  - archs: [ armv7, armv7s, arm64 ]\n"
+    "    allowed-clients: [ clientA ]\n"
+    "    re-exports: [ /usr/lib/libbar.dylib ]\n"
+    "    symbols: [ _sym1, _sym2, _OBJC_EHTYPE_$_Class1 ]\n"
+    "    objc-classes: [ _Class1, _Class2 ]\n"
+    "    objc-ivars: [ _Class1._ivar1 ]\n"
+    "    weak-def-symbols: [ _weak1 ]\n"
+    "    thread-local-symbols: [ _tlv1 ]\n"
+    "  - archs: [ arm64 ]\n"
+    "    symbols: [ _sym3 ]\n"
+    "...\n";
+
+static const char tbd_v2_file[] =
+    "--- !tapi-tbd-v2\n"
+    "archs:           [ i386, x86_64 ]\n"
+    "uuids:           [ 'i386: 00000000-0000-0000-0000-000000000000', \n"
+    "                   'x86_64: 11111111-1111-1111-1111-111111111111' ]\n"
+    "platform:        macosx\n"
+    "flags:           [ flat_namespace, not_app_extension_safe ]\n"
+    "install-name:    '/System/Library/Frameworks/Foo.framework/Foo'\n"
+    "current-version: 1.2\n"
+    "swift-version:   5\n"
+    "objc-constraint: none\n"
+    "parent-umbrella: Bar\n"
+    "exports:         \n"
+    "  - archs:           [ i386, x86_64 ]\n"
+    "    symbols:         [ '$ld$hide$os10.4$_sym1', _sym1, \"_sym2\", \n"
+    "                       _sym3 ]\n"
+    "    objc-classes:    [ _Class1 ]\n"
+    "  - archs:           [ x86_64 ]\n"
+    "    objc-ivars:      [ _Class1._ivar1 ]\n"
+    "undefineds:      \n"
+    "  - archs:           [ i386, x86_64 ]\n"
+    "    symbols:         [ _OBJC_EHTYPE_$_Class2, _undef ]\n"
+    "    objc-classes:    [ _Class3 ]\n"
+    "    weak-ref-symbols: [ _weakref ]\n"
+    "...\n";
+
+static const char tbd_v3_file[] =
+    "--- !tapi-tbd-v3\n"
+    "archs:           [ x86_64, x86_64h ]\n"
+    "platform:        macosx\n"
+    "flags:           [ installapi ]\n"
+    "install-name:    /usr/lib/libfoo.dylib\n"
+    "swift-abi-version: 0x5\n"
+    "exports:\n"
+    "  - archs:           [ x86_64, x86_64h ]\n"
+    "    allowable-clients: [ clientA, clientB ]\n"
+    "    symbols:         [ _sym1 ]\n"
+    "    objc-classes:    [ Class1 ]\n"
+    "    objc-eh-types:   [ Class1 ]\n"
+    "    objc-ivars:      [ Class1.ivar1 ]\n"
+    "undefineds:\n"
+    "  - archs:           [ x86_64 ]\n"
+    "    objc-classes:    [ Class2 ]\n"
+    "    objc-eh-types:   [ Class2 ]\n"
+    "...\n";
+
+TEST(TextStubReader, TBD_v1) { expectSameAsYAMLReader(tbd_v1_file); }
+
+TEST(TextStubReader, TBD_v2) { expectSameAsYAMLReader(tbd_v2_file); }
+
+TEST(TextStubReader, TBD_v3) { expectSameAsYAMLReader(tbd_v3_file); }
+
+TEST(TextStubReader, DefaultRegistryRejectsTBD_v3) {
+  Registry registry;
+  registry.addYAMLReaders();
+  EXPECT_TRUE(registry.canRead(MemoryBufferRef(tbd_v2_file, "Test.tbd")));
+  EXPECT_FALSE(registry.canRead(MemoryBufferRef(tbd_v3_file, "Test.tbd")));
+}
+
+void expectMatchingColumns(InterfaceFile::const_symbol_range symbols,
+                           const SymbolColumns &columns) {
+  ASSERT_EQ(size_t(std::distance(symbols.begin(), symbols.end())),
+            columns.size());
+  for (size_t i = 0, e = columns.size(); i != e; ++i) {
+    const auto *symbol = symbols.begin()[i];
+    EXPECT_EQ(symbol->getKind(), columns.getKind(i));
+    EXPECT_EQ(symbol->getArchitectures(), columns.getArchitectures(i));
+    EXPECT_EQ(symbol->getFlags(), columns.getFlags(i));
+  }
+}
+
+void expectFilteredSymbols(InterfaceFile::const_symbol_range symbols,
+                           InterfaceFile::const_filtered_symbol_range filtered,
+                           ArchitectureSet archs,
+                           Optional<SymbolKind> kind = None) {
+  std::vector<const Symbol *> expected;
+  for (const auto *symbol : symbols)
+    if (!(symbol->getArchitectures() & archs).empty() &&
+        (!kind || symbol->getKind() == *kind))
+      expected.push_back(symbol);
+
+  std::vector<const Symbol *> actual;
+  for (auto it = filtered.begin(), e = filtered.end(); it != e; ++it) {
+    EXPECT_EQ(symbols.begin()[it.getIndex()], *it);
+    EXPECT_EQ(it->getKind(), it.getKind());
+    EXPECT_EQ(it->getArchitectures(), it.getArchitectures());
+    EXPECT_EQ(it->getFlags(), it.getFlags());
+    actual.push_back(*it);
+  }
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(TextStubReader, FilteredSymbols) {
+  for (const char *buffer : {tbd_v1_file, tbd_v2_file, tbd_v3_file}) {
+    auto file = readWithoutFallback(buffer);
+    ASSERT_NE(nullptr, file);
+    expectMatchingColumns(file->exports(), file->exportColumns());
+    expectMatchingColumns(file->undefineds(), file->undefinedColumns());
+
+    for (auto arch : file->getArchitectures()) {
+      expectFilteredSymbols(file->exports(), file->exports(arch), arch);
+      expectFilteredSymbols(file->undefineds(), file->undefineds(arch), arch);
+      expectFilteredSymbols(file->exports(),
+                            file->exports(arch, SymbolKind::ObjectiveCClass),
+                            arch, SymbolKind::ObjectiveCClass);
+
+      auto extracted = file->extract(arch);
+      ASSERT_TRUE(!!extracted);
+      auto &interface = *extracted.get();
+      expectMatchingColumns(interface.exports(), interface.exportColumns());
+      auto exports = file->exports(arch);
+      EXPECT_EQ(std::distance(exports.begin(), exports.end()),
+                std::distance(interface.exports().begin(),
+                              interface.exports().end()));
+    }
+
+    auto all = file->getArchitectures();
+    expectFilteredSymbols(file->exports(), file->exports(all), all);
+    auto none = file->exports(ArchitectureSet());
+    EXPECT_EQ(none.begin(), none.end());
+  }
+}
+
+std::string writeToString(const Writer &writer, const File *file) {
+  std::string buffer;
+  raw_string_ostream os(buffer);
+  auto error = writer.writeFile(os, file);
+  EXPECT_FALSE(error);
+  consumeError(std::move(error));
+  return os.str();
+}
+
+TEST(TextStubReader, ArchitectureView) {
+  YAMLWriter writer;
+  writer.add(
+      std::unique_ptr<DocumentHandler>(new stub::v1::YAMLDocumentHandler));
+  writer.add(
+      std::unique_ptr<DocumentHandler>(new stub::v2::YAMLDocumentHandler));
+  writer.add(
+      std::unique_ptr<DocumentHandler>(new stub::v3::YAMLDocumentHandler));
+
+  for (const char *buffer : {tbd_v1_file, tbd_v2_file, tbd_v3_file}) {
+    auto file = readWithoutFallback(buffer);
+    ASSERT_NE(nullptr, file);
+
+    for (auto arch : file->getArchitectures()) {
+      auto view = file->getView(arch);
+      ASSERT_TRUE(!!view);
+      EXPECT_EQ(ArchitectureSet(arch), view->getArchitectures());
+      auto exports = file->exports(arch);
+      EXPECT_EQ(std::distance(exports.begin(), exports.end()),
+                std::distance(view->exports().begin(), view->exports().end()));
+
+      // Writing the view must produce the same file as writing the
+      // materialized slice.
+      auto extracted = view->materialize();
+      EXPECT_EQ(ArchitectureSet(arch), extracted->getArchitectures());
+      ASSERT_TRUE(writer.canWrite(&view.get()));
+      auto written = writeToString(writer, &view.get());
+      EXPECT_NE(std::string::npos, written.find("install-name:"));
+      EXPECT_EQ(writeToString(writer, extracted.get()), written);
+    }
+  }
+
+  auto file = readWithoutFallback(tbd_v3_file);
+  ASSERT_NE(nullptr, file);
+  auto missing = file->getView(Architecture::armv7);
+  ASSERT_FALSE(!!missing);
+  EXPECT_EQ("file doesn't have architecture 'armv7'",
+            toString(missing.takeError()));
+}
+
+TEST(TextStubReader, EscapedQuotes) {
+  static const char tbd_file[] = "--- !tapi-tbd-v3\n"
+                                 "archs: [ x86_64 ]\n"
+                                 "platform: macosx\n"
+                                 "install-name: 'Test''s.dylib'\n"
+                                 "exports:\n"
+                                 "  - archs: [ x86_64 ]\n"
+                                 "    symbols: [ '_it''s', '''' ]\n"
+                                 "...\n";
+
+  auto file = readWithoutFallback(tbd_file);
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ("Test's.dylib", file->getInstallName());
+  ASSERT_EQ(2U, file->exports().end() - file->exports().begin());
+  EXPECT_EQ("_it's", (*file->exports().begin())->getName());
+  EXPECT_EQ("'", (*std::next(file->exports().begin()))->getName());
+}
+
+TEST(TextStubReader, InputFiles) {
+  std::error_code ec;
+  for (sys::fs::recursive_directory_iterator i(INPUT_PATH "/..", ec), ie;
+       i != ie && !ec; i.increment(ec)) {
+    if (sys::path::extension(i->path()) != ".tbd")
+      continue;
+
+    auto bufferOrErr = MemoryBuffer::getFile(i->path());
+    ASSERT_TRUE(bufferOrErr);
+    SCOPED_TRACE(i->path());
+    expectSameAsYAMLReader(bufferOrErr.get()->getBuffer());
+  }
+  EXPECT_FALSE(ec);
+}
+
+TEST(TextStubReader, Fallback) {
+  static const char tbd_file[] = "--- !tapi-tbd-v2\n"
+                                 "archs: [ x86_64 ]\n"
+                                 "platform: macosx\n"
+                                 "install-name: \"/usr/lib/lib\\x66oo.dylib\"\n"
+                                 "exports:\n"
+                                 "  - archs: [ x86_64 ]\n"
+                                 "    symbols:\n"
+                                 "      - _sym1 # block sequence\n"
+                                 "...\n";
+
+  Registry registry;
+  registry.addYAMLReaders();
+  auto file = readInterface(registry, tbd_file);
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ("/usr/lib/libfoo.dylib", file->getInstallName());
+  ASSERT_EQ(1U, file->exports().end() - file->exports().begin());
+  EXPECT_EQ("_sym1", (*file->exports().begin())->getName());
+}
+
+TEST(TextStubReader, MalformedFile) {
+  static const char tbd_file[] = "--- !tapi-tbd-v2\n"
+                                 "archs: [ x86_64 ]\n"
+                                 "platform: macosx\n"
+                                 "install-name: Test.dylib\n"
+                                 "swift-version: 256\n"
+                                 "...\n";
+
+  Registry yamlRegistry;
+  yamlRegistry.addYAMLReaders(/*useTextStubReader=*/false);
+  auto expected =
+      yamlRegistry.readFile(MemoryBuffer::getMemBuffer(tbd_file, "Test.tbd"));
+  ASSERT_FALSE(expected);
+
+  Registry registry;
+  registry.addYAMLReaders();
+  auto file =
+      registry.readFile(MemoryBuffer::getMemBuffer(tbd_file, "Test.tbd"));
+  ASSERT_FALSE(file);
+  EXPECT_EQ(toString(expected.takeError()), toString(file.takeError()));
+}
+
+TEST(TextStubReader, ArchitectureFilter) {
+  ArchitectureSet arches(Architecture::x86_64);
+  Registry yamlRegistry;
+  yamlRegistry.addYAMLReaders(/*useTextStubReader=*/false);
+  auto expected = yamlRegistry.readFile(
+      MemoryBuffer::getMemBuffer(tbd_v2_file, "Test.tbd"), ReadFlags::All,
+      arches);
+  ASSERT_TRUE(!!expected);
+
+  auto file = readWithoutFallback(tbd_v2_file, arches);
+  expectEqual(file.get(), cast<InterfaceFile>(expected.get().get()));
+
+  // The header is not affected by the filter.
+  EXPECT_EQ(ArchitectureSet(Architecture::i386) | arches,
+            file->getArchitectures());
+
+  static const char tbd_file[] = "--- !tapi-tbd-v3\n"
+                                 "archs: [ i386, x86_64 ]\n"
+                                 "platform: macosx\n"
+                                 "install-name: Test.dylib\n"
+                                 "exports:\n"
+                                 "  - archs: [ i386 ]\n"
+                                 "    allowable-clients: [ clientA ]\n"
+                                 "    symbols: [ _sym1, '_sym''2', \"_sym3\" ]\n"
+                                 "  - archs: [ x86_64 ]\n"
+                                 "    symbols: [ _sym4 ]\n"
+                                 "undefineds:\n"
+                                 "  - archs: [ i386 ]\n"
+                                 "    symbols: [ _undef ]\n"
+                                 "...\n";
+
+  file = readWithoutFallback(tbd_file, arches);
+  ASSERT_NE(nullptr, file);
+  EXPECT_TRUE(file->allowableClients().empty());
+  ASSERT_EQ(1U, file->exports().end() - file->exports().begin());
+  EXPECT_EQ("_sym4", (*file->exports().begin())->getName());
+  EXPECT_EQ(file->undefineds().begin(), file->undefineds().end());
+}
+
+TEST(TextStubReader, SkipSymbols) {
+  NoFallbackReader noFallback;
+  TextStubReader reader(noFallback);
+  auto file = reader.readFile(
+      MemoryBuffer::getMemBuffer(tbd_v2_file, "Test.tbd"), ReadFlags::Header,
+      ArchitectureSet::All());
+  ASSERT_TRUE(!!file);
+  auto *interface = cast<InterfaceFile>(file.get().get());
+  EXPECT_EQ("/System/Library/Frameworks/Foo.framework/Foo",
+            interface->getInstallName());
+  EXPECT_EQ(interface->exports().begin(), interface->exports().end());
+  EXPECT_EQ(interface->undefineds().begin(), interface->undefineds().end());
+}
+
+TEST(TextStubReader, HeaderOnly) {
+  static const char tbd_file[] = "--- !tapi-tbd-v3\n"
+                                 "archs: [ x86_64 ]\n"
+                                 "uuids: [ 'x86_64: "
+                                 "00000000-0000-0000-0000-000000000000' ]\n"
+                                 "platform: macosx\n"
+                                 "flags: [ installapi ]\n"
+                                 "install-name: Test.dylib\n"
+                                 "exports:\n"
+                                 "  - archs: [ x86_64 ]\n"
+                                 "    symbols: [ _sym1, _sym2 ]\n"
+                                 "...\n";
+
+  NoFallbackReader noFallback;
+  TextStubReader reader(noFallback);
+  auto file = reader.readFile(MemoryBuffer::getMemBuffer(tbd_file, "Test.tbd"),
+                              ReadFlags::Header, ArchitectureSet::All());
+  ASSERT_TRUE(!!file);
+  auto *interface = cast<InterfaceFile>(file.get().get());
+  EXPECT_EQ("Test.dylib", interface->getInstallName());
+  EXPECT_TRUE(interface->isInstallAPI());
+  ASSERT_EQ(1U, interface->uuids().size());
+  EXPECT_EQ(Architecture::x86_64, interface->uuids().front().first);
+  EXPECT_EQ(interface->exports().begin(), interface->exports().end());
+}
+
+TEST(TextStubReader, HeaderOnly_NonCanonicalSections) {
+  // The sections are not in the canonical form, so even reading only the
+  // header has to use the fallback reader.
+  static const char tbd_file[] = "--- !tapi-tbd-v2\n"
+                                 "archs: [ x86_64 ]\n"
+                                 "platform: macosx\n"
+                                 "install-name: Test.dylib\n"
+                                 "exports:\n"
+                                 "  - archs: [ x86_64 ]\n"
+                                 "    symbols:\n"
+                                 "      - _sym1\n"
+                                 "...\n";
+
+  NoFallbackReader noFallback;
+  TextStubReader reader(noFallback);
+  auto file = reader.readFile(MemoryBuffer::getMemBuffer(tbd_file, "Test.tbd"),
+                              ReadFlags::Header, ArchitectureSet::All());
+  ASSERT_FALSE(file);
+  consumeError(file.takeError());
+}
+
+TEST(TextStubReader, HeaderOnly_MalformedSections) {
+  static const char tbd_file[] = "--- !tapi-tbd-v2\n"
+                                 "archs: [ x86_64 ]\n"
+                                 "platform: macosx\n"
+                                 "install-name: Test.dylib\n"
+                                 "exports:\n"
+                                 "  - archs: [ x86_64 ]\n"
+                                 "    symbols: [ _sym1\n"
+                                 "...\n";
+
+  Registry registry;
+  registry.addYAMLReaders();
+  auto file =
+      registry.readFile(MemoryBuffer::getMemBuffer(tbd_file, "Test.tbd"),
+                        ReadFlags::Header);
+  ASSERT_FALSE(file);
+  consumeError(file.takeError());
+}
+
+TEST(TextStubReader, HeaderKeyAfterSections) {
+  static const char tbd_file[] = "--- !tapi-tbd-v2\n"
+                                 "archs: [ x86_64 ]\n"
+                                 "platform: macosx\n"
+                                 "exports:\n"
+                                 "  - archs: [ x86_64 ]\n"
+                                 "    symbols: [ _sym1 ]\n"
+                                 "install-name: Test.dylib\n"
+                                 "...\n";
+
+  NoFallbackReader noFallback;
+  TextStubReader reader(noFallback);
+  auto file = reader.readFile(MemoryBuffer::getMemBuffer(tbd_file, "Test.tbd"),
+                              ReadFlags::Header, ArchitectureSet::All());
+  ASSERT_FALSE(file);
+  consumeError(file.takeError());
+
+  Registry registry;
+  registry.addYAMLReaders();
+  auto interface = readInterface(registry, tbd_file);
+  ASSERT_NE(nullptr, interface);
+  EXPECT_EQ("Test.dylib", interface->getInstallName());
+  ASSERT_EQ(1U, interface->exports().end() - interface->exports().begin());
+}
+
+TEST(TextStubReader, HeaderOnly_FlagsAndUUIDsAfterSections) {
+  static const char tbd_file[] = "--- !tapi-tbd-v2\n"
+                                 "archs: [ x86_64 ]\n"
+                                 "platform: macosx\n"
+                                 "install-name: Test.dylib\n"
+                                 "exports:\n"
+                                 "  - archs: [ x86_64 ]\n"
+                                 "    symbols: [ _sym1 ]\n"
+                                 "flags: [ installapi ]\n"
+                                 "uuids: [ 'x86_64: "
+                                 "00000000-0000-0000-0000-000000000000' ]\n"
+                                 "...\n";
+
+  NoFallbackReader noFallback;
+  TextStubReader reader(noFallback);
+  auto noFile =
+      reader.readFile(MemoryBuffer::getMemBuffer(tbd_file, "Test.tbd"),
+                      ReadFlags::Header, ArchitectureSet::All());
+  ASSERT_FALSE(noFile);
+  consumeError(noFile.takeError());
+
+  Registry registry;
+  registry.addYAMLReaders();
+  auto file =
+      registry.readFile(MemoryBuffer::getMemBuffer(tbd_file, "Test.tbd"),
+                        ReadFlags::Header);
+  ASSERT_TRUE(!!file);
+  auto *interface = cast<InterfaceFile>(file.get().get());
+  EXPECT_EQ("Test.dylib", interface->getInstallName());
+  EXPECT_TRUE(interface->isInstallAPI());
+  ASSERT_EQ(1U, interface->uuids().size());
+  EXPECT_EQ(Architecture::x86_64, interface->uuids().front().first);
+}
+
+} // end anonymous namespace.
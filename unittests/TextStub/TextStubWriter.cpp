@@ -0,0 +1,268 @@
+//===- unittests/TextStub/TextStubWriter.cpp - Text Stub Writer Test ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#include "tapi/Core/ExtendedInterfaceFile.h"
+#include "tapi/Core/InterfaceFile.h"
+#include "tapi/Core/Registry.h"
+#include "tapi/Core/TextAPI_v1.h"
+#include "tapi/Core/TextStubWriter.h"
+#include "tapi/Core/TextStub_v1.h"
+#include "tapi/Core/TextStub_v2.h"
+#include "tapi/Core/TextStub_v3.h"
+#include "tapi/Core/YAMLReaderWriter.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#define DEBUG_TYPE "text-stub-writer-test"
+
+using namespace llvm;
+using namespace tapi::internal;
+
+namespace {
+
+/// A document handler that only supports the generic YAML writer. Used to
+/// verify that the text stub writer falls back to it.
+class GenericOnlyHandler final : public DocumentHandler {
+public:
+  bool canRead(MemoryBufferRef, FileType) const override { return false; }
+  FileType getFileType(MemoryBufferRef) const override {
+    return FileType::Invalid;
+  }
+  bool canWrite(const File *file) const override {
+    return _handler->canWrite(file);
+  }
+  bool handleDocument(yaml::IO &io, const File *&file) const override {
+    return _handler->handleDocument(io, file);
+  }
+
+private:
+  std::unique_ptr<DocumentHandler> _handler{
+      new stub::v2::YAMLDocumentHandler};
+};
+
+YAMLWriter &getYAMLWriter() {
+  static YAMLWriter writer;
+  static bool initialized = false;
+  if (!initialized) {
+    writer.add(std::unique_ptr<DocumentHandler>(
+        new stub::v1::YAMLDocumentHandler));
+    writer.add(std::unique_ptr<DocumentHandler>(
+        new stub::v2::YAMLDocumentHandler));
+    writer.add(std::unique_ptr<DocumentHandler>(
+        new stub::v3::YAMLDocumentHandler));
+    writer.add(std::unique_ptr<DocumentHandler>(
+        new api::v1::YAMLDocumentHandler));
+    initialized = true;
+  }
+  return writer;
+}
+
+std::string writeWith(const Writer &writer, const File *file) {
+  std::string buffer;
+  raw_string_ostream os(buffer);
+  if (auto error = writer.writeFile(os, file))
+    ADD_FAILURE() << toString(std::move(error));
+  return os.str();
+}
+
+/// Write the file with the text stub writer and the generic YAML writer and
+/// compare the results.
+void expectSameAsYAMLWriter(const File *file) {
+  const auto &yamlWriter = getYAMLWriter();
+  TextStubWriter writer(yamlWriter);
+  ASSERT_TRUE(writer.canWrite(file));
+  EXPECT_EQ(writeWith(yamlWriter, file), writeWith(writer, file));
+}
+
+std::unique_ptr<InterfaceFile> readInterface(StringRef buffer) {
+  Registry registry;
+  registry.addYAMLReaders();
+  auto file =
+      registry.readFile(MemoryBuffer::getMemBuffer(buffer, "Test.tbd"));
+  if (!file) {
+    ADD_FAILURE() << toString(file.takeError());
+    return nullptr;
+  }
+  return std::unique_ptr<InterfaceFile>(
+      cast<InterfaceFile>(file.get().release()));
+}
+
+static const char tbd_v2_file[] =
+    "--- !tapi-tbd-v2\n"
+    "archs:           [ i386, x86_64 ]\n"
+    "uuids:           [ 'i386: 00000000-0000-0000-0000-000000000000', \n"
+    "                   'x86_64: 11111111-1111-1111-1111-111111111111' ]\n"
+    "platform:        macosx\n"
+    "flags:           [ flat_namespace, not_app_extension_safe ]\n"
+    "install-name:    '/System/Library/Frameworks/Foo.framework/Foo'\n"
+    "current-version: 1.2\n"
+    "swift-version:   5\n"
+    "objc-constraint: none\n"
+    "parent-umbrella: Bar\n"
+    "exports:         \n"
+    "  - archs:           [ i386, x86_64 ]\n"
+    "    allowable-clients: [ clientA ]\n"
+    "    re-exports:      [ /usr/lib/libbar.dylib ]\n"
+    "    symbols:         [ '$ld$hide$os10.4$_sym1', _sym1, _sym2, _sym3, \n"
+    "                       _a_rather_long_symbol_name_to_force_a_wrap, \n"
+    "                       _another_rather_long_symbol_name, '_quote''d', \n"
+    "                       _OBJC_EHTYPE_$_Class1 ]\n"
+    "    objc-classes:    [ _Class1, _Class2 ]\n"
+    "    weak-def-symbols: [ _weak1 ]\n"
+    "    thread-local-symbols: [ _tlv1 ]\n"
+    "  - archs:           [ x86_64 ]\n"
+    "    objc-ivars:      [ _Class1._ivar1 ]\n"
+    "undefineds:      \n"
+    "  - archs:           [ i386, x86_64 ]\n"
+    "    symbols:         [ _OBJC_EHTYPE_$_Class2, _undef ]\n"
+    "    objc-classes:    [ _Class3 ]\n"
+    "    objc-ivars:      [ _Class3._ivar1 ]\n"
+    "    weak-ref-symbols: [ _weakref ]\n"
+    "...\n";
+
+TEST(TextStubWriter, TBD_v1) {
+  auto file = readInterface(tbd_v2_file);
+  ASSERT_NE(nullptr, file);
+  file->setFileType(FileType::TBD_V1);
+  expectSameAsYAMLWriter(file.get());
+}
+
+TEST(TextStubWriter, TBD_v2) {
+  auto file = readInterface(tbd_v2_file);
+  ASSERT_NE(nullptr, file);
+  expectSameAsYAMLWriter(file.get());
+}
+
+TEST(TextStubWriter, TBD_v3) {
+  auto file = readInterface(tbd_v2_file);
+  ASSERT_NE(nullptr, file);
+  file->setFileType(FileType::TBD_V3);
+  file->setSwiftABIVersion(0);
+  file->setObjCConstraint(tapi::ObjCConstraint::Retain_Release);
+  expectSameAsYAMLWriter(file.get());
+}
+
+TEST(TextStubWriter, TBD_v2_View) {
+  auto file = readInterface(tbd_v2_file);
+  ASSERT_NE(nullptr, file);
+  InterfaceFileView view(*file, Architecture::x86_64);
+  expectSameAsYAMLWriter(&view);
+}
+
+TEST(TextStubWriter, TBD_v2_Defaults) {
+  InterfaceFile file;
+  file.setFileType(FileType::TBD_V2);
+  file.setArchitectures(Architecture::arm64);
+  file.setPlatform(tapi::Platform::iOS);
+  file.setInstallName("");
+  expectSameAsYAMLWriter(&file);
+}
+
+TEST(TextStubWriter, TBD_v2_PrefixedNames) {
+  InterfaceFile file;
+  file.setFileType(FileType::TBD_V2);
+  file.setArch(Architecture::x86_64);
+  file.setPlatform(tapi::Platform::OSX);
+  file.setInstallName("/usr/lib/libfoo.dylib");
+  // Ordered by the name alone, "A" would come before "_B".
+  file.addSymbol(SymbolKind::ObjectiveCClassEHType, "A", Architecture::x86_64);
+  file.addSymbol(SymbolKind::GlobalSymbol, "_B", Architecture::x86_64);
+  // The first class name needs quoting with and without the prefix, the
+  // second one only without it.
+  file.addSymbol(SymbolKind::ObjectiveCClass, "Class'1", Architecture::x86_64);
+  file.addSymbol(SymbolKind::ObjectiveCClass, "null", Architecture::x86_64);
+  expectSameAsYAMLWriter(&file);
+
+  TextStubWriter writer(getYAMLWriter());
+  EXPECT_EQ("--- !tapi-tbd-v2\n"
+            "archs:           [ x86_64 ]\n"
+            "platform:        macosx\n"
+            "flags:           [ flat_namespace, not_app_extension_safe ]\n"
+            "install-name:    /usr/lib/libfoo.dylib\n"
+            "current-version: 0\n"
+            "compatibility-version: 0\n"
+            "objc-constraint: none\n"
+            "exports:         \n"
+            "  - archs:           [ x86_64 ]\n"
+            "    symbols:         [ _B, '_OBJC_EHTYPE_$_A' ]\n"
+            "    objc-classes:    [ '_Class''1', _null ]\n"
+            "...\n",
+            writeWith(writer, &file));
+}
+
+TEST(TextStubWriter, API_v1) {
+  ExtendedInterfaceFile file;
+  file.setFileType(FileType::API_V1);
+  ArchitectureSet archs;
+  archs.set(Architecture::i386);
+  archs.set(Architecture::x86_64);
+  file.setArchitectures(archs);
+  file.setInstallName("/System/Library/Frameworks/Foo.framework/Foo");
+  file.setCurrentVersion(PackedVersion(1, 2, 3));
+  file.addSymbol(XPIKind::GlobalSymbol, "_public", archs, SymbolFlags::None,
+                 XPIAccess::Public);
+  file.addSymbol(XPIKind::GlobalSymbol, "_weak", archs,
+                 SymbolFlags::WeakDefined, XPIAccess::Public);
+  file.addSymbol(XPIKind::ObjectiveCClass, "Class1", archs, SymbolFlags::None,
+                 XPIAccess::Public);
+  file.addSymbol(XPIKind::ObjectiveCClassEHType, "Class1", archs,
+                 SymbolFlags::None, XPIAccess::Public);
+  file.addSymbol(XPIKind::ObjectiveCInstanceVariable, "Class1.ivar1", archs,
+                 SymbolFlags::None, XPIAccess::Public);
+  file.addSymbol(XPIKind::GlobalSymbol, "_private", archs, SymbolFlags::None,
+                 XPIAccess::Private);
+  expectSameAsYAMLWriter(&file);
+
+  file.setFileType(FileType::SPI_V1);
+  expectSameAsYAMLWriter(&file);
+}
+
+/// The emitters of the text stub writer spell out the keys of each format
+/// again. Write all input files of the tests in every TBD format, and for
+/// every architecture, to catch the emitters drifting from the key mappings.
+TEST(TextStubWriter, InputFiles) {
+  std::error_code ec;
+  for (sys::fs::recursive_directory_iterator i(INPUT_PATH "/..", ec), ie;
+       i != ie && !ec; i.increment(ec)) {
+    if (sys::path::extension(i->path()) != ".tbd")
+      continue;
+
+    auto bufferOrErr = MemoryBuffer::getFile(i->path());
+    ASSERT_TRUE(bufferOrErr);
+    SCOPED_TRACE(i->path());
+    auto file = readInterface(bufferOrErr.get()->getBuffer());
+    ASSERT_NE(nullptr, file);
+
+    for (auto arch : file->getArchitectures()) {
+      InterfaceFileView view(*file, arch);
+      expectSameAsYAMLWriter(&view);
+    }
+
+    for (auto type : {FileType::TBD_V1, FileType::TBD_V2, FileType::TBD_V3}) {
+      file->setFileType(type);
+      expectSameAsYAMLWriter(file.get());
+    }
+  }
+  EXPECT_FALSE(ec);
+}
+
+TEST(TextStubWriter, Fallback) {
+  auto file = readInterface(tbd_v2_file);
+  ASSERT_NE(nullptr, file);
+
+  YAMLWriter genericOnly;
+  genericOnly.add(std::unique_ptr<DocumentHandler>(new GenericOnlyHandler));
+  TextStubWriter writer(genericOnly);
+  EXPECT_EQ(writeWith(getYAMLWriter(), file.get()),
+            writeWith(writer, file.get()));
+}
+
+} // end anonymous namespace.
@@ -0,0 +1,331 @@
+//===- unittests/XPISet/XPISet.cpp - XPI Set Tests ------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#include "tapi/Core/ExtendedInterfaceFile.h"
+#include "tapi/Core/InterfaceFile.h"
+#include "tapi/Core/XPISet.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#define DEBUG_TYPE "xpi-set-test"
+
+using namespace llvm;
+using namespace tapi::internal;
+
+namespace {
+
+std::vector<std::pair<XPIKind, std::string>>
+getSymbols(XPISet::const_symbol_range symbols) {
+  std::vector<std::pair<XPIKind, std::string>> result;
+  for (const auto *symbol : symbols)
+    result.emplace_back(symbol->getKind(), symbol->getName().str());
+  return result;
+}
+
+TEST(XPISet, OrderedSymbols) {
+  XPISet xpiSet;
+  xpiSet.addGlobalSymbol("_foo", Architecture::x86_64, SymbolFlags::None,
+                         XPIAccess::Exported);
+  xpiSet.addObjCClass("Bar", Architecture::x86_64, XPIAccess::Exported);
+  xpiSet.addGlobalSymbol("_bar", Architecture::x86_64, SymbolFlags::None,
+                         XPIAccess::Exported);
+
+  std::vector<std::pair<XPIKind, std::string>> expected = {
+      {XPIKind::GlobalSymbol, "_bar"},
+      {XPIKind::GlobalSymbol, "_foo"},
+      {XPIKind::ObjectiveCClass, "Bar"}};
+  EXPECT_EQ(expected, getSymbols(xpiSet.symbols()));
+
+  // Symbols that are added later are merged into the existing order.
+  xpiSet.addGlobalSymbol("_baz", Architecture::x86_64, SymbolFlags::None,
+                         XPIAccess::Exported);
+  xpiSet.addGlobalSymbol("_aaa", Architecture::x86_64, SymbolFlags::None,
+                         XPIAccess::Exported);
+  xpiSet.addGlobalSymbol("_foo", Architecture::arm64, SymbolFlags::None,
+                         XPIAccess::Exported);
+  expected = {{XPIKind::GlobalSymbol, "_aaa"},
+              {XPIKind::GlobalSymbol, "_bar"},
+              {XPIKind::GlobalSymbol, "_baz"},
+              {XPIKind::GlobalSymbol, "_foo"},
+              {XPIKind::ObjectiveCClass, "Bar"}};
+  EXPECT_EQ(expected, getSymbols(xpiSet.symbols()));
+}
+
+TEST(XPISet, OrderedExports) {
+  XPISet xpiSet;
+  xpiSet.addGlobalSymbol("_foo", Architecture::x86_64, SymbolFlags::None,
+                         XPIAccess::Exported);
+  xpiSet.addGlobalSymbol("_bar", Architecture::x86_64, SymbolFlags::None,
+                         XPIAccess::Internal);
+  xpiSet.addGlobalSymbol("_baz", Architecture::x86_64, SymbolFlags::None,
+                         XPIAccess::Exported);
+
+  std::vector<std::string> names;
+  for (const auto *symbol : xpiSet.exports())
+    names.emplace_back(symbol->getName());
+  EXPECT_EQ(std::vector<std::string>({"_baz", "_foo"}), names);
+}
+
+TEST(XPISet, FindWithOutsideNames) {
+  XPISet xpiSet;
+  auto *objcClass =
+      xpiSet.addObjCClass("Foo", Architecture::x86_64, XPIAccess::Exported);
+  xpiSet.addObjCSelector(objcClass, "init", Architecture::x86_64,
+                         /*isInstanceMethod=*/true, /*isDynamic=*/false,
+                         XPIAccess::Exported);
+  xpiSet.addObjCCategory(objcClass, "Extras", Architecture::x86_64,
+                         XPIAccess::Exported);
+
+  std::string className = "Foo";
+  std::string selectorName = "init";
+  EXPECT_EQ(objcClass,
+            xpiSet.findSymbol(XPIKind::ObjectiveCClass, className));
+  EXPECT_EQ(nullptr, xpiSet.findSymbol(XPIKind::GlobalSymbol, className));
+  EXPECT_NE(nullptr, xpiSet.findSelector({className, selectorName,
+                                          /*isInstanceMethod=*/true,
+                                          /*containerIsProtocol=*/false}));
+  EXPECT_EQ(nullptr, xpiSet.findSelector({className, selectorName,
+                                          /*isInstanceMethod=*/false,
+                                          /*containerIsProtocol=*/false}));
+  EXPECT_NE(nullptr, xpiSet.findCategory({className, "Extras"}));
+  EXPECT_EQ(nullptr, xpiSet.findProtocol(className));
+}
+
+TEST(XPISet, PerArchitectureAvailability) {
+  XPISet xpiSet;
+  AvailabilityInfo deprecated(PackedVersion(10, 10, 0),
+                              PackedVersion(10, 12, 0), false);
+  auto *symbol = xpiSet.addGlobalSymbol("_foo", clang::PresumedLoc(),
+                                        XPIAccess::Exported,
+                                        Architecture::x86_64, deprecated);
+  xpiSet.addGlobalSymbol("_foo", clang::PresumedLoc(), XPIAccess::Exported,
+                         Architecture::i386, deprecated);
+  xpiSet.addGlobalSymbol("_foo", clang::PresumedLoc(), XPIAccess::Exported,
+                         Architecture::arm64, AvailabilityInfo(true));
+
+  // Identical availability records are shared between architectures.
+  EXPECT_EQ(2U, symbol->availabilityInfos().size());
+  EXPECT_EQ(deprecated, *symbol->getAvailabilityInfo(Architecture::x86_64));
+  EXPECT_EQ(deprecated, *symbol->getAvailabilityInfo(Architecture::i386));
+  EXPECT_TRUE(symbol->getAvailabilityInfo(Architecture::arm64)->_unavailable);
+  EXPECT_FALSE(symbol->getAvailabilityInfo(Architecture::armv7).hasValue());
+  EXPECT_EQ(ArchitectureSet(Architecture::i386) | Architecture::x86_64,
+            symbol->getArchitectures());
+}
+
+TEST(XPISet, OverwriteAvailability) {
+  XPISet xpiSet;
+  AvailabilityInfo introduced(PackedVersion(10, 10, 0), PackedVersion(),
+                              false);
+  auto *objcClass = xpiSet.addObjCClass("Foo", clang::PresumedLoc(),
+                                        XPIAccess::Exported,
+                                        Architecture::x86_64, introduced);
+  auto *category = xpiSet.addObjCCategory(objcClass, "Extras",
+                                          clang::PresumedLoc(),
+                                          XPIAccess::Exported,
+                                          Architecture::x86_64, introduced);
+  auto *selector = xpiSet.addObjCSelector(
+      objcClass, "init", /*isInstanceMethod=*/true, /*isDynamic=*/false,
+      clang::PresumedLoc(), XPIAccess::Exported, Architecture::x86_64,
+      introduced);
+  xpiSet.addObjCSelector(objcClass, "init", /*isInstanceMethod=*/true,
+                         /*isDynamic=*/false, clang::PresumedLoc(),
+                         XPIAccess::Exported, Architecture::i386, introduced);
+  EXPECT_EQ(1U, selector->availabilityInfos().size());
+
+  // A category overwrites the availability of the class selector. Records
+  // that are no longer referenced are dropped.
+  xpiSet.addObjCSelector(category, "init", /*isInstanceMethod=*/true,
+                         /*isDynamic=*/false, clang::PresumedLoc(),
+                         XPIAccess::Exported, Architecture::x86_64,
+                         AvailabilityInfo());
+  EXPECT_EQ(2U, selector->availabilityInfos().size());
+  EXPECT_TRUE(
+      selector->getAvailabilityInfo(Architecture::x86_64)->isDefault());
+  EXPECT_EQ(introduced, *selector->getAvailabilityInfo(Architecture::i386));
+
+  xpiSet.addObjCSelector(category, "init", /*isInstanceMethod=*/true,
+                         /*isDynamic=*/false, clang::PresumedLoc(),
+                         XPIAccess::Exported, Architecture::i386,
+                         AvailabilityInfo());
+  EXPECT_EQ(1U, selector->availabilityInfos().size());
+  EXPECT_TRUE(selector->getAvailabilityInfo(Architecture::i386)->isDefault());
+}
+
+TEST(XPISet, SharedNames) {
+  auto stringPool = std::make_shared<StringPool>();
+  XPISet headers(stringPool);
+  XPISet dylib(stringPool);
+  auto *declaration =
+      headers.addGlobalSymbol("_foo", clang::PresumedLoc(),
+                              XPIAccess::Public, Architecture::x86_64,
+                              AvailabilityInfo());
+  auto *definition = dylib.addGlobalSymbol("_foo", Architecture::x86_64,
+                                           SymbolFlags::None,
+                                           XPIAccess::Exported);
+
+  // Both sets reference the same pooled copy of the name.
+  EXPECT_EQ(declaration->getName().data(), definition->getName().data());
+  EXPECT_EQ(1U, stringPool->size());
+
+  // Sets that don't share a pool own their names.
+  XPISet other;
+  auto *symbol = other.addGlobalSymbol("_foo", Architecture::x86_64,
+                                       SymbolFlags::None, XPIAccess::Exported);
+  EXPECT_NE(declaration->getName().data(), symbol->getName().data());
+  EXPECT_EQ(1U, stringPool->size());
+}
+
+TEST(XPISet, ConvertToInterfaceFile) {
+  ExtendedInterfaceFile extended;
+  extended.addSymbol(XPIKind::GlobalSymbol, "_foo", Architecture::x86_64);
+  extended.addObjCClass("Foo", Architecture::x86_64);
+  extended.addUndefinedSymbol(XPIKind::GlobalSymbol, "_bar",
+                              Architecture::x86_64);
+  const char *fooName = (*extended.exports().begin())->getName().data();
+  const char *barName = (*extended.undefineds().begin())->getName().data();
+
+  InterfaceFile file(std::move(extended));
+  EXPECT_TRUE(extended.exports().begin() == extended.exports().end());
+  EXPECT_TRUE(extended.undefineds().begin() == extended.undefineds().end());
+
+  std::vector<const Symbol *> exports(file.exports().begin(),
+                                      file.exports().end());
+  std::vector<const Symbol *> undefineds(file.undefineds().begin(),
+                                         file.undefineds().end());
+  ASSERT_EQ(2U, exports.size());
+  ASSERT_EQ(1U, undefineds.size());
+  EXPECT_EQ(SymbolKind::GlobalSymbol, exports[0]->getKind());
+  EXPECT_EQ("_foo", exports[0]->getName());
+  EXPECT_EQ(SymbolKind::ObjectiveCClass, exports[1]->getKind());
+  EXPECT_EQ("Foo", exports[1]->getName());
+
+  // The names are adopted from the XPIs and not copied.
+  EXPECT_EQ(fooName, exports[0]->getName().data());
+  EXPECT_EQ(barName, undefineds[0]->getName().data());
+}
+
+// An extended file whose undefineds don't share the string pool of the file.
+class SeparateUndefinedsFile : public ExtendedInterfaceFile {
+public:
+  SeparateUndefinedsFile() { _undefineds.reset(new XPISet); }
+};
+
+TEST(XPISet, ConvertSeparateUndefinedPool) {
+  SeparateUndefinedsFile extended;
+  extended.addSymbol(XPIKind::GlobalSymbol, "_foo", Architecture::x86_64);
+  extended.addUndefinedSymbol(XPIKind::GlobalSymbol, "_bar",
+                              Architecture::x86_64);
+  const char *fooName = (*extended.exports().begin())->getName().data();
+  const char *barName = (*extended.undefineds().begin())->getName().data();
+
+  InterfaceFile file(std::move(extended));
+  std::vector<const Symbol *> exports(file.exports().begin(),
+                                      file.exports().end());
+  std::vector<const Symbol *> undefineds(file.undefineds().begin(),
+                                         file.undefineds().end());
+  ASSERT_EQ(1U, exports.size());
+  ASSERT_EQ(1U, undefineds.size());
+
+  // Only the names from the pool the file took over are adopted. The others
+  // are copied, because their pool is gone after the conversion.
+  EXPECT_EQ(fooName, exports[0]->getName().data());
+  EXPECT_NE(barName, undefineds[0]->getName().data());
+  EXPECT_EQ("_foo", exports[0]->getName());
+  EXPECT_EQ("_bar", undefineds[0]->getName());
+}
+
+// Parses the same declarations as the header scanner would for one header
+// type and architecture.
+static void addDeclarations(XPISet &xpiSet, XPIAccess access,
+                            Architecture arch) {
+  AvailabilityInfo introduced(PackedVersion(10, 10, 0), PackedVersion(),
+                              false);
+  clang::PresumedLoc loc;
+  xpiSet.addGlobalSymbol("_foo", loc, access, arch, introduced);
+  auto *super = xpiSet.addObjCClass("NSObject", loc, XPIAccess::Unknown, arch,
+                                    AvailabilityInfo());
+  auto *objcClass =
+      xpiSet.addObjCClass("Foo", loc, access, arch, introduced, super);
+  xpiSet.addObjCSelector(objcClass, "init", /*isInstanceMethod=*/true,
+                         /*isDynamic=*/false, loc, access, arch,
+                         access == XPIAccess::Public ? introduced
+                                                     : AvailabilityInfo());
+  if (access == XPIAccess::Public)
+    return;
+
+  auto *category =
+      xpiSet.addObjCCategory(objcClass, "Private", loc, access, arch,
+                             AvailabilityInfo());
+  xpiSet.addObjCSelector(category, "init", /*isInstanceMethod=*/true,
+                         /*isDynamic=*/false, loc, access, arch, introduced);
+  xpiSet.addObjCSelector(category, "bar", /*isInstanceMethod=*/false,
+                         /*isDynamic=*/true, loc, access, arch,
+                         AvailabilityInfo());
+  auto *protocol =
+      xpiSet.addObjCProtocol("FooDelegate", loc, access, arch, introduced);
+  xpiSet.addObjCSelector(protocol, "didFoo", /*isInstanceMethod=*/true,
+                         /*isDynamic=*/false, loc, access, arch,
+                         AvailabilityInfo());
+}
+
+static std::string dump(const XPISet &xpiSet) {
+  std::string result;
+  raw_string_ostream os(result);
+  for (const auto *symbol : xpiSet.symbols()) {
+    os << *symbol << "\n";
+    if (const auto *container = dyn_cast<ObjCContainer>(symbol))
+      for (const auto *selector : container->selectors())
+        os << "  " << *selector << "\n";
+  }
+  for (const auto &it : xpiSet._selectors)
+    os << it.first.containerName << " " << *it.second << "\n";
+  for (const auto &it : xpiSet._categories) {
+    os << *it.second << "\n";
+    for (const auto *selector : it.second->selectors())
+      os << "  " << *selector << "\n";
+  }
+  for (const auto &it : xpiSet._protocols)
+    os << *it.second << "\n";
+  return os.str();
+}
+
+TEST(XPISet, MergeJournaledSets) {
+  const std::pair<XPIAccess, Architecture> jobs[] = {
+      {XPIAccess::Public, Architecture::x86_64},
+      {XPIAccess::Public, Architecture::i386},
+      {XPIAccess::Private, Architecture::x86_64},
+      {XPIAccess::Private, Architecture::i386}};
+
+  XPISet serial;
+  for (const auto &job : jobs)
+    addDeclarations(serial, job.first, job.second);
+
+  std::vector<std::unique_ptr<XPISet>> localSets;
+  for (const auto &job : jobs) {
+    localSets.emplace_back(new XPISet(/*isJournaled=*/true));
+    addDeclarations(*localSets.back(), job.first, job.second);
+  }
+
+  XPISet merged;
+  for (const auto &localSet : localSets)
+    merged.merge(*localSet);
+
+  EXPECT_EQ(dump(serial), dump(merged));
+
+  const auto *selector = merged.findSelector(
+      {"Foo", "init", /*isInstanceMethod=*/true,
+       /*containerIsProtocol=*/false});
+  ASSERT_NE(nullptr, selector);
+  EXPECT_EQ(XPIAccess::Public, selector->getAccess());
+  EXPECT_EQ(serial.findSelector({"Foo", "init", /*isInstanceMethod=*/true,
+                                 /*containerIsProtocol=*/false})
+                ->availabilityInfos(),
+            selector->availabilityInfos());
+}
+
+} // end anonymous namespace.
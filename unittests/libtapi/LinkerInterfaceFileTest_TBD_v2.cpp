@@ -8,8 +8,10 @@
 //===----------------------------------------------------------------------===//
 #include "tapi/Core/ArchitectureConfig.h"
 #include "gtest/gtest.h"
+#include <cstring>
 #include <mach/machine.h>
 #include <tapi/tapi.h>
+#include <thread>
 
 using namespace tapi;
 
@@ -440,6 +442,25 @@ TEST(libtapiTBDv2, LIF_isSupported) {
   EXPECT_FALSE(isSupported2);
 }
 
+TEST(libtapiTBDv2, LIF_isSupported_DocumentMarkers) {
+  auto isSupported = [](llvm::StringRef buffer) {
+    return LinkerInterfaceFile::isSupported(
+        "Test.tbd", reinterpret_cast<const uint8_t *>(buffer.data()),
+        buffer.size());
+  };
+
+  EXPECT_TRUE(isSupported("---\narchs: [ i386 ]\n...\n"));
+  EXPECT_TRUE(isSupported("--- !tapi-tbd-v1\narchs: [ i386 ]\n...\n"));
+  EXPECT_TRUE(isSupported("--- !tapi-tbd-v2\narchs: [ i386 ]\n...\n"));
+  EXPECT_TRUE(isSupported("\n--- !tapi-tbd-v2\narchs: [ i386 ]\n...\n\n"));
+  EXPECT_FALSE(isSupported("--- !tapi-tbd-v3\narchs: [ i386 ]\n...\n"));
+  EXPECT_FALSE(isSupported(""));
+  EXPECT_FALSE(isSupported("..."));
+  EXPECT_FALSE(isSupported("--- !tapi-tbd-v2\narchs: [ i386 ]\n"));
+  EXPECT_FALSE(isSupported("--- !tapi-tbd-v4\narchs: [ i386 ]\n...\n"));
+  EXPECT_FALSE(isSupported("--- !tapi-api-v1\narchs: [ i386 ]\n...\n"));
+}
+
 TEST(libtapiTBDv2, LIF_shouldPreferTextBasedStubFile) {
   EXPECT_TRUE(LinkerInterfaceFile::shouldPreferTextBasedStubFile(
       INPUT_PATH "/installapi.tbd"));
@@ -491,6 +512,54 @@ TEST(libtapiTBDv2, LIF_Load_ARM) {
       std::equal(exports.begin(), exports.end(), tbd_v2_arm_exports.begin()));
 }
 
+// Test that the buffer doesn't need to be null-terminated and is parsed in
+// place.
+TEST(libtapiTBDv2, LIF_Load_NotNullTerminated) {
+  // Follow the file content with garbage instead of a null-terminator.
+  std::string buffer(tbd_v2_file);
+  auto size = buffer.size();
+  buffer.append("garbage");
+  std::string errorMessage;
+  auto numAvoidedCopies = LinkerInterfaceFile::getNumAvoidedBufferCopies();
+  auto file = std::unique_ptr<LinkerInterfaceFile>(LinkerInterfaceFile::create(
+      "Test.tbd", reinterpret_cast<const uint8_t *>(buffer.data()), size,
+      CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7, CpuSubTypeMatching::ABI_Compatible,
+      PackedVersion32(9, 0, 0), errorMessage));
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(numAvoidedCopies + 1,
+            LinkerInterfaceFile::getNumAvoidedBufferCopies());
+  EXPECT_EQ(std::string("Test.dylib"), file->getInstallName());
+}
+
+// Test that a buffer that isn't null-terminated can still be read by the
+// generic YAML reader, which works on a copy.
+TEST(libtapiTBDv2, LIF_Load_NotNullTerminated_Fallback) {
+  // The escape sequence is only understood by the generic YAML reader.
+  std::string buffer = "--- !tapi-tbd-v2\n"
+                       "archs: [ armv7 ]\n"
+                       "platform: ios\n"
+                       "install-name: \"Te\\x73t.dylib\"\n"
+                       "exports:\n"
+                       "  - archs: [ armv7 ]\n"
+                       "    symbols: [ _sym1 ]\n"
+                       "...\n";
+  auto size = buffer.size();
+  buffer.append("garbage");
+  std::string errorMessage;
+  auto numAvoidedCopies = LinkerInterfaceFile::getNumAvoidedBufferCopies();
+  auto file = std::unique_ptr<LinkerInterfaceFile>(LinkerInterfaceFile::create(
+      "Test.tbd", reinterpret_cast<const uint8_t *>(buffer.data()), size,
+      CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7, CpuSubTypeMatching::ABI_Compatible,
+      PackedVersion32(9, 0, 0), errorMessage));
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(numAvoidedCopies,
+            LinkerInterfaceFile::getNumAvoidedBufferCopies());
+  EXPECT_EQ(std::string("Test.dylib"), file->getInstallName());
+  ASSERT_EQ(1U, file->exports().size());
+}
+
 TEST(libtapiTBDv2, LIF_Load_ARM64) {
   llvm::StringRef buffer(tbd_v2_file);
   std::string errorMessage;
@@ -564,6 +633,200 @@ TEST(libtapiTBDv2, LIF_Load_flat) {
                          tbd_v2_arm_undefineds.begin()));
 }
 
+static ExportedSymbolSeq getExports(const LinkerInterfaceFile &file) {
+  ExportedSymbolSeq exports;
+  for (const auto &sym : file.exports())
+    exports.emplace_back(sym.getName(), sym.isWeakDefined(),
+                         sym.isThreadLocalValue());
+  std::sort(exports.begin(), exports.end());
+  return exports;
+}
+
+// Test the allocation-free symbol references.
+TEST(libtapiTBDv2, LIF_Load_SymbolRefs) {
+  llvm::StringRef buffer(tbd_v2_file2);
+  std::string errorMessage;
+  auto file = std::unique_ptr<LinkerInterfaceFile>(LinkerInterfaceFile::create(
+      "Test.tbd", reinterpret_cast<const uint8_t *>(buffer.data()),
+      buffer.size(), CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7,
+      CpuSubTypeMatching::ABI_Compatible, PackedVersion32(9, 0, 0),
+      errorMessage));
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_NE(nullptr, file);
+
+  ExportedSymbolSeq exports;
+  file->forEachExport([&](const SymbolRef &sym) {
+    EXPECT_EQ(std::strlen(sym.getName()), sym.getNameLength());
+    exports.emplace_back(sym.getName(), sym.isWeakDefined(),
+                         sym.isThreadLocalValue());
+  });
+  std::sort(exports.begin(), exports.end());
+
+  UndefinedSymbolSeq undefineds;
+  file->forEachUndefined([&](const SymbolRef &sym) {
+    undefineds.emplace_back(sym.getName(), sym.isWeakReferenced());
+  });
+  std::sort(undefineds.begin(), undefineds.end());
+
+  EXPECT_EQ(tbd_v2_arm_exports, exports);
+  EXPECT_EQ(tbd_v2_arm_undefineds, undefineds);
+
+  // The compatibility API provides the same symbols in the same order.
+  auto refs = file->exportRefs();
+  ASSERT_EQ(refs.size(), file->exports().size());
+  for (size_t i = 0; i < refs.size(); ++i) {
+    EXPECT_EQ(refs.begin()[i].getName(), file->exports()[i].getName());
+    EXPECT_EQ(refs.begin()[i].getFlags(), file->exports()[i].getFlags());
+  }
+  ASSERT_EQ(file->undefinedRefs().size(), file->undefineds().size());
+}
+
+// Test creating multiple slices from a single parse.
+TEST(libtapiTBDv2, LIF_Load_MultipleArchitectures) {
+  llvm::StringRef buffer(tbd_v2_file);
+  std::string errorMessage;
+  auto files = LinkerInterfaceFile::createForArchitectures(
+      "Test.tbd", reinterpret_cast<const uint8_t *>(buffer.data()),
+      buffer.size(),
+      {{CPU_TYPE_ARM64, CPU_SUBTYPE_ARM64_ALL},
+       {CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7}},
+      ParsingFlags::None, PackedVersion32(9, 0, 0), errorMessage);
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_EQ(2U, files.size());
+
+  EXPECT_EQ(std::string("Test.dylib"), files[0]->getInstallName());
+  EXPECT_EQ(std::vector<std::string>({"Foo.dylib"}),
+            files[0]->allowableClients());
+  EXPECT_EQ(tbd_v2_arm64_exports, getExports(*files[0]));
+
+  EXPECT_EQ(std::string("Test.dylib"), files[1]->getInstallName());
+  EXPECT_EQ(std::vector<std::string>({"Bar.dylib", "Foo.dylib"}),
+            files[1]->allowableClients());
+  EXPECT_EQ(tbd_v2_arm_exports, getExports(*files[1]));
+
+  // Both slices share the storage for the common symbol names.
+  auto arm64Refs = files[0]->exportRefs();
+  auto armRefs = files[1]->exportRefs();
+  for (const auto &ref : arm64Refs)
+    EXPECT_TRUE(std::any_of(armRefs.begin(), armRefs.end(),
+                            [&](const SymbolRef &other) {
+                              return other.getName() == ref.getName();
+                            }));
+
+  // Fail if any of the requested architectures is missing.
+  files = LinkerInterfaceFile::createForArchitectures(
+      "Test.tbd", reinterpret_cast<const uint8_t *>(buffer.data()),
+      buffer.size(),
+      {{CPU_TYPE_ARM64, CPU_SUBTYPE_ARM64_ALL},
+       {CPU_TYPE_X86_64, CPU_SUBTYPE_X86_64_ALL}},
+      ParsingFlags::None, PackedVersion32(9, 0, 0), errorMessage);
+  EXPECT_TRUE(files.empty());
+  EXPECT_EQ("missing required architecture x86_64 in file Test.tbd (4 slices)",
+            errorMessage);
+}
+
+static const char tbd_v2_linker_directives[] =
+    "--- !tapi-tbd-v2\n"
+    "archs: [ armv7, arm64 ]\n"
+    "platform: ios\n"
+    "install-name: Test.dylib\n"
+    "compatibility-version: 2.0\n"
+    "exports:\n"
+    "  - archs: [ armv7, arm64 ]\n"
+    "    symbols: [ '$ld$add$os9.0$_added',\n"
+    "               '$ld$compatibility_version$os9.0$1.2.3',\n"
+    "               '$ld$hide$os10.0$_sym2', '$ld$hide$os9.0$_sym1',\n"
+    "               '$ld$unknown$os9.0$_sym2', _sym1, _sym2 ]\n"
+    "  - archs: [ arm64 ]\n"
+    "    symbols: [ '$ld$hide$os9.0$_sym2' ]\n"
+    "...\n";
+
+static std::vector<std::string>
+getExportNames(const LinkerInterfaceFile &file) {
+  std::vector<std::string> names;
+  for (const auto &sym : file.exportRefs())
+    names.emplace_back(sym.getName());
+  return names;
+}
+
+// Test that $ld$ directives are only applied for the matching deployment
+// target and architecture.
+TEST(libtapiTBDv2, LIF_Load_LinkerDirectives) {
+  llvm::StringRef buffer(tbd_v2_linker_directives);
+  std::string errorMessage;
+  auto files = LinkerInterfaceFile::createForArchitectures(
+      "Test.tbd", reinterpret_cast<const uint8_t *>(buffer.data()),
+      buffer.size(),
+      {{CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7},
+       {CPU_TYPE_ARM64, CPU_SUBTYPE_ARM64_ALL}},
+      ParsingFlags::None, PackedVersion32(9, 0, 1), errorMessage);
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_EQ(2U, files.size());
+
+  EXPECT_EQ(0x10203U, files[0]->getCompatibilityVersion());
+  EXPECT_EQ(std::vector<std::string>({"_sym1"}), files[0]->ignoreExports());
+  EXPECT_EQ(std::vector<std::string>({"_added", "_sym2"}),
+            getExportNames(*files[0]));
+
+  EXPECT_EQ(0x10203U, files[1]->getCompatibilityVersion());
+  EXPECT_EQ(std::vector<std::string>({"_sym1", "_sym2"}),
+            files[1]->ignoreExports());
+  EXPECT_EQ(std::vector<std::string>({"_added"}), getExportNames(*files[1]));
+
+  files = LinkerInterfaceFile::createForArchitectures(
+      "Test.tbd", reinterpret_cast<const uint8_t *>(buffer.data()),
+      buffer.size(), {{CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7}}, ParsingFlags::None,
+      PackedVersion32(10, 0, 0), errorMessage);
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_EQ(1U, files.size());
+  EXPECT_EQ(0x20000U, files[0]->getCompatibilityVersion());
+  EXPECT_EQ(std::vector<std::string>({"_sym1"}), getExportNames(*files[0]));
+}
+
+// Test parsing several buffers concurrently.
+TEST(libtapiTBDv2, LIF_Load_Batch) {
+  llvm::StringRef buffer(tbd_v2_file);
+  llvm::StringRef buffer2(tbd_v2_file2);
+  llvm::StringRef malformed("--- !tapi-tbd-v2\nfoobar: 1\n...\n");
+  std::vector<InputBuffer> inputs;
+  for (unsigned i = 0; i < 16; ++i) {
+    auto &input = (i % 2) ? buffer2 : buffer;
+    inputs.push_back({"Test" + std::to_string(i) + ".tbd",
+                      reinterpret_cast<const uint8_t *>(input.data()),
+                      input.size()});
+  }
+  inputs.push_back({"Malformed.tbd",
+                    reinterpret_cast<const uint8_t *>(malformed.data()),
+                    malformed.size()});
+
+  auto check = [&](unsigned numThreads) {
+    std::vector<std::string> errorMessages;
+    auto files = LinkerInterfaceFile::createBatch(
+        inputs, CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7, ParsingFlags::None,
+        PackedVersion32(9, 0, 0), errorMessages, numThreads);
+    ASSERT_EQ(inputs.size(), files.size());
+    ASSERT_EQ(inputs.size(), errorMessages.size());
+    for (unsigned i = 0; i < 16; ++i) {
+      EXPECT_TRUE(errorMessages[i].empty());
+      ASSERT_NE(nullptr, files[i]);
+      EXPECT_EQ(i % 2 == 0, files[i]->hasTwoLevelNamespace());
+      EXPECT_EQ(tbd_v2_arm_exports, getExports(*files[i]));
+    }
+    EXPECT_EQ(nullptr, files.back());
+    EXPECT_EQ(0U, errorMessages.back().find("malformed file\nMalformed.tbd"));
+  };
+
+  check(1);
+  check(4);
+
+  // Batches may be created from multiple threads at the same time.
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < 4; ++i)
+    threads.emplace_back(check, 2);
+  for (auto &thread : threads)
+    thread.join();
+}
+
 TEST(libtapiTBDv2, LIF_Load_Install_Name) {
   llvm::StringRef buffer(tbd_v2_file3);
   std::string errorMessage;
@@ -1240,5 +1503,98 @@ TEST(libtapiTBDv2, LIF_Load_unknown_arch) {
   EXPECT_EQ("_sym1", file->exports().front().getName());
 }
 
+// Test that repeated creates for the same file are served from the cache.
+TEST(libtapiTBDv2, LIF_Cache) {
+  LinkerInterfaceFile::setCacheCapacity(1024 * 1024);
+  auto numHits = LinkerInterfaceFile::getNumCacheHits();
+  auto numMisses = LinkerInterfaceFile::getNumCacheMisses();
+
+  // The cache must not reference the caller provided buffer.
+  std::string buffer(tbd_v2_file);
+  std::string errorMessage;
+  auto file = std::unique_ptr<LinkerInterfaceFile>(LinkerInterfaceFile::create(
+      "Cache.tbd", reinterpret_cast<const uint8_t *>(buffer.data()),
+      buffer.size(), CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7,
+      CpuSubTypeMatching::ABI_Compatible, PackedVersion32(9, 0, 0),
+      errorMessage));
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(numHits, LinkerInterfaceFile::getNumCacheHits());
+  EXPECT_EQ(numMisses + 1, LinkerInterfaceFile::getNumCacheMisses());
+  EXPECT_EQ(tbd_v2_arm_exports, getExports(*file));
+
+  std::string buffer2(buffer);
+  std::fill(buffer.begin(), buffer.end(), 'x');
+  file.reset(LinkerInterfaceFile::create(
+      "Cache.tbd", reinterpret_cast<const uint8_t *>(buffer2.data()),
+      buffer2.size(), CPU_TYPE_ARM64, CPU_SUBTYPE_ARM64_ALL,
+      CpuSubTypeMatching::ABI_Compatible, PackedVersion32(9, 0, 0),
+      errorMessage));
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(numHits + 1, LinkerInterfaceFile::getNumCacheHits());
+  EXPECT_EQ(numMisses + 1, LinkerInterfaceFile::getNumCacheMisses());
+  EXPECT_EQ(std::string("Test.dylib"), file->getInstallName());
+  EXPECT_EQ(tbd_v2_arm64_exports, getExports(*file));
+
+  // A modified file must be parsed again.
+  llvm::StringRef buffer3(tbd_v2_file2);
+  file.reset(LinkerInterfaceFile::create(
+      "Cache.tbd", reinterpret_cast<const uint8_t *>(buffer3.data()),
+      buffer3.size(), CPU_TYPE_ARM64, CPU_SUBTYPE_ARM64_ALL,
+      CpuSubTypeMatching::ABI_Compatible, PackedVersion32(9, 0, 0),
+      errorMessage));
+  ASSERT_TRUE(errorMessage.empty());
+  ASSERT_NE(nullptr, file);
+  EXPECT_EQ(numHits + 1, LinkerInterfaceFile::getNumCacheHits());
+  EXPECT_EQ(numMisses + 2, LinkerInterfaceFile::getNumCacheMisses());
+  EXPECT_FALSE(file->hasTwoLevelNamespace());
+
+  LinkerInterfaceFile::setCacheCapacity(0);
+}
+
+// Test that the cache evicts files once the capacity is exceeded.
+TEST(libtapiTBDv2, LIF_Cache_Eviction) {
+  llvm::StringRef buffer(tbd_v2_file);
+  LinkerInterfaceFile::setCacheCapacity(buffer.size());
+  EXPECT_EQ(buffer.size(), LinkerInterfaceFile::getCacheCapacity());
+  auto numHits = LinkerInterfaceFile::getNumCacheHits();
+  auto numEvictions = LinkerInterfaceFile::getNumCacheEvictions();
+
+  auto create = [&](const std::string &path) {
+    std::string errorMessage;
+    auto file =
+        std::unique_ptr<LinkerInterfaceFile>(LinkerInterfaceFile::create(
+            path, reinterpret_cast<const uint8_t *>(buffer.data()),
+            buffer.size(), CPU_TYPE_ARM, CPU_SUBTYPE_ARM_V7,
+            CpuSubTypeMatching::ABI_Compatible, PackedVersion32(9, 0, 0),
+            errorMessage));
+    EXPECT_TRUE(errorMessage.empty());
+    EXPECT_NE(nullptr, file);
+  };
+
+  create("A.tbd");
+  create("B.tbd");
+  EXPECT_EQ(numEvictions + 1, LinkerInterfaceFile::getNumCacheEvictions());
+  EXPECT_EQ(buffer.size(), LinkerInterfaceFile::getCacheSize());
+  create("B.tbd");
+  EXPECT_EQ(numHits + 1, LinkerInterfaceFile::getNumCacheHits());
+  create("A.tbd");
+  EXPECT_EQ(numHits + 1, LinkerInterfaceFile::getNumCacheHits());
+  EXPECT_EQ(numEvictions + 2, LinkerInterfaceFile::getNumCacheEvictions());
+
+  LinkerInterfaceFile::evictFromCache("A.tbd");
+  EXPECT_EQ(numEvictions + 3, LinkerInterfaceFile::getNumCacheEvictions());
+  EXPECT_EQ(0U, LinkerInterfaceFile::getCacheSize());
+  create("A.tbd");
+  EXPECT_EQ(numHits + 1, LinkerInterfaceFile::getNumCacheHits());
+
+  LinkerInterfaceFile::clearCache();
+  EXPECT_EQ(numEvictions + 4, LinkerInterfaceFile::getNumCacheEvictions());
+  EXPECT_EQ(0U, LinkerInterfaceFile::getCacheSize());
+  LinkerInterfaceFile::setCacheCapacity(0);
+  create("A.tbd");
+  EXPECT_EQ(numHits + 1, LinkerInterfaceFile::getNumCacheHits());
+}
 
 } // end namespace TBDv2